@@ -1,21 +1,59 @@
 // BLADE Web Interface JavaScript
 
+// Content-defined chunking of the server's chunk store (announce reply "dedup": 1). Files must be cut
+// exactly as the server cuts them: FastCDC over a 32-bit gear hash, chunks keyed by SHA-256.
+const DEDUP_MIN_CHUNK = 256 * 1024;
+const DEDUP_AVG_CHUNK = 1024 * 1024;
+const DEDUP_MAX_CHUNK = 4 * 1024 * 1024;
+const DEDUP_MASK_SMALL = 0xFFFFFC00 | 0; // Stricter cut condition below the average size
+const DEDUP_MASK_LARGE = 0xFFFFC000 | 0; // Looser one above it
+
+// Delta uploads against the saved file (see DeltaPatcher.h): the server's signature lists a weak rolling
+// checksum and 16 bytes of SHA-256 per block; the file is sent as COPY and DATA operations.
+const DELTA_OP_COPY = 0x01;
+const DELTA_OP_DATA = 0x02;
+const DELTA_MAX_LITERAL = 1024 * 1024 * 1024; // DATA operations carry a u32 length
+const DELTA_FILTER_BITS = 20; // Weak checksums the signature may contain, before the exact lookup
+
+const SHA256_K = new Int32Array([
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+]);
+
 class BladeApp {
     constructor() {
         this.authenticated = false;
         this.authConfig = null;
+        this.authToken = null; // Sent with API calls once logged in; checked when auth is enabled
         this.sessionStartTime = null;
         this.sessionTimer = null;
         this.selectedFiles = []; // Store selected files persistently
-        this.heartbeatInterval = null;
+        this.controlSocket = null; // WebSocket on /api/ws: server events plus control requests
+        this.controlRequests = new Map(); // Request id -> resolve function awaiting the reply
+        this.nextControlId = 1;
+        this.eventSource = null; // Server-Sent Events from /api/events, used when WebSocket is unavailable
+        this.eventWatchdog = null;
+        this.eventErrorTimer = null;
         this.reconnectInterval = null;
-        this.pendingFilesInterval = null;
-        this.downloadedFiles = new Set(); // Track already downloaded files using name+size as key
-        this.receivedFileElements = new Map(); // Track DOM elements by name+size to prevent duplicates
+        this.queuedPendingFiles = null; // Latest queue received while a download was running
+        this.downloadedFiles = new Set(); // Track already downloaded files using transfer id+size as key
+        this.receivedFileElements = new Map(); // Track DOM elements by transfer id+size to prevent duplicates
         this.isDownloading = false; // Flag to prevent concurrent download checks
         this.isReconnecting = false;
-        this.heartbeatFailCount = 0;
-        this.maxHeartbeatFails = 3; // Increase to 3 to avoid false disconnections
+        this.uploadStreams = 4; // Parallel connections per uploaded file
+        this.dedupMinSize = 1024 * 1024; // Smaller files are sent without offering their chunk list first
+        this.dedupProbeSize = 64 * 1024 * 1024; // Larger files are probed before being hashed in full
+        this.chunkListBatch = 8192; // Chunk hashes per request (~600 KB)
+        this.eventSilenceLimit = 25000; // The server pings every 10 seconds
+        this.eventErrorGrace = 5000; // Time EventSource gets to reconnect on its own
+        this.controlTimeout = 5000; // Control requests fall back to plain HTTP after this long
+        this.archiveThreshold = 5; // Batches of this many files arrive as one ZIP download
         this.init();
     }
 
@@ -67,53 +105,182 @@ class BladeApp {
         localStorage.removeItem('bladeSession');
     }
 
-    startHeartbeat() {
-        // Clear any existing heartbeat
-        if (this.heartbeatInterval) {
-            clearInterval(this.heartbeatInterval);
+    authHeaders(headers = {}) {
+        return this.authToken ? { ...headers, 'X-Blade-Auth': this.authToken } : headers;
+    }
+
+    startEventStream() {
+        this.stopEventStream();
+
+        if ('WebSocket' in window) {
+            this.openControlSocket();
+        } else {
+            this.openEventSource();
         }
+    }
 
-        this.heartbeatFailCount = 0;
+    // Neither WebSocket nor EventSource can send headers, so the credential goes in the query string
+    authQuery() {
+        return this.authToken ? '?auth=' + encodeURIComponent(this.authToken) : '';
+    }
 
-        // Check server connection every 3 seconds (increased from 2)
-        this.heartbeatInterval = setInterval(async () => {
-            try {
-                const controller = new AbortController();
-                const timeoutId = setTimeout(() => controller.abort(), 3000); // Increased timeout
+    openControlSocket() {
+        const scheme = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
+        const socket = new WebSocket(`${scheme}//${window.location.host}/api/ws${this.authQuery()}`);
+        this.controlSocket = socket;
+        let opened = false;
+
+        socket.onopen = () => {
+            opened = true;
+            this.resetEventWatchdog();
+            if (this.isReconnecting) {
+                this.handleReconnection();
+            }
+        };
+
+        socket.onmessage = (e) => {
+            const message = JSON.parse(e.data);
+            if (message.event === 'reply') {
+                this.resetEventWatchdog();
+                const resolve = this.controlRequests.get(message.id);
+                if (resolve) {
+                    this.controlRequests.delete(message.id);
+                    resolve(message.data);
+                }
+            } else {
+                this.handleServerEvent(message.event, message.data);
+            }
+        };
 
-                const response = await fetch('/api/heartbeat?t=' + Date.now(), {
-                    method: 'GET',
-                    headers: {
-                        'Cache-Control': 'no-cache'
-                    },
-                    signal: controller.signal
-                });
+        socket.onclose = () => {
+            if (this.controlSocket !== socket) {
+                return; // Closed on purpose by stopEventStream()
+            }
+            this.controlSocket = null;
+            this.failControlRequests();
 
-                clearTimeout(timeoutId);
+            if (!opened) {
+                // Upgrade refused (e.g. by a proxy): receive events over Server-Sent Events instead
+                console.log('WebSocket unavailable, falling back to EventSource');
+                this.openEventSource();
+            } else {
+                this.handleDisconnection();
+            }
+        };
+    }
 
-                if (response.ok) {
-                    this.heartbeatFailCount = 0;
-                    if (this.isReconnecting) {
-                        // Server is back online
-                        this.handleReconnection();
+    openEventSource() {
+        const source = new EventSource('/api/events' + this.authQuery());
+        this.eventSource = source;
+
+        source.onopen = () => {
+            this.clearEventErrorTimer();
+            this.resetEventWatchdog();
+            if (this.isReconnecting) {
+                this.handleReconnection();
+            }
+        };
+
+        source.onerror = () => {
+            if (source.readyState === EventSource.CLOSED) {
+                // Refused (e.g. 401) - EventSource won't retry by itself
+                this.handleDisconnection();
+            } else if (!this.eventErrorTimer) {
+                // EventSource is retrying; only give up if that takes too long
+                this.eventErrorTimer = setTimeout(() => {
+                    this.eventErrorTimer = null;
+                    if (source.readyState !== EventSource.OPEN) {
+                        this.handleDisconnection();
                     }
-                } else {
-                    this.handleHeartbeatFailure();
-                }
-            } catch (error) {
-                this.handleHeartbeatFailure();
+                }, this.eventErrorGrace);
             }
-        }, 3000); // Increased from 2000
+        };
+
+        for (const name of ['queue', 'devices', 'progress', 'ping']) {
+            source.addEventListener(name, (e) => this.handleServerEvent(name, JSON.parse(e.data)));
+        }
+    }
+
+    handleServerEvent(name, data) {
+        this.resetEventWatchdog();
+
+        if (name === 'queue') {
+            this.handlePendingFiles(data.files || []);
+        } else if (name === 'devices') {
+            this.renderConnectedDevices(data.devices || []);
+        } else if (name === 'progress') {
+            console.log(`Server ${data.direction} progress: ${data.name} ${data.percent}%`);
+        }
+    }
+
+    // Sends a control message over the WebSocket; resolves with the reply data,
+    // or null if there is no socket or no reply in time (callers then use HTTP)
+    controlRequest(message) {
+        const socket = this.controlSocket;
+        if (!socket || socket.readyState !== WebSocket.OPEN) {
+            return Promise.resolve(null);
+        }
+
+        const id = this.nextControlId++;
+        return new Promise((resolve) => {
+            const timer = setTimeout(() => {
+                this.controlRequests.delete(id);
+                resolve(null);
+            }, this.controlTimeout);
+
+            this.controlRequests.set(id, (data) => {
+                clearTimeout(timer);
+                resolve(data);
+            });
+            socket.send(JSON.stringify({ ...message, id }));
+        });
     }
 
-    handleHeartbeatFailure() {
-        this.heartbeatFailCount++;
+    failControlRequests() {
+        for (const resolve of this.controlRequests.values()) {
+            resolve(null);
+        }
+        this.controlRequests.clear();
+    }
 
-        // After 3 consecutive failures, consider disconnected (increased from 2)
-        if (this.heartbeatFailCount >= this.maxHeartbeatFails && !this.isReconnecting) {
-            console.log('Server disconnected after', this.heartbeatFailCount, 'failed heartbeats');
-            this.handleDisconnection();
+    stopEventStream() {
+        if (this.controlSocket) {
+            const socket = this.controlSocket;
+            this.controlSocket = null;
+            socket.close();
+            this.failControlRequests();
+        }
+        if (this.eventSource) {
+            this.eventSource.close();
+            this.eventSource = null;
         }
+        if (this.eventWatchdog) {
+            clearTimeout(this.eventWatchdog);
+            this.eventWatchdog = null;
+        }
+        this.clearEventErrorTimer();
+    }
+
+    clearEventErrorTimer() {
+        if (this.eventErrorTimer) {
+            clearTimeout(this.eventErrorTimer);
+            this.eventErrorTimer = null;
+        }
+    }
+
+    resetEventWatchdog() {
+        if (this.eventWatchdog) {
+            clearTimeout(this.eventWatchdog);
+        }
+
+        // A connection that stays silent past several pings is dead even if the socket looks open
+        this.eventWatchdog = setTimeout(() => {
+            this.eventWatchdog = null;
+            if (!this.isReconnecting) {
+                console.log('No events from server for', this.eventSilenceLimit, 'ms');
+                this.handleDisconnection();
+            }
+        }, this.eventSilenceLimit);
     }
 
     handleDisconnection() {
@@ -123,17 +290,8 @@ class BladeApp {
 
         // No notification - silent reconnection attempt
 
-        // Stop heartbeat during reconnection
-        if (this.heartbeatInterval) {
-            clearInterval(this.heartbeatInterval);
-            this.heartbeatInterval = null;
-        }
-
-        // Stop pending files polling during disconnection
-        if (this.pendingFilesInterval) {
-            clearInterval(this.pendingFilesInterval);
-            this.pendingFilesInterval = null;
-        }
+        // Stop the event stream during reconnection; it is reopened once the server answers
+        this.stopEventStream();
 
         // Start reconnection attempts
         this.attemptReconnection();
@@ -174,7 +332,6 @@ class BladeApp {
     handleReconnection() {
         console.log('Server reconnected!');
         this.isReconnecting = false;
-        this.heartbeatFailCount = 0;
 
         // Clear reconnection interval
         if (this.reconnectInterval) {
@@ -196,8 +353,10 @@ class BladeApp {
                 }
             }
 
-            // Restart heartbeat
-            this.startHeartbeat();
+            // Reopen the event stream (after a login, handleLogin opens it)
+            if (this.authenticated) {
+                this.startEventStream();
+            }
         });
     }
 
@@ -241,7 +400,7 @@ class BladeApp {
                 this.updateStatus('connected');
                 this.loadServerInfo();
                 this.showDashboard();
-                this.startHeartbeat(); // Start monitoring connection
+                this.startEventStream(); // Pushes queue/device updates and monitors the connection
             } else {
                 // Authentication is enabled - always show login page
                 // Clear any stale sessions when auth is required
@@ -322,29 +481,32 @@ class BladeApp {
         }
     }
 
-    handleLogin() {
+    async handleLogin() {
         const password = document.getElementById('password').value;
 
-        console.log('=== LOGIN ATTEMPT ===');
-        console.log('Entered password:', password);
-        console.log('Expected password:', this.authConfig?.password);
-        console.log('Auth enabled:', this.authConfig?.authEnabled);
-
-        // Check against server-provided credentials
+        // The server checks the password; it is never sent to the browser
         if (this.authConfig && this.authConfig.authEnabled) {
-            // Exact string comparison
-            const passwordMatch = password === this.authConfig.password;
-
-            console.log('Password match:', passwordMatch);
+            let passwordMatch = false;
+            try {
+                const response = await fetch('/api/login', {
+                    method: 'POST',
+                    headers: { 'Content-Type': 'text/plain' },
+                    body: password
+                });
+                passwordMatch = response.ok;
+            } catch (e) {
+                console.error('Login request failed:', e);
+            }
 
             if (passwordMatch) {
                 console.log('Login successful!');
                 this.authenticated = true;
+                this.authToken = password;
                 this.updateStatus('connected');
                 this.loadServerInfo();
                 this.showDashboard();
                 this.saveSessionState(); // Save session after successful login
-                this.startHeartbeat(); // Start monitoring connection
+                this.startEventStream(); // Pushes queue/device updates and monitors the connection
             } else {
                 console.log('Login failed - Invalid credentials');
                 this.showNotification('Invalid credentials', 'error');
@@ -372,76 +534,109 @@ class BladeApp {
         if (!this.sessionTimer) {
             this.startSessionTimer();
         }
-
-        // Start polling for pending files from server
-        this.startPendingFilesPolling();
     }
 
-    startPendingFilesPolling() {
-        // Clear any existing interval
-        if (this.pendingFilesInterval) {
-            clearInterval(this.pendingFilesInterval);
+    // Called with the server's pending-file queue whenever it changes ("queue" events)
+    async handlePendingFiles(files) {
+        // Keep the latest queue while downloading; it is handled once the download finishes
+        if (this.isDownloading) {
+            this.queuedPendingFiles = files;
+            return;
         }
 
-        // Poll every 2 seconds
-        this.pendingFilesInterval = setInterval(() => {
-            this.checkPendingFiles();
-        }, 2000);
+        // Filter out already downloaded files; the size changes if a queued file is rewritten
+        const newEntries = files.filter(file => {
+            const fileKey = this.pendingFileKey(file);
+            return !this.downloadedFiles.has(fileKey);
+        });
 
-        // Also check immediately
-        this.checkPendingFiles();
-    }
+        // Folders arrive as tar streams that the browser saves as they come
+        for (const folder of newEntries.filter(file => file.folder)) {
+            this.downloadFolder(folder);
+        }
+        const newFiles = newEntries.filter(file => !file.folder);
 
-    async checkPendingFiles() {
-        // Skip if already downloading
-        if (this.isDownloading) {
+        if (newFiles.length === 0) {
+            return;
+        }
+
+        // One streamed archive instead of a request (and a save prompt) per file
+        if (newFiles.length >= this.archiveThreshold) {
+            this.downloadArchive(newFiles);
+            return;
+        }
+
+        // Detect iOS Safari
+        const isIOS = /iPad|iPhone|iPod/.test(navigator.userAgent) && !window.MSStream;
+
+        if (isIOS && newFiles.length > 1) {
+            // On iOS with multiple files, show download buttons instead of auto-download
+            this.showPendingFilesForManualDownload(newFiles);
             return;
         }
 
+        // On other platforms or single file, auto-download
+        this.isDownloading = true;
         try {
-            const response = await fetch('/api/pending-files?t=' + Date.now(), {
-                method: 'GET',
-                headers: {
-                    'Cache-Control': 'no-cache'
-                }
-            });
+            await this.downloadFilesSequentially(newFiles);
+        } catch (error) {
+            console.error('Failed to download pending files:', error);
+        }
+        this.isDownloading = false;
 
-            if (response.ok) {
-                const data = await response.json();
-                const files = data.files || [];
+        const queued = this.queuedPendingFiles;
+        this.queuedPendingFiles = null;
+        if (queued) {
+            this.handlePendingFiles(queued);
+        }
+    }
 
-                // Filter out already downloaded files using name+size as unique key
-                const newFiles = files.filter(file => {
-                    const fileKey = `${file.name}-${file.size}`;
-                    return !this.downloadedFiles.has(fileKey);
-                });
+    // Folders are keyed by ID alone: their size grows while the server is still scanning them
+    pendingFileKey(file) {
+        return file.folder ? `${file.id}-folder` : `${file.id}-${file.size}`;
+    }
 
-                // If there are new files, handle them
-                if (newFiles.length > 0) {
-                    // Detect iOS Safari
-                    const isIOS = /iPad|iPhone|iPod/.test(navigator.userAgent) && !window.MSStream;
+    downloadFolder(folder) {
+        this.downloadedFiles.add(this.pendingFileKey(folder));
 
-                    if (isIOS && newFiles.length > 1) {
-                        // On iOS with multiple files, show download buttons instead of auto-download
-                        this.showPendingFilesForManualDownload(newFiles);
-                    } else {
-                        // On other platforms or single file, auto-download
-                        this.isDownloading = true;
-                        await this.downloadFilesSequentially(newFiles);
-                        this.isDownloading = false;
-                    }
-                }
-            }
-        } catch (error) {
-            console.error('Failed to check pending files:', error);
-            this.isDownloading = false;
+        // Too large to collect in memory like a single file; the browser streams it to disk
+        const link = document.createElement('a');
+        link.href = `/api/download/${folder.id}/${encodeURIComponent(folder.name)}.tar${this.authQuery()}`;
+        link.download = `${folder.name}.tar`;
+        link.style.display = 'none';
+        document.body.appendChild(link);
+        link.click();
+        setTimeout(() => document.body.removeChild(link), 100);
+
+        const counted = folder.scanning ? 'counting' : `${folder.fileCount} files, ${this.formatFileSize(folder.size)}`;
+        this.showNotification(`Downloading folder: ${folder.name} (${counted})`, 'info');
+    }
+
+    downloadArchive(files) {
+        for (const file of files) {
+            this.downloadedFiles.add(this.pendingFileKey(file));
         }
+
+        // The browser streams the archive to disk itself; a link can't carry headers, so the
+        // credential goes in the query string
+        const ids = files.map(file => file.id).join(',');
+        const auth = this.authToken ? '&auth=' + encodeURIComponent(this.authToken) : '';
+        const link = document.createElement('a');
+        link.href = `/api/archive/blade-files.zip?ids=${ids}${auth}`;
+        link.download = 'blade-files.zip';
+        link.style.display = 'none';
+        document.body.appendChild(link);
+        link.click();
+        setTimeout(() => document.body.removeChild(link), 100);
+
+        const totalSize = files.reduce((sum, file) => sum + file.size, 0);
+        this.showNotification(`Downloading ${files.length} files as ZIP (${this.formatFileSize(totalSize)})`, 'info');
     }
 
     showPendingFilesForManualDownload(files) {
         // Add each file to received files with a download button
         for (const file of files) {
-            const fileKey = `${file.name}-${file.size}`;
+            const fileKey = this.pendingFileKey(file);
 
             // Skip if already shown (check both sets)
             if (this.downloadedFiles.has(fileKey) || this.receivedFileElements.has(fileKey)) {
@@ -461,7 +656,7 @@ class BladeApp {
 
     addReceivedFileWithDownloadButton(file) {
         const receivedFilesDiv = document.getElementById('receivedFiles');
-        const fileKey = `${file.name}-${file.size}`;
+        const fileKey = this.pendingFileKey(file);
 
         // Check if already in DOM (prevent duplicates)
         if (this.receivedFileElements.has(fileKey)) {
@@ -475,7 +670,7 @@ class BladeApp {
         }
 
         // Use filename in URL to preserve original extension
-        const downloadUrl = `/api/download/${file.index}/${encodeURIComponent(file.name)}`;
+        const downloadUrl = `/api/download/${file.id}/${encodeURIComponent(file.name)}`;
 
         // Add file item with download button
         const fileItem = document.createElement('div');
@@ -498,57 +693,32 @@ class BladeApp {
     }
 
     async downloadFilesSequentially(files) {
-        for (let i = 0; i < files.length; i++) {
-            const file = files[i];
-            const fileKey = `${file.name}-${file.size}`;
+        // IDs in the newest queue received while downloading, rebuilt only when another one arrives
+        let latestQueue = null;
+        let latestIds = null;
+
+        for (const file of files) {
+            const fileKey = this.pendingFileKey(file);
 
             // Skip if already downloaded (double check)
             if (this.downloadedFiles.has(fileKey)) {
                 continue;
             }
 
+            // Transfer IDs are stable, so only files dequeued meanwhile (e.g. fetched by another device) are skipped
+            if (this.queuedPendingFiles && this.queuedPendingFiles !== latestQueue) {
+                latestQueue = this.queuedPendingFiles;
+                latestIds = new Set(latestQueue.map(queued => queued.id));
+            }
+            if (latestIds && !latestIds.has(file.id)) {
+                continue;
+            }
+
             // Mark as downloaded
             this.downloadedFiles.add(fileKey);
 
             // Download this file with progress tracking
             await this.downloadFileFromServer(file);
-
-            // Wait for server to process the download completion
-            if (i < files.length - 1) {
-                await new Promise(resolve => setTimeout(resolve, 1000));
-
-                // Re-check pending files to get updated indices after file removal
-                // This prevents convoy effect where indices shift after downloads
-                try {
-                    const response = await fetch('/api/pending-files?t=' + Date.now(), {
-                        method: 'GET',
-                        headers: { 'Cache-Control': 'no-cache' }
-                    });
-
-                    if (response.ok) {
-                        const data = await response.json();
-                        const remainingFiles = data.files || [];
-
-                        // Update the files array with fresh data
-                        // Match remaining files by name and size
-                        const updatedFiles = [];
-                        for (let j = i + 1; j < files.length; j++) {
-                            const originalFile = files[j];
-                            const matchingFile = remainingFiles.find(rf =>
-                                rf.name === originalFile.name && rf.size === originalFile.size
-                            );
-                            if (matchingFile) {
-                                updatedFiles.push(matchingFile);
-                            }
-                        }
-
-                        // Replace remaining files with updated indices
-                        files.splice(i + 1, files.length - i - 1, ...updatedFiles);
-                    }
-                } catch (error) {
-                    console.error('Failed to refresh pending files:', error);
-                }
-            }
         }
     }
 
@@ -560,57 +730,83 @@ class BladeApp {
         this.addReceivedFile(file);
 
         // Use the filename endpoint to preserve original extension
-        const downloadUrl = `/api/download/${file.index}/${encodeURIComponent(file.name)}`;
-
-        return new Promise((resolve, reject) => {
-            const xhr = new XMLHttpRequest();
-            xhr.open('GET', downloadUrl, true);
-            xhr.responseType = 'blob';
-
-            const fileKey = `${file.name}-${file.size}`;
-
-            // Track download progress
-            xhr.onprogress = (event) => {
-                if (event.lengthComputable) {
-                    const percentComplete = Math.round((event.loaded / event.total) * 100);
-                    this.updateReceivedFileProgress(fileKey, percentComplete);
+        const downloadUrl = `/api/download/${file.id}/${encodeURIComponent(file.name)}`;
+
+        const fileKey = this.pendingFileKey(file);
+        const maxAttempts = 5;
+        const chunks = [];
+        let received = 0;
+        let etag = null;
+        let attempts = 0;
+        let started = false;
+
+        // Stream the body and, if the connection drops, resume from the last received byte.
+        // If-Range makes the server send the whole file again if it changed in between.
+        while (!started || received < file.size) {
+            started = true;
+            try {
+                const headers = {};
+                if (received > 0) {
+                    headers['Range'] = `bytes=${received}-`;
+                    if (etag) headers['If-Range'] = etag;
                 }
-            };
-
-            xhr.onload = () => {
-                if (xhr.status === 200) {
-                    // Create a download link for the blob
-                    const blob = xhr.response;
-                    const url = window.URL.createObjectURL(blob);
-                    const link = document.createElement('a');
-                    link.href = url;
-                    link.download = file.name;
-                    link.style.display = 'none';
-                    document.body.appendChild(link);
-                    link.click();
-
-                    // Clean up
-                    setTimeout(() => {
-                        document.body.removeChild(link);
-                        window.URL.revokeObjectURL(url);
-                    }, 100);
-
-                    // Set progress to 100%
-                    this.updateReceivedFileProgress(fileKey, 100);
-                    resolve();
+                const response = await fetch(downloadUrl, { headers: this.authHeaders(headers), cache: 'no-store' });
+                if (response.status === 200) {
+                    chunks.length = 0;
+                    received = 0;
+                } else if (response.status !== 206) {
+                    throw new Error(`Download failed with status ${response.status}`);
+                }
+                etag = response.headers.get('ETag') || etag;
+
+                if (response.body && response.body.getReader) {
+                    const reader = response.body.getReader();
+                    while (true) {
+                        const { done, value } = await reader.read();
+                        if (done) break;
+                        chunks.push(value);
+                        received += value.length;
+                        if (file.size > 0) {
+                            this.updateReceivedFileProgress(fileKey, Math.round((received / file.size) * 100));
+                        }
+                    }
                 } else {
+                    const blob = await response.blob();
+                    chunks.push(blob);
+                    received += blob.size;
+                }
+                if (received < file.size) {
+                    throw new Error('Connection closed before the download completed');
+                }
+            } catch (error) {
+                attempts++;
+                console.warn(`Download of ${file.name} interrupted at ${received} bytes:`, error);
+                if (attempts >= maxAttempts) {
                     this.showNotification(`Failed to download: ${file.name}`, 'error');
-                    reject(new Error(`Download failed with status ${xhr.status}`));
+                    throw error;
                 }
-            };
+                await new Promise(resolve => setTimeout(resolve, 1000 * attempts));
+            }
+        }
 
-            xhr.onerror = () => {
-                this.showNotification(`Download error: ${file.name}`, 'error');
-                reject(new Error('Network error'));
-            };
+        // Create a download link for the assembled file
+        const blob = new Blob(chunks);
+        const url = window.URL.createObjectURL(blob);
+        const link = document.createElement('a');
+        link.href = url;
+        link.download = file.name;
+        link.style.display = 'none';
+        document.body.appendChild(link);
+        link.click();
+
+        // Clean up
+        setTimeout(() => {
+            document.body.removeChild(link);
+            window.URL.revokeObjectURL(url);
+        }, 100);
 
-            xhr.send();
-        });
+        // Set progress to 100%
+        this.updateReceivedFileProgress(fileKey, 100);
     }
 
     updateReceivedFileProgress(fileKey, percent) {
@@ -626,7 +822,7 @@ class BladeApp {
 
     addReceivedFile(file) {
         const receivedFilesDiv = document.getElementById('receivedFiles');
-        const fileKey = `${file.name}-${file.size}`;
+        const fileKey = this.pendingFileKey(file);
 
         // Check if this file is already displayed (prevent duplicates in UI)
         if (this.receivedFileElements.has(fileKey)) {
@@ -686,41 +882,44 @@ class BladeApp {
     }
 
     async loadConnectedDevices() {
-        const devicesList = document.getElementById('connectedDevicesList');
-
         try {
             // Fetch connected devices from server
-            const response = await fetch('/api/connected-devices?t=' + Date.now(), {
+            const response = await fetch('/api/connected-devices', {
                 method: 'GET',
-                headers: {
-                    'Cache-Control': 'no-cache, no-store, must-revalidate'
-                }
+                cache: 'no-cache',
+                headers: this.authHeaders()
             });
 
             if (response.ok) {
                 const data = await response.json();
-                const connectedIPs = data.devices || [];
-
-                if (connectedIPs.length === 0) {
-                    devicesList.innerHTML = '<p style="color: #888; font-style: italic;">No devices connected</p>';
-                } else {
-                    devicesList.innerHTML = connectedIPs.map(ip =>
-                        `<div style="padding: 8px; background: #f5f5f5; border-radius: 4px; color: #333; margin-bottom: 5px; display: flex; align-items: center; gap: 8px;">
-                            <img src="icons/devices.svg" alt="" style="width: 20px; height: 20px;">
-                            <strong>${ip}</strong>
-                        </div>`
-                    ).join('');
-                }
+                this.renderConnectedDevices(data.devices || []);
             } else {
-                devicesList.innerHTML = '<p style="color: #888; font-style: italic;">No devices connected</p>';
+                this.renderConnectedDevices([]);
             }
         } catch (error) {
             console.error('Failed to fetch connected devices:', error);
-            devicesList.innerHTML = '<p style="color: #888; font-style: italic;">No devices connected</p>';
+            this.renderConnectedDevices([]);
         }
 
-        // Poll for updates every 3 seconds
-        setTimeout(() => this.loadConnectedDevices(), 3000);
+        // Later changes arrive as "devices" events on the event stream
+    }
+
+    renderConnectedDevices(connectedIPs) {
+        const devicesList = document.getElementById('connectedDevicesList');
+        if (!devicesList) {
+            return;
+        }
+
+        if (connectedIPs.length === 0) {
+            devicesList.innerHTML = '<p style="color: #888; font-style: italic;">No devices connected</p>';
+        } else {
+            devicesList.innerHTML = connectedIPs.map(ip =>
+                `<div style="padding: 8px; background: #f5f5f5; border-radius: 4px; color: #333; margin-bottom: 5px; display: flex; align-items: center; gap: 8px;">
+                    <img src="icons/devices.svg" alt="" style="width: 20px; height: 20px;">
+                    <strong>${ip}</strong>
+                </div>`
+            ).join('');
+        }
     }
 
     startSessionTimer() {
@@ -837,20 +1036,70 @@ class BladeApp {
         for (let i = 0; i < this.selectedFiles.length; i++) {
             const file = this.selectedFiles[i];
 
-            // Announce the file to server first (so it appears in UI immediately)
-            try {
-                await fetch('/api/upload/announce', {
-                    method: 'POST',
-                    headers: {
-                        'Content-Type': 'application/json'
-                    },
-                    body: JSON.stringify({
-                        filename: file.name,
-                        size: file.size
-                    })
-                });
-            } catch (e) {
-                console.error('Failed to announce file:', e);
+            const setProgress = (percent) => {
+                const progressBar = document.getElementById(`progress-${i}`);
+                if (progressBar) progressBar.value = percent;
+            };
+
+            // Announce the file to server first (so it appears in UI immediately), over the
+            // control socket when it is open. The reply carries a resumable upload session.
+            let session = null;
+            let announced = await this.controlRequest({
+                type: 'announce',
+                filename: file.name,
+                size: file.size
+            });
+            if (!announced) {
+                try {
+                    const response = await fetch('/api/upload/announce', {
+                        method: 'POST',
+                        headers: this.authHeaders({
+                            'Content-Type': 'application/json'
+                        }),
+                        body: JSON.stringify({
+                            filename: file.name,
+                            size: file.size
+                        })
+                    });
+                    if (response.ok || response.status === 429 || response.status === 507) {
+                        announced = await response.json();
+                    }
+                } catch (e) {
+                    console.error('Failed to announce file:', e);
+                }
+            }
+            if (announced && announced.reason) {
+                // Refused before any data is sent: no room for the file, or too many uploads in progress
+                const reason = announced.reason === 'insufficient-space' ? 'not enough free space on the server' : 'too many uploads in progress';
+                this.showNotification(`Upload refused: ${file.name} (${reason})`, 'error');
+                continue;
+            }
+            if (announced && announced.uploadId) session = announced;
+
+            if (session) {
+                // Updating a saved file: send only the blocks that changed
+                if (document.getElementById('deltaMode')?.checked && await this.uploadFileDelta(file, session, setProgress)) {
+                    setProgress(100);
+                    continue;
+                }
+
+                // The server copies every chunk it already has; only the rest crosses the network
+                let committed = [];
+                if (session.dedup === 1 && file.size >= this.dedupMinSize) {
+                    const status = await this.sendChunkList(file, session);
+                    if (status && status.complete) {
+                        setProgress(100);
+                        continue;
+                    }
+                    if (status) committed = status.ranges;
+                }
+                const ok = await this.uploadFileChunked(file, session, setProgress, committed);
+                if (!ok) {
+                    this.showNotification(`Upload failed: ${file.name}`, 'error');
+                    continue;
+                }
+                setProgress(100);
+                continue;
             }
 
             const form = new FormData();
@@ -859,18 +1108,16 @@ class BladeApp {
             await new Promise((resolve) => {
                 const xhr = new XMLHttpRequest();
                 xhr.open('POST', '/api/upload', true);
+                if (this.authToken) xhr.setRequestHeader('X-Blade-Auth', this.authToken);
 
                 xhr.upload.onprogress = (e) => {
                     if (e.lengthComputable) {
-                        const percent = Math.round((e.loaded / e.total) * 100);
-                        const progressBar = document.getElementById(`progress-${i}`);
-                        if (progressBar) progressBar.value = percent;
+                        setProgress(Math.round((e.loaded / e.total) * 100));
                     }
                 };
 
                 xhr.onload = () => {
-                    const progressBar = document.getElementById(`progress-${i}`);
-                    if (progressBar) progressBar.value = 100;
+                    setProgress(100);
                     resolve();
                 };
 
@@ -889,6 +1136,466 @@ class BladeApp {
     }
 
 
+    // Uploads a file in chunks at explicit offsets over several parallel connections.
+    // After a network drop the server is asked which byte ranges it already committed,
+    // so only the missing data is sent again.
+    async uploadFileChunked(file, session, setProgress, committed = []) {
+        const chunkSize = session.chunkSize || 4 * 1024 * 1024;
+        const streams = Math.max(1, Math.min(this.uploadStreams, Math.ceil(file.size / chunkSize)));
+        const maxAttempts = 8;
+        const inFlight = new Map(); // begin -> { end, loaded }
+        let ranges = committed;
+        let attempts = 0;
+        let complete = false;
+
+        const reportProgress = () => {
+            if (file.size === 0) return;
+            let done = ranges.reduce((sum, [begin, end]) => sum + (end - begin), 0);
+            for (const chunk of inFlight.values()) done += chunk.loaded;
+            setProgress(Math.min(99, Math.round((done / file.size) * 100)));
+        };
+
+        const worker = async () => {
+            while (!complete && attempts < maxAttempts) {
+                // Skip both committed ranges and chunks other streams are sending
+                const claimed = this.mergeRanges(ranges, [...inFlight].map(([begin, chunk]) => [begin, chunk.end]));
+                const missing = this.nextMissingRange(claimed, file.size, chunkSize);
+                if (!missing) return;
+
+                const chunk = { end: missing.end, loaded: 0 };
+                inFlight.set(missing.begin, chunk);
+                try {
+                    const status = await this.putUploadChunk(session.uploadId, file.slice(missing.begin, missing.end), missing.begin, (loaded) => {
+                        chunk.loaded = loaded;
+                        reportProgress();
+                    });
+                    // Replies can arrive out of order, so never let the view shrink
+                    ranges = this.mergeRanges(ranges, status.ranges);
+                    attempts = 0;
+                    if (status.complete) complete = true;
+                } catch (error) {
+                    attempts++;
+                    console.warn(`Chunk upload of ${file.name} at ${missing.begin} failed:`, error);
+                    await new Promise(resolve => setTimeout(resolve, 1000 * attempts));
+                    const status = await this.fetchUploadStatus(session.uploadId);
+                    if (status) ranges = this.mergeRanges(ranges, status.ranges);
+                } finally {
+                    inFlight.delete(missing.begin);
+                    reportProgress();
+                }
+            }
+        };
+
+        await Promise.all(Array.from({ length: streams }, worker));
+        if (complete) return true;
+
+        // Everything was sent; the server renames the file once the last chunk lands
+        const status = await this.fetchUploadStatus(session.uploadId);
+        return !!(status && status.complete);
+    }
+
+    // Sends a file as a delta against the file the server already saved under its name. The result
+    // is saved next to it, or over it if the user chose so, and only if it hashes to the file's
+    // SHA-256. Returns false to upload normally: no saved file, nothing in common with it, or the
+    // delta didn't go through.
+    async uploadFileDelta(file, session, setProgress) {
+        try {
+            const response = await fetch(`/api/upload/${session.uploadId}/signature`, { headers: this.authHeaders(), cache: 'no-store' });
+            if (!response.ok) return false;
+            const signature = new DataView(await response.arrayBuffer());
+            const result = await this.deltaOperations(file, signature);
+            if (!result) return false;
+            const { delta, sha256 } = result;
+
+            const replace = document.getElementById('deltaReplace')?.checked ? '&replace=1' : '';
+            const url = `/api/upload/${session.uploadId}/delta?basis=${signature.getBigInt64(16, true)}` +
+                `&basisSize=${signature.getBigUint64(8, true)}&sha256=${sha256}${replace}`;
+            const status = await this.putBlob(url, delta, (loaded) => {
+                setProgress(Math.min(99, Math.round((loaded / delta.size) * 100)));
+            });
+            return !!status.complete;
+        } catch (e) {
+            console.warn(`Delta upload of ${file.name} failed:`, e);
+            return false;
+        }
+    }
+
+    // Matches a file against a block signature with rsync's rolling checksum and returns the
+    // operation stream as a Blob (literal data stays a slice of the file) along with the file's
+    // SHA-256, or null if no block matched
+    async deltaOperations(file, signature) {
+        const blockSize = signature.getUint32(4, true);
+        const blockCount = (signature.byteLength - 24) / 20;
+        const bytes = new Uint8Array(signature.buffer);
+        const blocks = new Map(); // Weak checksum -> block indices
+        const filter = new Uint8Array(1 << DELTA_FILTER_BITS);
+        const filterSlot = (weak) => Math.imul(weak, 0x9E3779B1) >>> (32 - DELTA_FILTER_BITS);
+        for (let i = 0; i < blockCount; i++) {
+            const weak = signature.getUint32(24 + i * 20, true);
+            filter[filterSlot(weak)] = 1;
+            if (blocks.has(weak)) blocks.get(weak).push(i);
+            else blocks.set(weak, [i]);
+        }
+        const strongHex = (i) => Array.from(bytes.subarray(28 + i * 20, 44 + i * 20), (b) => b.toString(16).padStart(2, '0')).join('');
+
+        const parts = [];
+        let copy = null; // Pending COPY, extended while consecutive blocks match
+        let matched = 0;
+        const flushCopy = () => {
+            if (!copy) return;
+            const op = new DataView(new ArrayBuffer(9));
+            op.setUint8(0, DELTA_OP_COPY);
+            op.setUint32(1, copy.first, true);
+            op.setUint32(5, copy.count, true);
+            parts.push(op.buffer);
+            copy = null;
+        };
+        const emitData = (begin, end) => {
+            if (begin < end) flushCopy();
+            for (let pos = begin; pos < end; pos += DELTA_MAX_LITERAL) {
+                const length = Math.min(DELTA_MAX_LITERAL, end - pos);
+                const op = new DataView(new ArrayBuffer(5));
+                op.setUint8(0, DELTA_OP_DATA);
+                op.setUint32(1, length, true);
+                parts.push(op.buffer, file.slice(pos, pos + length));
+            }
+        };
+
+        const sliceSize = 16 * 1024 * 1024;
+        const hash = this.sha256Hasher(); // Fed each slice as it is read, front to back
+        let hashed = 0;
+        let buffer = new Uint8Array(0);
+        let base = 0; // File offset of buffer[0]
+        let pos = 0; // Start of the window
+        let literal = 0; // Start of data not yet covered by an operation
+        let s1 = 0;
+        let s2 = 0;
+        let rolling = false; // Whether s1/s2 describe the window at pos
+        while (blockCount > 0 && pos + blockSize <= file.size) {
+            // Keep the window and the byte after it buffered
+            if (pos + blockSize + 1 > base + buffer.length && base + buffer.length < file.size) {
+                const read = base + buffer.length;
+                const slice = new Uint8Array(await file.slice(read, Math.min(file.size, read + sliceSize)).arrayBuffer());
+                hash.update(slice);
+                hashed = read + slice.length;
+                const merged = new Uint8Array(base + buffer.length - pos + slice.length);
+                merged.set(buffer.subarray(pos - base));
+                merged.set(slice, base + buffer.length - pos);
+                buffer = merged;
+                base = pos;
+            }
+            const at = pos - base;
+            if (!rolling) {
+                s1 = 0;
+                s2 = 0;
+                for (let i = at; i < at + blockSize; i++) {
+                    s1 += buffer[i];
+                    s2 += s1;
+                }
+                s1 &= 0xFFFF;
+                s2 &= 0xFFFF;
+                rolling = true;
+            }
+
+            const weak = (s1 | s2 << 16) >>> 0;
+            const candidates = filter[filterSlot(weak)] ? blocks.get(weak) : undefined;
+            if (candidates) {
+                const strong = this.sha256Hex(buffer.subarray(at, at + blockSize)).slice(0, 32);
+                const expected = copy ? copy.first + copy.count : -1;
+                let block = -1;
+                for (const i of candidates) {
+                    if (strongHex(i) !== strong) continue;
+                    block = i;
+                    if (i === expected) break; // Prefer continuing the current run
+                }
+                if (block >= 0) {
+                    emitData(literal, pos);
+                    if (copy && block === copy.first + copy.count) {
+                        copy.count++;
+                    } else {
+                        flushCopy();
+                        copy = { first: block, count: 1 };
+                    }
+                    matched += blockSize;
+                    pos += blockSize;
+                    literal = pos;
+                    rolling = false;
+                    continue;
+                }
+            }
+
+            // Slide the window one byte
+            if (pos + blockSize < file.size) {
+                const out = buffer[at];
+                s1 = s1 - out + buffer[at + blockSize] & 0xFFFF;
+                s2 = s2 - blockSize * out + s1 & 0xFFFF;
+            }
+            pos++;
+        }
+        if (matched === 0) return null;
+        emitData(literal, file.size);
+        flushCopy();
+        for (; hashed < file.size; hashed = Math.min(file.size, hashed + sliceSize)) {
+            hash.update(new Uint8Array(await file.slice(hashed, hashed + sliceSize).arrayBuffer()));
+        }
+        return { delta: new Blob(parts), sha256: hash.hex() };
+    }
+
+    // Offers the server the chunk list of a file before uploading it. Returns the session
+    // status after the server copied the chunks it had, or null to simply upload everything.
+    async sendChunkList(file, session) {
+        try {
+            // Large files are probed first, so one the server has nothing of isn't hashed in full
+            let status = null;
+            if (file.size > this.dedupProbeSize) {
+                status = await this.sendProbeChunks(file, session);
+                if (!status || status.complete || status.received === 0) return status;
+            }
+
+            const chunks = await this.contentChunks(file);
+            let offset = 0;
+            for (let i = 0; i < chunks.length; i += this.chunkListBatch) {
+                const batch = chunks.slice(i, i + this.chunkListBatch);
+                status = await this.postChunkList(session, offset, batch) || status;
+                offset += batch.reduce((sum, [, length]) => sum + length, 0);
+            }
+            return status;
+        } catch (e) {
+            console.warn(`Chunk list of ${file.name} not sent:`, e);
+            return null;
+        }
+    }
+
+    // Sends the file's first chunk and several from its middle. Cut points found from an
+    // arbitrary offset meet the file's own within a few chunks (eight suffice almost always),
+    // so this catches both identical files and files whose beginning was edited.
+    async sendProbeChunks(file, session) {
+        const gear = this.gearTable();
+        const read = async (begin, end) => new Uint8Array(await file.slice(begin, Math.min(file.size, end)).arrayBuffer());
+
+        const head = await read(0, DEDUP_MAX_CHUNK);
+        const first = this.chunkLength(head, gear);
+        const status = await this.postChunkList(session, 0, [[this.sha256Hex(head.subarray(0, first)), first]]);
+        if (!status || status.complete) return status;
+
+        const middle = Math.floor(file.size / 2);
+        const region = await read(middle, middle + 6 * DEDUP_MAX_CHUNK);
+        const chunks = [];
+        let pos = this.chunkLength(region, gear);
+        const begin = middle + pos;
+        while (chunks.length < 8 && region.length - pos >= DEDUP_MAX_CHUNK) {
+            const length = this.chunkLength(region.subarray(pos), gear);
+            chunks.push([this.sha256Hex(region.subarray(pos, pos + length)), length]);
+            pos += length;
+        }
+        return await this.postChunkList(session, begin, chunks) || status;
+    }
+
+    async postChunkList(session, offset, chunks) {
+        const response = await fetch(`/api/upload/${session.uploadId}/chunks?offset=${offset}`, {
+            method: 'POST',
+            headers: this.authHeaders({ 'Content-Type': 'text/plain' }),
+            body: chunks.map(([hash, length]) => `${hash} ${length}`).join('\n')
+        });
+        return response.ok ? await response.json() : null;
+    }
+
+    // Cuts a file into content-defined chunks; returns [sha256 hex, length] pairs
+    async contentChunks(file) {
+        const gear = this.gearTable();
+        const sliceSize = 16 * 1024 * 1024;
+        const chunks = [];
+        let buffer = new Uint8Array(0);
+        let start = 0; // Next chunk's position in buffer
+        let read = 0; // Bytes of the file read into buffer so far
+        while (read < file.size || start < buffer.length) {
+            // Keep a maximum chunk buffered ahead of the cut point until the end of the file
+            if (buffer.length - start < DEDUP_MAX_CHUNK && read < file.size) {
+                const slice = new Uint8Array(await file.slice(read, Math.min(file.size, read + sliceSize)).arrayBuffer());
+                const merged = new Uint8Array(buffer.length - start + slice.length);
+                merged.set(buffer.subarray(start));
+                merged.set(slice, buffer.length - start);
+                buffer = merged;
+                start = 0;
+                read += slice.length;
+                continue;
+            }
+            const length = this.chunkLength(buffer.subarray(start), gear);
+            chunks.push([this.sha256Hex(buffer.subarray(start, start + length)), length]);
+            start += length;
+        }
+        return chunks;
+    }
+
+    // Gear values from xorshift32, as generated by the server
+    gearTable() {
+        const table = new Int32Array(256);
+        let state = 0x9E3779B9 | 0;
+        for (let i = 0; i < 256; i++) {
+            state ^= state << 13;
+            state ^= state >>> 17;
+            state ^= state << 5;
+            table[i] = state;
+        }
+        return table;
+    }
+
+    // Length of the first chunk of data (FastCDC with normalized chunking)
+    chunkLength(data, gear) {
+        if (data.length <= DEDUP_MIN_CHUNK) return data.length;
+        const end = Math.min(data.length, DEDUP_MAX_CHUNK);
+        const normal = Math.min(end, DEDUP_AVG_CHUNK);
+        let hash = 0;
+        let i = DEDUP_MIN_CHUNK;
+        for (; i < normal; i++) {
+            hash = (hash << 1) + gear[data[i]] | 0;
+            if ((hash & DEDUP_MASK_SMALL) === 0) return i + 1;
+        }
+        for (; i < end; i++) {
+            hash = (hash << 1) + gear[data[i]] | 0;
+            if ((hash & DEDUP_MASK_LARGE) === 0) return i + 1;
+        }
+        return end;
+    }
+
+    // SHA-256 in plain JavaScript: crypto.subtle is missing on plain-HTTP pages
+    sha256Hex(bytes) {
+        const hash = this.sha256Hasher();
+        hash.update(bytes);
+        return hash.hex();
+    }
+
+    // Incremental SHA-256 for data read in slices: update(bytes) as often as needed, then hex() once
+    sha256Hasher() {
+        const h = new Int32Array([0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19]);
+        const w = new Int32Array(64);
+        const block = new Uint8Array(64); // Bytes of an incomplete block
+        let blockLength = 0;
+        let length = 0; // Total bytes hashed
+        const compress = (data, p) => {
+            for (let i = 0; i < 16; i++, p += 4) w[i] = data[p] << 24 | data[p + 1] << 16 | data[p + 2] << 8 | data[p + 3];
+            for (let i = 16; i < 64; i++) {
+                const x = w[i - 15];
+                const y = w[i - 2];
+                const s0 = (x >>> 7 | x << 25) ^ (x >>> 18 | x << 14) ^ (x >>> 3);
+                const s1 = (y >>> 17 | y << 15) ^ (y >>> 19 | y << 13) ^ (y >>> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1 | 0;
+            }
+            let a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+            for (let i = 0; i < 64; i++) {
+                const t1 = k + ((e >>> 6 | e << 26) ^ (e >>> 11 | e << 21) ^ (e >>> 25 | e << 7)) +
+                    (e & f ^ ~e & g) + SHA256_K[i] + w[i] | 0;
+                const t2 = ((a >>> 2 | a << 30) ^ (a >>> 13 | a << 19) ^ (a >>> 22 | a << 10)) + (a & b ^ a & c ^ b & c) | 0;
+                k = g; g = f; f = e; e = d + t1 | 0;
+                d = c; c = b; b = a; a = t1 + t2 | 0;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+        };
+
+        return {
+            update(bytes) {
+                let p = 0;
+                length += bytes.length;
+                if (blockLength > 0) {
+                    p = Math.min(bytes.length, 64 - blockLength);
+                    block.set(bytes.subarray(0, p), blockLength);
+                    blockLength += p;
+                    if (blockLength < 64) return;
+                    compress(block, 0);
+                    blockLength = 0;
+                }
+                for (; p + 64 <= bytes.length; p += 64) compress(bytes, p);
+                block.set(bytes.subarray(p));
+                blockLength = bytes.length - p;
+            },
+            hex() {
+                // Final block(s): 0x80, zero padding, then the message length in bits (big-endian)
+                const tail = new Uint8Array(blockLength < 56 ? 64 : 128);
+                tail.set(block.subarray(0, blockLength));
+                tail[blockLength] = 0x80;
+                const view = new DataView(tail.buffer);
+                view.setUint32(tail.length - 8, Math.floor(length / 0x20000000));
+                view.setUint32(tail.length - 4, length * 8 >>> 0);
+                for (let p = 0; p < tail.length; p += 64) compress(tail, p);
+
+                return Array.from(h, (v) => (v >>> 0).toString(16).padStart(8, '0')).join('');
+            }
+        };
+    }
+
+    // Union of two sorted lists of [begin, end) ranges
+    mergeRanges(a, b) {
+        const all = [...a, ...b].sort((x, y) => x[0] - y[0]);
+        const merged = [];
+        for (const [begin, end] of all) {
+            const last = merged[merged.length - 1];
+            if (last && begin <= last[1]) {
+                last[1] = Math.max(last[1], end);
+            } else {
+                merged.push([begin, end]);
+            }
+        }
+        return merged;
+    }
+
+    // First gap in the committed ranges, capped at one chunk
+    nextMissingRange(ranges, size, chunkSize) {
+        let pos = 0;
+        for (const [begin, end] of ranges) {
+            if (begin > pos) break;
+            pos = Math.max(pos, end);
+        }
+        if (pos >= size) return null;
+        const next = ranges.find(([begin]) => begin > pos);
+        const limit = next ? next[0] : size;
+        return { begin: pos, end: Math.min(limit, pos + chunkSize) };
+    }
+
+    putUploadChunk(uploadId, blob, offset, onProgress) {
+        return this.putBlob(`/api/upload/${uploadId}?offset=${offset}`, blob, onProgress);
+    }
+
+    // PUTs a body with upload progress; resolves with the JSON reply
+    putBlob(url, blob, onProgress) {
+        return new Promise((resolve, reject) => {
+            const xhr = new XMLHttpRequest();
+            xhr.open('PUT', url, true);
+            xhr.setRequestHeader('Content-Type', 'application/octet-stream');
+            if (this.authToken) xhr.setRequestHeader('X-Blade-Auth', this.authToken);
+
+            xhr.upload.onprogress = (e) => {
+                if (e.lengthComputable) onProgress(e.loaded);
+            };
+
+            xhr.onload = () => {
+                if (xhr.status === 200) {
+                    try {
+                        resolve(JSON.parse(xhr.responseText));
+                    } catch (e) {
+                        reject(e);
+                    }
+                } else {
+                    reject(new Error(`Upload rejected with status ${xhr.status}`));
+                }
+            };
+
+            xhr.onerror = () => reject(new Error('Network error'));
+            xhr.ontimeout = () => reject(new Error('Timeout'));
+
+            xhr.send(blob);
+        });
+    }
+
+    async fetchUploadStatus(uploadId) {
+        try {
+            const response = await fetch(`/api/upload/${uploadId}`, { headers: this.authHeaders(), cache: 'no-store' });
+            if (!response.ok) return null;
+            return await response.json();
+        } catch (e) {
+            return null;
+        }
+    }
+
     formatFileSize(bytes) {
         if (bytes === 0) return '0 Bytes';
         const sizes = ['Bytes', 'KB', 'MB', 'GB'];
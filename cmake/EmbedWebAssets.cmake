@@ -0,0 +1,87 @@
+# Generates a C++ source that compiles every file of the web UI into the executable.
+#
+# Usage:
+#   cmake -DWEB_DIR=<dir> -DOUTPUT=<file.cpp> [-DEMBED=OFF] -P EmbedWebAssets.cmake
+#
+# Each file becomes a constexpr byte array together with its URL path, MIME type,
+# ETag (from the SHA-1 of its contents) and Last-Modified date. With EMBED=OFF an
+# empty table is generated and the server falls back to reading the web root.
+
+if(NOT DEFINED WEB_DIR OR NOT DEFINED OUTPUT)
+    message(FATAL_ERROR "EmbedWebAssets.cmake requires WEB_DIR and OUTPUT")
+endif()
+
+function(web_content_type path out)
+    get_filename_component(ext "${path}" LAST_EXT)
+    string(TOLOWER "${ext}" ext)
+    set(type "application/octet-stream")
+    if(ext STREQUAL ".html" OR ext STREQUAL ".htm")
+        set(type "text/html")
+    elseif(ext STREQUAL ".css")
+        set(type "text/css")
+    elseif(ext STREQUAL ".js" OR ext STREQUAL ".mjs")
+        set(type "application/javascript")
+    elseif(ext STREQUAL ".json")
+        set(type "application/json")
+    elseif(ext STREQUAL ".txt")
+        set(type "text/plain")
+    elseif(ext STREQUAL ".svg")
+        set(type "image/svg+xml")
+    elseif(ext STREQUAL ".png")
+        set(type "image/png")
+    elseif(ext STREQUAL ".jpg" OR ext STREQUAL ".jpeg")
+        set(type "image/jpeg")
+    elseif(ext STREQUAL ".gif")
+        set(type "image/gif")
+    elseif(ext STREQUAL ".webp")
+        set(type "image/webp")
+    elseif(ext STREQUAL ".ico")
+        set(type "image/x-icon")
+    elseif(ext STREQUAL ".woff")
+        set(type "font/woff")
+    elseif(ext STREQUAL ".woff2")
+        set(type "font/woff2")
+    endif()
+    set(${out} "${type}" PARENT_SCOPE)
+endfunction()
+
+set(arrays "")
+set(entries "")
+set(count 0)
+
+if(NOT DEFINED EMBED OR EMBED)
+    file(GLOB_RECURSE files RELATIVE "${WEB_DIR}" "${WEB_DIR}/*")
+    list(SORT files)
+    foreach(rel IN LISTS files)
+        set(abs "${WEB_DIR}/${rel}")
+        file(SIZE "${abs}" size)
+        file(SHA1 "${abs}" sha1)
+        string(SUBSTRING "${sha1}" 0 16 tag)
+        file(TIMESTAMP "${abs}" modified "%a, %d %b %Y %H:%M:%S GMT" UTC)
+        web_content_type("${rel}" type)
+
+        if(size EQUAL 0)
+            set(bytes "0")
+        else()
+            file(READ "${abs}" hex HEX)
+            # 24 bytes per line
+            string(REGEX REPLACE "(................................................)" "\\1\n    " hex "${hex}")
+            string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+        endif()
+
+        string(APPEND arrays "// ${rel}\nconstexpr unsigned char ASSET_${count}[] = {\n    ${bytes}\n};\n\n")
+        string(APPEND entries "    {\"/${rel}\", \"${type}\", \"\\\"${tag}\\\"\", \"${modified}\", ASSET_${count}, ${size}},\n")
+        math(EXPR count "${count} + 1")
+    endforeach()
+endif()
+
+set(content "// Generated by cmake/EmbedWebAssets.cmake - do not edit\n\n#include \"EmbeddedAssets.h\"\n\nnamespace blade {\n\n")
+if(count GREATER 0)
+    string(APPEND content "namespace {\n\n${arrays}constexpr EmbeddedAsset ASSETS[] = {\n${entries}};\n\n} // namespace\n\n")
+    string(APPEND content "std::span<const EmbeddedAsset> embeddedAssets() {\n    return ASSETS;\n}\n")
+else()
+    string(APPEND content "std::span<const EmbeddedAsset> embeddedAssets() {\n    return {};\n}\n")
+endif()
+string(APPEND content "\n} // namespace blade\n")
+
+file(WRITE "${OUTPUT}" "${content}")
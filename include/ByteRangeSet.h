@@ -0,0 +1,50 @@
+#ifndef BLADE_BYTE_RANGE_SET_H
+#define BLADE_BYTE_RANGE_SET_H
+
+#include <cstdint>
+#include <map>
+
+namespace blade {
+
+/**
+ * @brief Set of half-open byte ranges [begin, end) kept merged and sorted
+ *
+ * Used to track which parts of a file have been transferred when the data
+ * arrives or leaves out of order (resumed downloads, chunked uploads).
+ */
+class ByteRangeSet {
+public:
+    /**
+     * @brief Add a range, merging it with any overlapping or adjacent ranges
+     * @param begin First byte of the range
+     * @param end One past the last byte of the range
+     */
+    void add(uint64_t begin, uint64_t end);
+
+    /**
+     * @brief Check whether a range is completely contained in the set
+     * @param begin First byte of the range
+     * @param end One past the last byte of the range
+     * @return true if every byte in [begin, end) is present
+     */
+    [[nodiscard]] bool covers(uint64_t begin, uint64_t end) const;
+
+    /**
+     * @brief Total number of bytes in the set
+     * @return Sum of all range lengths
+     */
+    [[nodiscard]] uint64_t total() const;
+
+    /**
+     * @brief Access the merged ranges
+     * @return Map of range begin to range end
+     */
+    [[nodiscard]] const std::map<uint64_t, uint64_t>& ranges() const;
+
+private:
+    std::map<uint64_t, uint64_t> ranges_;
+};
+
+} // namespace blade
+
+#endif // BLADE_BYTE_RANGE_SET_H
@@ -0,0 +1,78 @@
+#ifndef BLADE_BYTE_SEARCH_H
+#define BLADE_BYTE_SEARCH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace blade {
+
+/**
+ * @brief Preprocessed substring search over byte buffers
+ *
+ * Candidate positions are found with a vectorized first/last-byte filter
+ * (AVX2 when the CPU has it, SSE2 otherwise) that examines 32 or 16 offsets
+ * per step and only falls back to a full comparison where both ends of the
+ * needle match. Targets without SSE2 use Boyer-Moore-Horspool. The same
+ * searcher is meant to be reused for every chunk of a stream:
+ * partialMatchLength() tells how much of a chunk's tail has to be kept so a
+ * needle straddling two chunks is still found once the next one arrives.
+ */
+class ByteSearcher {
+public:
+    static constexpr size_t npos = std::string::npos;
+
+    /**
+     * @brief Constructor
+     * @param needle Byte sequence to search for
+     */
+    explicit ByteSearcher(std::string_view needle);
+
+    /**
+     * @brief Find the first occurrence of the needle
+     * @param data Pointer to haystack bytes
+     * @param len Haystack length
+     * @param from Offset to start searching at
+     * @return Offset of the match, or npos if there is none (or the needle is empty)
+     */
+    [[nodiscard]] size_t find(const uint8_t* data, size_t len, size_t from = 0) const;
+
+    /**
+     * @brief Length of the longest proper prefix of the needle that ends the buffer
+     *
+     * When find() fails on a chunk, only this many trailing bytes can still
+     * turn into a match; everything before them is known not to be part of one.
+     * @param data Pointer to buffer bytes
+     * @param len Buffer length
+     * @return Number of trailing bytes to carry over to the next chunk
+     */
+    [[nodiscard]] size_t partialMatchLength(const uint8_t* data, size_t len) const;
+
+    /**
+     * @brief The needle being searched for
+     * @return Needle bytes
+     */
+    [[nodiscard]] const std::string& needle() const { return needle_; }
+
+    /**
+     * @brief One-off search without keeping the preprocessed needle
+     * @param data Pointer to haystack bytes
+     * @param len Haystack length
+     * @param needle Byte sequence to search for
+     * @param from Offset to start searching at
+     * @return Offset of the match, or npos if there is none
+     */
+    static size_t find(const uint8_t* data, size_t len, std::string_view needle, size_t from = 0);
+
+private:
+    std::string needle_;
+    std::array<uint32_t, 256> shift_{};  // Horspool bad-character shifts
+
+    size_t findHorspool(const uint8_t* data, size_t len, size_t from) const;
+};
+
+} // namespace blade
+
+#endif // BLADE_BYTE_SEARCH_H
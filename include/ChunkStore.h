@@ -0,0 +1,151 @@
+#ifndef BLADE_CHUNK_STORE_H
+#define BLADE_CHUNK_STORE_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace blade {
+
+/**
+ * @brief Content-addressed index of the chunks of files received so far
+ *
+ * Files saved in the download directory are cut into content-defined chunks
+ * (FastCDC: a gear rolling hash picks the cut points, so an insertion only
+ * moves the boundaries near it) and each chunk is recorded under its SHA-256
+ * digest with the file and offset it can be read from. The files themselves
+ * are the chunk store; nothing is stored twice. A client about to upload a
+ * file first sends its chunk list, and every chunk found here is copied
+ * locally instead of crossing the network again.
+ *
+ * Files are indexed on a background thread once they have been saved. The
+ * index is kept in a hidden file in the download directory so it survives
+ * restarts; an entry only counts while its file still has the size and
+ * modification time it had when it was indexed.
+ */
+class ChunkStore {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    // Chunk size bounds; clients must cut files exactly the same way (see script.js)
+    static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+    static constexpr size_t AVG_CHUNK_SIZE = 1024 * 1024;
+    static constexpr size_t MAX_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    struct Chunk {
+        Digest digest{};
+        uint64_t length = 0;
+    };
+
+    struct Location {
+        std::filesystem::path path;
+        uint64_t offset = 0;
+    };
+
+    /**
+     * @brief Open the index of a download directory
+     * @param directory Directory whose files are indexed
+     */
+    explicit ChunkStore(std::filesystem::path directory);
+
+    /**
+     * @brief Stop indexing; files still queued stay unindexed
+     */
+    ~ChunkStore();
+
+    ChunkStore(const ChunkStore&) = delete;
+    ChunkStore& operator=(const ChunkStore&) = delete;
+
+    /**
+     * @brief Length of the first content-defined chunk of a buffer
+     * @param data Pointer to data
+     * @param len Bytes available; anything below MAX_CHUNK_SIZE must be the end of the file
+     * @return Chunk length, at most len
+     */
+    static size_t chunkLength(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Queue a saved file in the directory for indexing
+     * @param path Path of the file
+     */
+    void addFile(const std::filesystem::path& path);
+
+    /**
+     * @brief Find a chunk in a file that is still unchanged
+     * @param chunk Digest and length of the chunk
+     * @return Where the chunk's bytes can be read, or nullopt if it is unknown
+     */
+    [[nodiscard]] std::optional<Location> find(const Chunk& chunk);
+
+    /**
+     * @brief Check whether an unchanged indexed file consists of exactly these chunks
+     * @param path Path of the file
+     * @param chunks Chunk list of the whole candidate file
+     * @return true if the candidate is a copy of the file
+     */
+    [[nodiscard]] bool isCopyOf(const std::filesystem::path& path, std::span<const Chunk> chunks);
+
+    /**
+     * @brief Parse a digest written as 64 hex digits
+     * @param hex Hex text
+     * @return Digest, or nullopt if malformed
+     */
+    static std::optional<Digest> parseDigest(std::string_view hex);
+
+private:
+    struct IndexedFile {
+        std::string name;  // File name in the directory (UTF-8)
+        uint64_t size = 0;
+        int64_t modified = 0;  // file_time_type ticks
+        std::vector<Chunk> chunks;
+        bool live = true;
+    };
+
+    struct ChunkRef {
+        size_t file;      // Index into files_
+        size_t chunk;     // Index into the file's chunks
+        uint64_t offset;  // Position of the chunk in the file
+    };
+
+    struct DigestHash {
+        size_t operator()(const Digest& digest) const noexcept;
+    };
+
+    void load();
+    void rewrite();
+    void index();
+    bool indexFile(const std::filesystem::path& path, IndexedFile& file) const;
+    void insert(IndexedFile file);
+    void link(IndexedFile file);
+    void drop(size_t file);
+    bool isUnchanged(const IndexedFile& file) const;
+
+    const std::filesystem::path directory_;
+    const std::filesystem::path indexPath_;
+
+    std::mutex mutex_;
+    std::vector<IndexedFile> files_;
+    std::unordered_map<std::string, size_t> filesByName_;
+    std::unordered_multimap<Digest, ChunkRef, DigestHash> chunks_;
+
+    std::condition_variable queueCv_;
+    std::deque<std::filesystem::path> queue_;
+    std::atomic<bool> stopping_{false};
+    std::thread indexer_;
+};
+
+} // namespace blade
+
+#endif // BLADE_CHUNK_STORE_H
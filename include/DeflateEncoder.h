@@ -0,0 +1,130 @@
+#ifndef BLADE_DEFLATE_ENCODER_H
+#define BLADE_DEFLATE_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace blade {
+
+/**
+ * @brief Streaming DEFLATE (RFC 1951) compressor with zlib and gzip framing
+ *
+ * Input is fed in arbitrary pieces with write(); compressed bytes are appended
+ * to the caller's buffer as each block is completed, so memory use stays at
+ * one block of input plus the 32KB match window regardless of stream length.
+ * Each block is emitted as stored, fixed or dynamic Huffman, whichever is
+ * smallest, so incompressible data costs only a few bytes per 64KB.
+ */
+class DeflateEncoder {
+public:
+    enum class Format {
+        Raw,   // Bare DEFLATE stream (ZIP entries)
+        Zlib,  // RFC 1950 wrapper ("deflate" content coding)
+        Gzip   // RFC 1952 wrapper ("gzip" content coding)
+    };
+
+    /**
+     * @brief Constructor
+     * @param format Stream framing
+     * @param level Compression level 0 (store only) to 9 (best)
+     */
+    explicit DeflateEncoder(Format format = Format::Raw, int level = 6);
+
+    /**
+     * @brief Compress the next piece of input
+     * @param data Pointer to input bytes
+     * @param len Number of input bytes
+     * @param out Buffer that completed compressed bytes are appended to
+     */
+    void write(const uint8_t* data, size_t len, std::string& out);
+
+    /**
+     * @brief Emit everything written so far, ending on a byte boundary (sync flush)
+     * @param out Buffer that compressed bytes are appended to
+     */
+    void flush(std::string& out);
+
+    /**
+     * @brief Terminate the stream and append the trailer
+     * @param out Buffer that compressed bytes are appended to
+     */
+    void finish(std::string& out);
+
+    /**
+     * @brief Number of uncompressed bytes written so far
+     * @return Input byte count
+     */
+    [[nodiscard]] uint64_t bytesIn() const { return bytesIn_; }
+
+    /**
+     * @brief CRC-32 of the input written so far
+     * @return CRC-32 value
+     */
+    [[nodiscard]] uint32_t crc() const { return crc_; }
+
+    /**
+     * @brief Compress a complete buffer in one call
+     * @param data Pointer to input bytes
+     * @param len Number of input bytes
+     * @param format Stream framing
+     * @param level Compression level 0-9
+     * @return Compressed stream
+     */
+    static std::string compress(const uint8_t* data, size_t len, Format format = Format::Gzip, int level = 9);
+
+    /**
+     * @brief Judge from a sample whether compressing the data is likely to pay off
+     *
+     * Estimates the entropy of the sample's byte distribution: data that uses
+     * nearly all 8 bits of every byte (compressed media, archives, encrypted
+     * files) would cost CPU time for no gain. Meant for the first block of a
+     * stream, so the decision is made before any of it is sent.
+     * @param data Sample bytes
+     * @param len Sample length
+     * @return true if the sample looks compressible
+     */
+    static bool looksCompressible(const uint8_t* data, size_t len);
+
+private:
+    Format format_;
+    int maxChain_;
+    uint32_t niceLength_;
+    bool lazy_;
+    bool store_;
+
+    std::vector<uint8_t> window_;  // Match history followed by input not yet compressed
+    size_t pos_ = 0;               // Index in window_ of the first byte not yet tokenized
+    uint64_t base_ = 0;            // Stream offset of window_[0]
+    std::vector<int64_t> head_;    // Hash -> most recent stream offset
+    std::vector<int64_t> prev_;    // Stream offset (mod window) -> previous offset with the same hash
+    std::vector<uint32_t> tokens_; // Literal (dist 0) or dist << 16 | length, for the current block
+    size_t blockStart_ = 0;        // Index in window_ where the current block's input starts
+
+    uint64_t bitBuffer_ = 0;
+    unsigned bitCount_ = 0;
+    std::string pending_;          // Completed output not yet handed to the caller
+
+    uint64_t bytesIn_ = 0;
+    uint32_t crc_ = 0;
+    uint32_t adler_ = 1;
+    bool headerWritten_ = false;
+    bool finished_ = false;
+
+    void writeHeader();
+    void compressAvailable(bool all);
+    void tokenize(size_t limit, size_t end);
+    void insertHash(size_t index);
+    uint32_t longestMatch(size_t index, size_t end, uint32_t prevLength, uint32_t& distance) const;
+    void emitBlock(bool final, size_t blockEnd);
+    void emitStored(bool final, const uint8_t* data, size_t len);
+    void slideWindow();
+    void putBits(uint32_t bits, unsigned count);
+    void alignToByte();
+    void drain(std::string& out);
+};
+
+} // namespace blade
+
+#endif // BLADE_DEFLATE_ENCODER_H
@@ -0,0 +1,119 @@
+#ifndef BLADE_DELTA_PATCHER_H
+#define BLADE_DELTA_PATCHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PositionalFile.h"
+
+namespace blade {
+
+/**
+ * @brief rsync-style delta transfer against a file the receiver already has
+ *
+ * The receiver describes its copy (the basis) by a signature: for every
+ * complete block of the basis a rolling weak checksum and a truncated
+ * SHA-256. The sender slides a window over the new version, looks each
+ * position's weak checksum up in the signature, confirms candidates with the
+ * strong hash and sends the new version as a stream of operations:
+ *
+ *   0x01 COPY  u32 first block, u32 block count   (blocks of the basis)
+ *   0x02 DATA  u32 length, then that many bytes    (literal data)
+ *
+ * all little-endian. The patcher consumes that stream as it arrives and
+ * writes the new version front to back, so unchanged regions cost a few
+ * bytes on the wire however large they are.
+ *
+ * Signature layout: "BLDS", u32 block size, u64 basis size, i64 basis
+ * modification time (both echoed back by the sender to detect a changed basis),
+ * then per block a u32 weak checksum and 16 bytes of SHA-256.
+ */
+class DeltaPatcher {
+public:
+    static constexpr uint32_t MIN_BLOCK_SIZE = 2 * 1024;
+    static constexpr uint32_t MAX_BLOCK_SIZE = 128 * 1024;
+    static constexpr size_t STRONG_SIZE = 16;
+
+    /**
+     * @brief Block size for a basis: about the square root of its size, as rsync picks it
+     * @param size Basis size in bytes
+     * @return Power of two between MIN_BLOCK_SIZE and MAX_BLOCK_SIZE
+     */
+    static uint32_t blockSizeFor(uint64_t size);
+
+    /**
+     * @brief rsync's rolling checksum of a block (two 16-bit sums, Adler-32 without the modulus)
+     * @param data Pointer to data
+     * @param len Length of data
+     * @return Checksum, first sum in the low half
+     */
+    static uint32_t weakChecksum(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Compute the signature of a basis file
+     * @param basis Open basis file
+     * @param size Basis size
+     * @param modified Basis modification time (file_time_type ticks)
+     * @param out Receives the signature
+     * @return false on a read error
+     */
+    static bool signature(const PositionalFile& basis, uint64_t size, int64_t modified, std::string& out);
+
+    /**
+     * @brief Prepare to rebuild a file from a delta
+     * @param basis Open basis file
+     * @param basisSize Basis size the signature was computed for
+     * @param output File the new version is written to, from offset 0
+     * @param outputSize Size of the new version
+     */
+    DeltaPatcher(std::shared_ptr<PositionalFile> basis, uint64_t basisSize, std::shared_ptr<PositionalFile> output,
+                 uint64_t outputSize);
+
+    /**
+     * @brief Apply the next bytes of the delta stream
+     * @param data Pointer to data
+     * @param len Length of data (operations may be split anywhere)
+     * @return false on a malformed stream, an operation past either file's end or an I/O error
+     */
+    bool write(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Check whether the whole new version has been written
+     * @return true once every byte is in place and no operation is pending
+     */
+    [[nodiscard]] bool isComplete() const;
+
+    /**
+     * @brief Bytes of the new version written so far
+     * @return Byte count
+     */
+    [[nodiscard]] uint64_t produced() const { return produced_; }
+
+    /**
+     * @brief Close the files (e.g. before the output is moved over the basis)
+     */
+    void release();
+
+private:
+    bool execute();
+    bool copyBlocks(uint32_t first, uint32_t count);
+
+    std::shared_ptr<PositionalFile> basis_;
+    std::shared_ptr<PositionalFile> output_;
+    const uint32_t blockSize_;
+    const uint64_t blockCount_;
+    const uint64_t outputSize_;
+
+    uint64_t produced_ = 0;
+    std::array<uint8_t, 9> op_{};  // Operation header being gathered
+    size_t opLength_ = 0;
+    uint64_t literalLeft_ = 0;  // Bytes still to come of the current DATA operation
+    std::vector<uint8_t> copyBuffer_;
+};
+
+} // namespace blade
+
+#endif // BLADE_DELTA_PATCHER_H
@@ -0,0 +1,121 @@
+#ifndef BLADE_DIRECTORY_WALKER_H
+#define BLADE_DIRECTORY_WALKER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace blade {
+
+/**
+ * @brief Parallel enumeration of a directory tree
+ *
+ * A small pool of worker threads takes directories off a shared stack, lists
+ * them and pushes the subdirectories it finds, so the directories of a wide
+ * tree are listed concurrently (which pays off most on network shares and
+ * cold caches) and the first entries are available as soon as the top
+ * directory has been read, long before the whole tree has been seen.
+ *
+ * Entries come out of next() in discovery order, which lists every directory
+ * before its contents; at most a few thousand wait there, so a consumer
+ * slower than the walk holds it back instead of buffering the tree. Running
+ * totals of the files and bytes found are kept as the walk goes. Symbolic
+ * links to directories are not followed; unreadable directories are skipped.
+ */
+class DirectoryWalker {
+public:
+    struct Entry {
+        std::filesystem::path path;
+        std::string name;  // Path below the root's parent, '/' separated, UTF-8 ("root/sub/file")
+        bool directory = false;
+        uint64_t size = 0;
+        std::filesystem::file_time_type modified{};
+    };
+
+    /**
+     * @brief Called from a worker thread with the running totals
+     *
+     * Invoked at most a few times per second while the walk is going, and
+     * once more with finished set when it is complete (not when cancelled).
+     */
+    using ProgressCallback = std::function<void(uint64_t files, uint64_t bytes, bool finished)>;
+
+    /**
+     * @brief Start walking a directory tree in the background
+     * @param root Directory to walk; it is itself the first entry
+     * @param collect Whether entries are handed out through next(); without, only the totals are kept
+     * @param onProgress Optional callback for the running totals
+     */
+    DirectoryWalker(std::filesystem::path root, bool collect, ProgressCallback onProgress = {});
+
+    /**
+     * @brief Cancel the walk and wait for its threads
+     */
+    ~DirectoryWalker();
+
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+    /**
+     * @brief Take the next entry, waiting for the walk to find one
+     * @param entry Receives the entry
+     * @return false once the walk is finished (or cancelled) and every entry was taken
+     */
+    bool next(Entry& entry);
+
+    /**
+     * @brief Check whether next() would return without waiting
+     * @return true if an entry is ready or the walk is over
+     */
+    [[nodiscard]] bool available() const;
+
+    /**
+     * @brief Stop the walk; next() returns false from now on
+     */
+    void cancel();
+
+    [[nodiscard]] uint64_t filesFound() const { return files_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t bytesFound() const { return bytes_.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool finished() const { return finished_.load(std::memory_order_acquire); }
+
+private:
+    struct Directory {
+        std::filesystem::path path;
+        std::string name;
+    };
+
+    void work();
+    void list(const Directory& directory, std::vector<Entry>& batch, std::vector<Directory>& subdirectories);
+    bool publish(std::vector<Entry>& batch, std::vector<Directory>& subdirectories);
+
+    const bool collect_;
+    const ProgressCallback onProgress_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCv_;     // Directories to list, or the walk is over
+    std::condition_variable entriesCv_;  // Entries for next(), or the walk is over
+    std::condition_variable spaceCv_;    // Room in entries_ again
+    std::vector<Directory> directories_;  // Stack: depth first keeps it short
+    std::deque<Entry> entries_;
+    size_t unlisted_ = 0;  // Directories found but not completely listed yet
+    std::chrono::steady_clock::time_point lastProgress_{};
+    bool cancelled_ = false;
+
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<bool> finished_{false};
+
+    std::vector<std::thread> threads_;
+};
+
+} // namespace blade
+
+#endif // BLADE_DIRECTORY_WALKER_H
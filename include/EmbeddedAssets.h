@@ -0,0 +1,34 @@
+#ifndef BLADE_EMBEDDED_ASSETS_H
+#define BLADE_EMBEDDED_ASSETS_H
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace blade {
+
+/**
+ * @brief One file of the web UI compiled into the executable
+ *
+ * Instances are generated at build time by cmake/EmbedWebAssets.cmake; the
+ * content type, validator and date are computed then, so nothing about an
+ * embedded asset has to be derived at runtime.
+ */
+struct EmbeddedAsset {
+    std::string_view path;          // URL path such as "/index.html"
+    std::string_view contentType;
+    std::string_view etag;          // Quoted strong validator of the contents
+    std::string_view lastModified;  // HTTP-date of the source file
+    const unsigned char* data;
+    size_t size;
+};
+
+/**
+ * @brief Web UI bundle compiled into this build
+ * @return All embedded assets, or an empty span if the build was configured without them
+ */
+std::span<const EmbeddedAsset> embeddedAssets();
+
+} // namespace blade
+
+#endif // BLADE_EMBEDDED_ASSETS_H
@@ -0,0 +1,199 @@
+#ifndef BLADE_EVENT_STREAM_H
+#define BLADE_EVENT_STREAM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "NetworkUtils.h"
+#include "WebSocket.h"
+
+namespace blade {
+
+/**
+ * @brief Pushes events to subscribed clients over Server-Sent Events or WebSocket
+ *
+ * Sockets handed over with subscribe() are owned by one stream thread that
+ * writes every published event to all of them: as a text/event-stream frame,
+ * or as a WebSocket text message {"event":..,"data":..}. publish() only
+ * queues the event, so threads reporting changes never wait on a slow client;
+ * an event still queued when another with the same key is published is
+ * replaced, since queue and device events carry a complete snapshot.
+ *
+ * Subscriber sockets are non-blocking and each has its own outgoing queue,
+ * written as far as the socket takes it and resumed when the poller reports
+ * it writable, so a stalled client never holds up the others. Keyed events
+ * are coalesced in that queue as well, which keeps a client that sleeps for
+ * a while (a phone in Wi-Fi power save) at one pending frame per key; it is
+ * dropped only if its queue still grows past MAX_QUEUED_BYTES. A ping event
+ * every PING_INTERVAL lets clients notice a dead connection and lets the
+ * server count subscribers that keep up as alive. A dropped browser
+ * reconnects and is sent fresh snapshots.
+ *
+ * WebSocket subscribers can also send messages. These are handed to the
+ * message callback on a worker thread, since handling one may touch the disk
+ * (an upload announcement preallocates the file), and the reply goes back
+ * through the subscriber's queue. A subscriber with MAX_OUTSTANDING_MESSAGES
+ * unanswered is closed. WebSocket subscribers are sent protocol pings as well
+ * and dropped after STALE_AFTER without any frame from them.
+ */
+class EventStream {
+public:
+    static constexpr auto PING_INTERVAL = std::chrono::seconds(10);
+    static constexpr auto STALE_AFTER = 3 * PING_INTERVAL;
+    static constexpr size_t MAX_SUBSCRIBERS = 64;
+    static constexpr size_t MAX_QUEUED_BYTES = 1024 * 1024;  // Per subscriber
+    static constexpr unsigned MAX_OUTSTANDING_MESSAGES = 8;  // Per subscriber
+
+    enum class Transport {
+        EventSource,  // text/event-stream response
+        WebSocket     // Upgraded connection (RFC 6455)
+    };
+
+    struct Message {
+        std::string event;
+        std::string data;  // JSON
+    };
+
+    using SnapshotCallback = std::function<std::vector<Message>()>;
+    using AliveCallback = std::function<void(const std::string&)>;
+    using MessageCallback = std::function<std::string(const std::string& clientIP, std::string_view message)>;
+
+    /**
+     * @brief Constructor
+     * @param snapshot Returns the events a new subscriber starts with
+     * @param onAlive Called with a subscriber's IP address on every ping it receives
+     * @param onMessage Handles a message from a WebSocket subscriber; a non-empty result is sent back
+     */
+    EventStream(SnapshotCallback snapshot, AliveCallback onAlive, MessageCallback onMessage = {});
+
+    /**
+     * @brief Destructor (stops the stream thread and message worker, closes all subscribers)
+     */
+    ~EventStream();
+
+    EventStream(const EventStream&) = delete;
+    EventStream& operator=(const EventStream&) = delete;
+
+    /**
+     * @brief Start the stream thread (and the message worker if there is a message callback)
+     * @return true if started
+     */
+    bool start();
+
+    /**
+     * @brief Stop the stream thread and message worker, close all subscriber sockets
+     */
+    void stop();
+
+    /**
+     * @brief Take over a socket whose event-stream or handshake response has been sent
+     * @param socket Client socket; owned by the stream from now on
+     * @param clientIP Client address
+     * @param transport How events are framed on this socket
+     * @return false if the stream is not running or full (the socket is then left to the caller)
+     */
+    bool subscribe(SocketType socket, std::string clientIP, Transport transport = Transport::EventSource);
+
+    /**
+     * @brief Queue an event for every subscriber
+     * @param event Event name
+     * @param data Event data (a single line, e.g. JSON)
+     * @param key Coalescing key; a queued event with the same name and key is replaced
+     */
+    void publish(std::string_view event, std::string_view data, std::string_view key = {});
+
+    /**
+     * @brief Check whether anyone would receive a published event
+     * @return true if at least one client is subscribed
+     */
+    [[nodiscard]] bool hasSubscribers() const { return subscriberCount_.load(std::memory_order_relaxed) > 0; }
+
+    /**
+     * @brief Format one event in the text/event-stream syntax
+     * @param event Event name
+     * @param data Event data (a single line)
+     * @return Frame ending in the blank line that dispatches it
+     */
+    static std::string format(std::string_view event, std::string_view data);
+
+    /**
+     * @brief Wrap one event in the JSON envelope sent to WebSocket subscribers
+     * @param event Event name
+     * @param data Event data (JSON)
+     * @return {"event":..,"data":..}
+     */
+    static std::string envelope(std::string_view event, std::string_view data);
+
+private:
+    struct Outgoing {
+        std::string key;    // Coalescing key; empty if the frame must not be replaced
+        std::string frame;  // Encoded for the subscriber's transport
+    };
+    struct Subscriber {
+        uint64_t id;  // Matches replies to the subscriber; sockets are reused
+        SocketType socket;
+        std::string clientIP;
+        Transport transport;
+        WebSocket::FrameParser parser;  // WebSocket only
+        std::chrono::steady_clock::time_point lastSeen;  // Last frame received (WebSocket only)
+        std::deque<Outgoing> queue;   // Not yet (completely) written
+        size_t sent = 0;              // Bytes of queue.front() already written
+        size_t queuedBytes = 0;       // Total size of the frames in queue
+        bool watchingWrite = false;   // Poller reports the socket when writable
+        unsigned outstanding = 0;     // Messages handed to the worker and not yet answered
+    };
+    struct Pending {
+        std::string key;  // Event name and coalescing key
+        Message message;
+    };
+    struct Request {
+        uint64_t subscriber;
+        std::string clientIP;
+        std::string message;
+    };
+    struct Reply {
+        uint64_t subscriber;
+        std::string message;  // Empty if there is nothing to send back
+    };
+
+    SnapshotCallback snapshot_;
+    AliveCallback onAlive_;
+    MessageCallback onMessage_;
+    NetworkUtils::Poller poller_;
+    std::thread thread_;
+    std::thread worker_;  // Runs the message callback
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> subscriberCount_{0};
+
+    std::mutex mutex_;                   // Protects the hand-over lists below
+    std::condition_variable requested_;  // Signals the worker that requests_ has grown
+    std::vector<Subscriber> incoming_;   // Subscribed but not yet adopted by the stream thread
+    std::vector<Pending> pending_;       // Published but not yet written
+    std::deque<Request> requests_;       // Received but not yet handled by the worker
+    std::vector<Reply> replies_;         // Handled but not yet queued for the subscriber
+
+    std::vector<Subscriber> subscribers_;  // Stream thread only
+    uint64_t nextId_ = 1;                  // Guarded by mutex_
+
+    void run();
+    void work();
+    void adopt(std::vector<Subscriber>& incoming);
+    void broadcast(const Message& message, std::string_view key);
+    bool enqueue(Subscriber& subscriber, std::string_view key, std::string frame);
+    bool flush(Subscriber& subscriber);
+    bool deliver(Subscriber& subscriber, std::string_view key, std::string frame);
+    bool receive(Subscriber& subscriber);
+    void ping();
+    void drop(size_t index);
+};
+
+} // namespace blade
+
+#endif // BLADE_EVENT_STREAM_H
@@ -0,0 +1,163 @@
+#ifndef BLADE_HTTP_REQUEST_PARSER_H
+#define BLADE_HTTP_REQUEST_PARSER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace blade {
+
+/**
+ * @brief Incremental parser for an HTTP/1.x request head
+ *
+ * parse() is called with the connection's receive buffer every time more
+ * bytes arrive and resumes where the previous call stopped, so each received
+ * byte is examined a constant number of times no matter how the head is split
+ * across reads. The request line and header fields are recorded as offsets
+ * into the buffer; no memory is allocated. Accessors return views into the
+ * buffer most recently passed to parse() or rebase().
+ */
+class HTTPRequestParser {
+public:
+    enum class Status {
+        Incomplete,  // Need more bytes
+        Complete,    // Head parsed; the body starts at headSize()
+        Error        // Malformed head or too many header fields
+    };
+
+    static constexpr size_t MAX_FIELDS = 64;
+
+    /**
+     * @brief Continue parsing with the bytes received so far
+     * @param data Start of the receive buffer (may have moved since the last call)
+     * @param len Number of bytes in the buffer
+     * @return Parse status
+     */
+    Status parse(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Point the views at a buffer holding the same bytes at a new address
+     * @param data Start of the receive buffer
+     */
+    void rebase(const uint8_t* data) { base_ = reinterpret_cast<const char*>(data); }
+
+    /**
+     * @brief Forget the current request so the next one can be parsed
+     */
+    void reset();
+
+    /**
+     * @brief Current parse status
+     * @return Status of the last parse() call
+     */
+    [[nodiscard]] Status status() const { return status_; }
+
+    /**
+     * @brief Size of the request head including the blank line
+     * @return Offset of the first body byte (valid once Complete)
+     */
+    [[nodiscard]] size_t headSize() const { return pos_; }
+
+    /**
+     * @brief Request method
+     * @return Method such as "GET"
+     */
+    [[nodiscard]] std::string_view method() const { return view(method_); }
+
+    /**
+     * @brief Request target as sent
+     * @return Target including any query string
+     */
+    [[nodiscard]] std::string_view target() const { return view(target_); }
+
+    /**
+     * @brief Protocol version from the request line
+     * @return Version such as "HTTP/1.1"
+     */
+    [[nodiscard]] std::string_view version() const { return view(version_); }
+
+    /**
+     * @brief Request target without the query string
+     * @return Path such as "/api/upload/abc"
+     */
+    [[nodiscard]] std::string_view path() const;
+
+    /**
+     * @brief Query string of the request target
+     * @return Text after '?', or empty
+     */
+    [[nodiscard]] std::string_view query() const;
+
+    /**
+     * @brief Look up a header field by name (case-insensitive)
+     * @param name Field name
+     * @return Value with surrounding whitespace removed, or empty if absent
+     */
+    [[nodiscard]] std::string_view header(std::string_view name) const;
+
+    /**
+     * @brief Look up a header field that must have a single value (case-insensitive)
+     *
+     * Repeated fields are accepted only if every occurrence has the same value,
+     * as RFC 9112 6.3 requires for Content-Length.
+     * @param name Field name
+     * @param value Receives the value with surrounding whitespace removed, or empty if absent
+     * @return false if the field appears with different values
+     */
+    bool uniqueHeader(std::string_view name, std::string_view& value) const;
+
+    /**
+     * @brief Check whether a header field is present (case-insensitive)
+     * @param name Field name
+     * @return true if the request carries the field
+     */
+    [[nodiscard]] bool hasHeader(std::string_view name) const;
+
+    /**
+     * @brief Check whether a comma-separated header lists a token (both case-insensitive)
+     * @param name Field name, e.g. "Connection"
+     * @param token Token to look for, e.g. "close"
+     * @return true if the token is present
+     */
+    [[nodiscard]] bool headerHasToken(std::string_view name, std::string_view token) const;
+
+    /**
+     * @brief Compare two strings ignoring ASCII case
+     * @param a First string
+     * @param b Second string
+     * @return true if equal
+     */
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b);
+
+private:
+    struct Span {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+    struct Field {
+        Span name;
+        Span value;
+    };
+
+    const char* base_ = nullptr;
+    Status status_ = Status::Incomplete;
+    size_t pos_ = 0;      // Start of the first line not yet parsed
+    size_t scanned_ = 0;  // Bytes already searched for the end of that line
+    bool sawRequestLine_ = false;
+    Span method_;
+    Span target_;
+    Span version_;
+    std::array<Field, MAX_FIELDS> fields_;
+    size_t fieldCount_ = 0;
+
+    [[nodiscard]] std::string_view view(const Span span) const {
+        return base_ ? std::string_view(base_ + span.offset, span.length) : std::string_view();
+    }
+    bool parseRequestLine(size_t begin, size_t end);
+    bool parseField(size_t begin, size_t end);
+};
+
+} // namespace blade
+
+#endif // BLADE_HTTP_REQUEST_PARSER_H
@@ -0,0 +1,142 @@
+#ifndef BLADE_HTTP_RESPONSE_WRITER_H
+#define BLADE_HTTP_RESPONSE_WRITER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "NetworkUtils.h"
+
+namespace blade {
+
+/**
+ * @brief Status lines, ready to be sent
+ */
+namespace HttpStatus {
+    constexpr std::string_view SwitchingProtocols = "HTTP/1.1 101 Switching Protocols\r\n";
+    constexpr std::string_view Ok = "HTTP/1.1 200 OK\r\n";
+    constexpr std::string_view NoContent = "HTTP/1.1 204 No Content\r\n";
+    constexpr std::string_view PartialContent = "HTTP/1.1 206 Partial Content\r\n";
+    constexpr std::string_view NotModified = "HTTP/1.1 304 Not Modified\r\n";
+    constexpr std::string_view BadRequest = "HTTP/1.1 400 Bad Request\r\n";
+    constexpr std::string_view Unauthorized = "HTTP/1.1 401 Unauthorized\r\n";
+    constexpr std::string_view NotFound = "HTTP/1.1 404 Not Found\r\n";
+    constexpr std::string_view MethodNotAllowed = "HTTP/1.1 405 Method Not Allowed\r\n";
+    constexpr std::string_view Conflict = "HTTP/1.1 409 Conflict\r\n";
+    constexpr std::string_view RangeNotSatisfiable = "HTTP/1.1 416 Range Not Satisfiable\r\n";
+    constexpr std::string_view TooManyRequests = "HTTP/1.1 429 Too Many Requests\r\n";
+    constexpr std::string_view InternalServerError = "HTTP/1.1 500 Internal Server Error\r\n";
+    constexpr std::string_view InsufficientStorage = "HTTP/1.1 507 Insufficient Storage\r\n";
+}
+
+/**
+ * @brief Header blocks shared by many responses
+ */
+namespace HttpHeaders {
+    constexpr std::string_view Json = "Content-Type: application/json\r\n";
+    constexpr std::string_view PlainText = "Content-Type: text/plain\r\n";
+    constexpr std::string_view OctetStream = "Content-Type: application/octet-stream\r\n";
+    constexpr std::string_view Html = "Content-Type: text/html\r\n";
+    constexpr std::string_view KeepAlive = "Connection: keep-alive\r\nKeep-Alive: timeout=15, max=1000\r\n";
+    constexpr std::string_view Close = "Connection: close\r\n";
+    constexpr std::string_view AcceptRanges = "Accept-Ranges: bytes\r\n";
+    constexpr std::string_view VaryEncoding = "Vary: Accept-Encoding\r\n";
+    constexpr std::string_view GzipEncoding = "Content-Encoding: gzip\r\n";
+    constexpr std::string_view Chunked = "Transfer-Encoding: chunked\r\n";
+}
+
+/**
+ * @brief Assembles a response head and sends it together with the body
+ *
+ * The head is kept as a list of parts: blocks that outlive the writer (status
+ * lines, the constants above, headers prebuilt per asset or policy) are
+ * referenced, and only headers whose value changes per response are formatted,
+ * into a fixed buffer inside the writer. send() hands the parts and the body
+ * to the kernel in one gathered write, so neither the head nor the body is
+ * concatenated into a heap string. Meant to live on the stack for one response.
+ */
+class HTTPResponseWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 1024;  // Formatted headers; longer ones spill to the heap
+    static constexpr size_t MAX_PARTS = 12;      // With the blank line and the body, fits one gathered write
+
+    /**
+     * @brief Constructor
+     * @param statusLine Status line such as HttpStatus::Ok; must outlive send()
+     */
+    explicit HTTPResponseWriter(std::string_view statusLine);
+
+    HTTPResponseWriter(const HTTPResponseWriter&) = delete;
+    HTTPResponseWriter& operator=(const HTTPResponseWriter&) = delete;
+
+    /**
+     * @brief Add complete header lines without copying them
+     * @param block One or more "Name: value\r\n" lines; must outlive send()
+     * @return This writer
+     */
+    HTTPResponseWriter& add(std::string_view block);
+
+    /**
+     * @brief Add a header line, copying name and value
+     * @param name Field name
+     * @param value Field value
+     * @return This writer
+     */
+    HTTPResponseWriter& header(std::string_view name, std::string_view value);
+
+    /**
+     * @brief Add a header line with a decimal value
+     * @param name Field name
+     * @param value Field value
+     * @return This writer
+     */
+    HTTPResponseWriter& header(std::string_view name, uint64_t value);
+
+    /**
+     * @brief Add a Content-Length header
+     * @param length Body size in bytes
+     * @return This writer
+     */
+    HTTPResponseWriter& contentLength(const uint64_t length) { return header("Content-Length", length); }
+
+    /**
+     * @brief Send the head, the blank line and the body in one gathered write
+     * @param socket Socket descriptor
+     * @param body Body bytes (empty for none)
+     * @return true on success, false on error or if too many parts were added
+     */
+    bool send(SocketType socket, std::string_view body = {});
+
+    /**
+     * @brief Send a piece of a body in chunked transfer coding (after a head with HttpHeaders::Chunked)
+     * @param socket Socket descriptor
+     * @param data Chunk data; nothing is framed for empty data
+     * @param last Whether this ends the body: the zero-length last chunk goes out in the same write
+     * @return true on success, false on error
+     */
+    static bool sendChunk(SocketType socket, std::string_view data, bool last = false);
+
+private:
+    enum class Storage : uint8_t { External, Buffer, Spill };
+    struct Part {
+        Storage storage;
+        const char* data;  // External parts only
+        size_t offset;     // Buffer and spill parts only
+        size_t size;
+    };
+
+    std::array<char, BUFFER_SIZE> buffer_;
+    size_t used_ = 0;
+    std::string spill_;  // Formatted headers that did not fit in buffer_
+    std::array<Part, MAX_PARTS> parts_;
+    size_t partCount_ = 0;
+    bool overflow_ = false;
+
+    void append(std::string_view name, std::string_view value);
+    [[nodiscard]] std::string_view view(const Part& part) const;
+};
+
+} // namespace blade
+
+#endif // BLADE_HTTP_RESPONSE_WRITER_H
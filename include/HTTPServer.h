@@ -4,16 +4,58 @@
 #include <string>
 #include <atomic>
 #include <thread>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <unordered_set>
+#include "EventStream.h"
+#include "HTTPRequestParser.h"
 #include "NetworkUtils.h"
+#include "Router.h"
 
 namespace blade {
 
 class Server;
+class UploadSink;
+class StaticAssetCache;
+struct PendingFile;
+
+/**
+ * @brief State of one accepted HTTP client connection
+ */
+struct HTTPConnection {
+    SocketType socket;
+    std::string clientIP;
+    std::vector<uint8_t> buffer;  // Received bytes not yet consumed by a request
+    HTTPRequestParser request;     // Head of the request at the front of buffer, parsed as it arrives
+    std::chrono::steady_clock::time_point lastActivity;
+    size_t loopIndex = 0;          // Event loop that owns the connection between requests
+    unsigned requestsServed = 0;
+    bool keepAlive = false;        // Whether the current request allows the connection to persist
+
+    HTTPConnection(SocketType sock, std::string ip)
+        : socket(sock), clientIP(std::move(ip)), lastActivity(std::chrono::steady_clock::now()) {}
+};
 
 /**
  * @brief HTTP server for serving web interface
  *
  * Serves HTML, CSS, and JavaScript files over HTTP.
+ *
+ * Connections are multiplexed on a fixed set of event-loop threads (one per
+ * core) that read request headers, and small request bodies, as data arrives. Short requests are answered
+ * on the loop thread; long-running uploads and downloads are handed to a
+ * bounded transfer pool so they never stall other clients' requests. Short
+ * requests that may wait on the disk (upload announcements, chunk lists,
+ * delta signatures) have a small control pool of their own, so a full
+ * transfer pool never holds them up.
+ * Clients subscribed to /api/events (Server-Sent Events) or upgraded on
+ * /api/ws (WebSocket) are handed to an EventStream that pushes queue, device
+ * and progress changes as the Server reports them; WebSocket clients also send
+ * control messages such as upload announcements over the same connection.
  */
 class HTTPServer {
 public:
@@ -49,12 +91,55 @@ public:
      */
     [[nodiscard]] bool isRunning() const;
 
+    /**
+     * @brief Re-read the web root into the static asset cache
+     */
+    void reloadStaticAssets();
+
+    /**
+     * @brief Push the pending-file queue to event stream subscribers
+     */
+    void notifyPendingFilesChanged();
+
+    /**
+     * @brief Push the connected-device list to event stream subscribers
+     */
+    void notifyDevicesChanged();
+
+    /**
+     * @brief Push transfer progress to event stream subscribers
+     * @param direction "outgoing" (server to client) or "incoming" (client to server)
+     * @param name File name
+     * @param percent Progress percentage (0-100)
+     */
+    void notifyProgress(std::string_view direction, std::string_view name, int percent);
+
 private:
     int port_;
     std::string webRoot_;
+    std::unique_ptr<StaticAssetCache> assets_;
+    Router router_;
+    std::unique_ptr<EventStream> events_;
+    std::string serverIP_;  // This machine's LAN address, not tracked as a client
     std::atomic<bool> running_;
     std::thread serverThread_;
-    
+
+    // Event loops: each owns a poller and the connections assigned to it
+    struct EventLoop;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::vector<std::thread> loopThreads_;
+
+    // Threads serving the requests of one Executor other than the event loops
+    struct WorkPool {
+        std::vector<std::thread> threads;
+        std::deque<std::unique_ptr<HTTPConnection>> queue;
+        std::unordered_set<SocketType> active;  // Sockets being served, shut down on stop()
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    WorkPool transfers_;  // Uploads and downloads
+    WorkPool controls_;   // Short requests that may wait on the disk
+
     // Reference to main server
     Server* server_;
 
@@ -62,16 +147,80 @@ private:
     bool useAuth_;
     std::string password_;
 
+    // Serialized JSON of a Server collection, valid while the collection's generation is unchanged.
+    // Published through atomic shared pointers, so readers never take the Server's locks for it.
+    struct JsonSnapshot {
+        uint64_t generation;
+        std::string json;
+        std::string etag;
+        std::string gzipJson;  // Empty if the JSON is too small to be worth compressing
+        std::string gzipEtag;
+    };
+    using SnapshotPtr = std::shared_ptr<const JsonSnapshot>;
+    mutable std::atomic<SnapshotPtr> pendingFilesSnapshot_;
+    mutable std::atomic<SnapshotPtr> devicesSnapshot_;
+    std::string etagPrefix_;  // Differs per process so validators never survive a restart
+
     void run();
+    void runLoop(EventLoop& loop);
+    void runPool(WorkPool& pool);
+    void dispatch(std::unique_ptr<HTTPConnection> conn);
+    void serve(std::unique_ptr<HTTPConnection> conn, Executor current);
+    void closeConnection(std::unique_ptr<HTTPConnection> conn) const;
+    [[nodiscard]] bool hasWholeRequest(const HTTPConnection& conn) const;
+    [[nodiscard]] Executor executorFor(const HTTPRequestParser& request) const;
+    [[nodiscard]] bool isAuthorized(const HTTPRequestParser& request) const;
+    [[nodiscard]] bool isRemoteClient(const std::string& clientIP) const;
+    static std::string_view connectionHeader(const HTTPConnection& conn);
+
+    // What an endpoint handler gets to see of the request being served
+    struct RequestContext {
+        const HTTPRequestParser& head;
+        const RouteMatch& match;
+        const std::string& method;
+        const std::string& path;
+        const std::string& query;
+        std::vector<uint8_t>& raw;  // Request head followed by the body bytes received so far
+        size_t bodyStart;
+        uint64_t contentLength;
+    };
 
-    void handleRequest(SocketType clientSocket, const std::string& clientIP) const;
-    void handleFileDownload(SocketType clientSocket, const std::string& filePath) const;
+    // Handlers return true if the connection may be reused for another request
+    bool handleRequest(HTTPConnection& conn) const;
+    bool handleUpload(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleUploadAnnounce(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleUploadSession(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleUploadChunkList(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleUploadSignature(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleUploadDelta(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleLogin(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleHeartbeat(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleDownload(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleArchive(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleStaticFile(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleEvents(HTTPConnection& conn, RequestContext& ctx) const;
+    bool handleWebSocket(HTTPConnection& conn, RequestContext& ctx) const;
+    [[nodiscard]] std::string handleControlMessage(const std::string& clientIP, std::string_view message) const;
+    [[nodiscard]] std::string announceUpload(const std::string& filename, uint64_t fileSize, const std::string& clientIP,
+                                             std::string_view& status) const;
+    static bool sendPreflight(HTTPConnection& conn, const RouteMatch& match);
+    static bool sendJson(HTTPConnection& conn, const RouteOptions& options, std::string_view status, std::string_view json);
+    bool handleUploadChunk(HTTPConnection& conn, const std::string& sessionId, uint64_t offset,
+                           uint64_t contentLength, std::vector<uint8_t>& raw, size_t bodyStart) const;
+    bool receiveUploadBody(HTTPConnection& conn, const std::string& sessionId, std::unique_ptr<UploadSink> sink,
+                           uint64_t contentLength, std::vector<uint8_t>& raw, size_t bodyStart) const;
+    bool handleFileDownload(HTTPConnection& conn, uint64_t transferId, const std::string& filePath, bool headOnly,
+                            std::string_view range, std::string_view ifRange, std::string_view acceptEncoding) const;
+    bool handleFolderDownload(HTTPConnection& conn, const PendingFile& folder, bool headOnly) const;
     static void setSocketTimeout(SocketType socket, int seconds = 5) ;
-    static std::string getContentType(const std::string& path);
-    static std::string loadFile(const std::string& path);
     [[nodiscard]] std::string getAuthConfig() const;
     [[nodiscard]] std::string getConnectedDevicesJson() const;
     [[nodiscard]] std::string getPendingFilesJson() const;
+    [[nodiscard]] SnapshotPtr pendingFilesSnapshot() const;
+    [[nodiscard]] SnapshotPtr devicesSnapshot() const;
+    [[nodiscard]] SnapshotPtr currentSnapshot(std::atomic<SnapshotPtr>& cache, uint64_t generation, char kind,
+                                              std::string (HTTPServer::*build)() const) const;
+    bool sendSnapshot(HTTPConnection& conn, const RequestContext& ctx, const JsonSnapshot& snapshot) const;
 };
 
 } // namespace blade
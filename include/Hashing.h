@@ -0,0 +1,81 @@
+#ifndef BLADE_HASHING_H
+#define BLADE_HASHING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace blade::Hashing {
+
+/**
+ * @brief 64-bit FNV-1a hash (non-cryptographic, used for cache validators)
+ * @param data Pointer to data
+ * @param len Length of data
+ * @param seed Previous hash to continue from
+ * @return Hash value
+ */
+uint64_t fnv1a64(const void* data, size_t len, uint64_t seed = 14695981039346656037ull);
+
+/**
+ * @brief CRC-32 (IEEE 802.3, as used by gzip and ZIP)
+ * @param data Pointer to data
+ * @param len Length of data
+ * @param crc Previous CRC to continue from (0 to start)
+ * @return Updated CRC
+ */
+uint32_t crc32(const void* data, size_t len, uint32_t crc = 0);
+
+/**
+ * @brief Adler-32 checksum (as used by zlib streams)
+ * @param data Pointer to data
+ * @param len Length of data
+ * @param adler Previous checksum to continue from (1 to start)
+ * @return Updated checksum
+ */
+uint32_t adler32(const void* data, size_t len, uint32_t adler = 1);
+
+/**
+ * @brief SHA-1 digest (only for protocols that require it, e.g. the WebSocket handshake)
+ * @param data Pointer to data
+ * @param len Length of data
+ * @return 20-byte digest
+ */
+std::array<uint8_t, 20> sha1(const void* data, size_t len);
+
+/**
+ * @brief SHA-256 digest (strong content hash, e.g. for deduplicating uploaded chunks)
+ * @param data Pointer to data
+ * @param len Length of data
+ * @return 32-byte digest
+ */
+std::array<uint8_t, 32> sha256(const void* data, size_t len);
+
+/**
+ * @brief Incremental SHA-256, for data that arrives or is read in pieces
+ */
+class Sha256 {
+public:
+    /**
+     * @brief Hash the next bytes
+     * @param data Pointer to data
+     * @param len Length of data
+     */
+    void update(const void* data, size_t len);
+
+    /**
+     * @brief Pad the message and return its digest (the object is spent afterwards)
+     * @return 32-byte digest
+     */
+    std::array<uint8_t, 32> finish();
+
+private:
+    uint32_t h_[8] = {0x6a09e667u, 0xbb67ae85u, 0x3c6ef372u, 0xa54ff53au,
+                      0x510e527fu, 0x9b05688cu, 0x1f83d9abu, 0x5be0cd19u};
+    uint8_t block_[64] = {};  // Bytes of an incomplete block
+    size_t blockLength_ = 0;
+    uint64_t length_ = 0;     // Total bytes hashed
+};
+
+} // namespace blade::Hashing
+
+#endif // BLADE_HASHING_H
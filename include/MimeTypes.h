@@ -0,0 +1,58 @@
+#ifndef BLADE_MIME_TYPES_H
+#define BLADE_MIME_TYPES_H
+
+#include <filesystem>
+#include <string_view>
+
+namespace blade {
+
+/**
+ * @brief Maps file extensions to MIME types
+ *
+ * Built-in types live in a sorted constexpr table searched by the lowercased
+ * extension, so a lookup takes a few comparisons and never allocates. A
+ * mime.types file (the format used by Apache and nginx: a type followed by
+ * its extensions, '#' starting a comment) can add types or override
+ * built-in ones at runtime.
+ */
+namespace MimeTypes {
+
+    constexpr std::string_view DEFAULT_TYPE = "application/octet-stream";
+
+    /**
+     * @brief MIME type for a file extension
+     * @param extension Extension without the dot, in any case
+     * @return MIME type, or DEFAULT_TYPE if unknown
+     */
+    std::string_view fromExtension(std::string_view extension);
+
+    /**
+     * @brief MIME type for a file path or name
+     * @param path Path whose last extension is used ("a.tar.gz" maps as "gz")
+     * @return MIME type, or DEFAULT_TYPE if there is no known extension
+     */
+    std::string_view fromPath(std::string_view path);
+
+    /**
+     * @brief Whether content of a type is compressed by its own format
+     *
+     * True for most images, audio and video and for archive-based formats
+     * (ZIP, gzip, OOXML and OpenDocument files, PDF), which compressing for
+     * transfer would only slow down.
+     * @param type MIME type
+     * @return true if the type is known to be compressed already
+     */
+    bool isCompressed(std::string_view type);
+
+    /**
+     * @brief Add the mappings of a mime.types file, overriding built-in ones
+     * @param file Path of the file
+     * @return true if the file was read
+     */
+    bool loadFile(const std::filesystem::path& file);
+
+} // namespace MimeTypes
+
+} // namespace blade
+
+#endif // BLADE_MIME_TYPES_H
@@ -0,0 +1,98 @@
+#ifndef BLADE_MULTIPART_PARSER_H
+#define BLADE_MULTIPART_PARSER_H
+
+#include "ByteSearch.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace blade {
+
+/**
+ * @brief Incremental multipart/form-data parser
+ *
+ * The request body is fed in arbitrary-sized chunks as it arrives from the
+ * socket. Part data is handed to the callbacks as soon as it can be told apart
+ * from a boundary, so the parser only ever holds a partial boundary's worth
+ * of carry-over bytes (or one part's headers) regardless of the body size.
+ */
+class MultipartParser {
+public:
+    /**
+     * @brief Callbacks invoked while parsing; returning false aborts the parse
+     */
+    struct Callbacks {
+        std::function<bool(const std::string& filename)> onPartBegin;
+        std::function<bool(const uint8_t* data, size_t len)> onPartData;
+        std::function<bool()> onPartEnd;
+    };
+
+    /**
+     * @brief Constructor
+     * @param boundary Boundary token from the Content-Type header (without leading dashes)
+     * @param callbacks Part event callbacks
+     */
+    MultipartParser(const std::string& boundary, Callbacks callbacks);
+
+    /**
+     * @brief Feed the next chunk of the body
+     * @param data Pointer to body bytes
+     * @param len Number of bytes
+     * @return false if the body is malformed or a callback aborted
+     */
+    bool feed(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Check whether the closing boundary has been seen
+     * @return true if parsing completed
+     */
+    [[nodiscard]] bool isDone() const;
+
+    /**
+     * @brief Check whether parsing failed
+     * @return true on error
+     */
+    [[nodiscard]] bool hasError() const;
+
+    /**
+     * @brief Number of body bytes consumed so far (including carry-over)
+     * @return Offset into the body of the parser's current position
+     */
+    [[nodiscard]] uint64_t bytesConsumed() const;
+
+    /**
+     * @brief Extract the boundary token from a multipart Content-Type value
+     * @param contentType Content-Type header value
+     * @return Boundary token, or empty string if missing
+     */
+    static std::string boundaryFromContentType(const std::string& contentType);
+
+private:
+    enum class State {
+        Preamble,
+        BoundaryTail,
+        Headers,
+        Body,
+        Done,
+        Error
+    };
+
+    std::string delimiter_;  // "\r\n--" + boundary
+    ByteSearcher delimiterSearch_;
+    ByteSearcher firstBoundarySearch_;  // "--" + boundary, the first boundary has no leading CRLF
+    Callbacks callbacks_;
+    State state_;
+    std::vector<uint8_t> buffer_;  // Unprocessed carry-over bytes
+    uint64_t consumed_;
+
+    bool process();
+    void consume(size_t n);
+    bool fail();
+    static std::string filenameFromHeaders(const std::string& headers);
+};
+
+} // namespace blade
+
+#endif // BLADE_MULTIPART_PARSER_H
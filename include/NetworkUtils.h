@@ -2,12 +2,21 @@
 #define BLADE_NETWORK_UTILS_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <filesystem>
+#include <span>
+#include <string_view>
 
 #ifdef _WIN32
     #include <winsock2.h>
     #include <ws2tcpip.h>
     typedef SOCKET SocketType;
 #else
+    #if !defined(__linux__)
+        #include <poll.h>
+    #endif
     #include <sys/socket.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
@@ -23,7 +32,7 @@
  */
 namespace blade::NetworkUtils {
     /**
-     * @brief Initialize network subsystem (Windows only)
+     * @brief Initialize the network subsystem (Winsock on Windows; ignores SIGPIPE elsewhere)
      * @return true if successful
      */
     bool initialize();
@@ -77,6 +86,12 @@ namespace blade::NetworkUtils {
      * @param socket Socket descriptor
      */
     void closeSocket(SocketType socket);
+
+    /**
+     * @brief Shut down both directions of a socket, waking any thread blocked on it
+     * @param socket Socket descriptor
+     */
+    void shutdownSocket(SocketType socket);
     
     /**
      * @brief Get local IP address
@@ -101,6 +116,13 @@ namespace blade::NetworkUtils {
      */
     int receiveData(SocketType socket, char* buffer, size_t maxSize);
 
+    /**
+     * @brief Disable Nagle's algorithm so small writes go out immediately
+     * @param socket Socket descriptor
+     * @return true on success
+     */
+    bool setNoDelay(SocketType socket);
+
     /**
      * @brief Send all data through socket
      * @param socket Socket descriptor
@@ -110,6 +132,34 @@ namespace blade::NetworkUtils {
      */
     bool sendAll(SocketType socket, const void* data, size_t len);
 
+    /**
+     * @brief Put a socket into non-blocking mode
+     * @param socket Socket descriptor
+     * @return true on success
+     */
+    bool setNonBlocking(SocketType socket);
+
+    /**
+     * @brief Send as much data as a non-blocking socket takes right now
+     * @param socket Socket descriptor (non-blocking)
+     * @param data Pointer to data
+     * @param len Length of data
+     * @return Number of bytes sent, 0 if the send buffer is full, or -1 on error
+     */
+    int sendSome(SocketType socket, const void* data, size_t len);
+
+    /**
+     * @brief Send several buffers through a socket as one gathered write
+     *
+     * Uses sendmsg(2) with an iovec array on POSIX and WSASend() with a WSABUF
+     * array on Windows, so a response head and a body held elsewhere (for
+     * example in read-only data) go out without being copied together first.
+     * @param socket Socket descriptor
+     * @param buffers Buffers to send, in order
+     * @return true on success, false on error
+     */
+    bool sendBuffers(SocketType socket, std::span<const std::string_view> buffers);
+
     /**
      * @brief Receive all data from socket
      * @param socket Socket descriptor
@@ -119,6 +169,110 @@ namespace blade::NetworkUtils {
      */
     bool recvAll(SocketType socket, void* data, size_t len);
 
+    /**
+     * @brief Send a byte range of a file through a socket
+     *
+     * File data goes from the page cache straight to the socket with sendfile(2)
+     * on Linux and TransmitFile() on Windows. If the zero-copy call is not
+     * available or refuses the descriptor, the range is sent through a buffer.
+     * Concurrent downloads of one file share its cached pages, so the file is
+     * read from disk about once however many clients fetch it.
+     * @param socket Socket descriptor
+     * @param path Path of the file to send
+     * @param offset Offset of the first byte to send
+     * @param length Number of bytes to send
+     * @param onProgress Called with the total number of bytes sent so far (optional)
+     * @return Number of bytes sent; less than length on error
+     */
+    uint64_t sendFile(SocketType socket, const std::string& path, uint64_t offset, uint64_t length,
+                      const std::function<void(uint64_t)>& onProgress = {});
+
+    /**
+     * @brief Format a file modification time as an HTTP-date (RFC 9110 5.6.7)
+     * @param modified File modification time
+     * @return Date such as "Sun, 06 Nov 1994 08:49:37 GMT"
+     */
+    std::string formatHttpDate(std::filesystem::file_time_type modified);
+
+    /**
+     * @brief Readiness notification for a set of sockets
+     *
+     * Backed by epoll on Linux and by poll()/WSAPoll() elsewhere. Sockets are
+     * watched for readability, and for writability while watchWritable() is on.
+     * add(), remove(), watchWritable() and wait() must be called from the
+     * owning thread; wakeup() may be called from any thread to interrupt
+     * a blocked wait().
+     */
+    class Poller {
+    public:
+        struct Event {
+            SocketType socket;
+            bool readable;  // Data or EOF is available
+            bool error;     // Hang-up or socket error
+            bool writable;  // Send buffer has room (only while watched)
+        };
+
+        Poller();
+        ~Poller();
+        Poller(const Poller&) = delete;
+        Poller& operator=(const Poller&) = delete;
+
+        /**
+         * @brief Check if the poller was created successfully
+         * @return true if usable
+         */
+        [[nodiscard]] bool isValid() const;
+
+        /**
+         * @brief Start watching a socket for readability
+         * @param socket Socket descriptor
+         * @return true if successful
+         */
+        bool add(SocketType socket);
+
+        /**
+         * @brief Stop watching a socket
+         * @param socket Socket descriptor
+         * @return true if successful
+         */
+        bool remove(SocketType socket);
+
+        /**
+         * @brief Start or stop watching an added socket for writability
+         * @param socket Socket descriptor
+         * @param enable true to report the socket when its send buffer has room
+         * @return true if successful
+         */
+        bool watchWritable(SocketType socket, bool enable);
+
+        /**
+         * @brief Wait for socket events
+         * @param events Output list of ready sockets (cleared first)
+         * @param timeoutMs Timeout in milliseconds (-1 waits forever)
+         * @return Number of events, 0 on timeout or wakeup, -1 on error
+         */
+        int wait(std::vector<Event>& events, int timeoutMs);
+
+        /**
+         * @brief Interrupt a blocked wait() from another thread
+         */
+        void wakeup();
+
+    private:
+#if defined(__linux__)
+        int epollFd_;
+        int wakeFd_;
+#else
+    #ifdef _WIN32
+        using PollFd = WSAPOLLFD;
+    #else
+        using PollFd = pollfd;
+    #endif
+        std::vector<PollFd> fds_;  // fds_[0] is the wakeup socket
+        SocketType wakeSocket_;
+#endif
+    };
+
 }
 
 #endif // BLADE_NETWORK_UTILS_H
@@ -0,0 +1,89 @@
+#ifndef BLADE_POSITIONAL_FILE_H
+#define BLADE_POSITIONAL_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace blade {
+
+/**
+ * @brief File handle for offset-addressed reads and writes
+ *
+ * Every call carries its own offset (pread/pwrite, or overlapped offsets on
+ * Windows), so several threads can read or write disjoint regions of the same
+ * file through one handle without sharing a file pointer or a lock.
+ */
+class PositionalFile {
+public:
+    enum class Mode {
+        Read,       // Existing file, read-only
+        ReadWrite   // Created if missing, never truncated
+    };
+
+    PositionalFile() = default;
+    ~PositionalFile();
+
+    PositionalFile(const PositionalFile&) = delete;
+    PositionalFile& operator=(const PositionalFile&) = delete;
+
+    /**
+     * @brief Open a file
+     * @param path File path
+     * @param mode Access mode
+     * @return true on success
+     */
+    bool open(const std::filesystem::path& path, Mode mode);
+
+    /**
+     * @brief Close the file (also done by the destructor)
+     */
+    void close();
+
+    /**
+     * @brief Check whether the file is open
+     * @return true if open
+     */
+    [[nodiscard]] bool isOpen() const;
+
+    /**
+     * @brief Write a buffer at an absolute offset
+     * @param offset File offset to write at
+     * @param data Pointer to data
+     * @param len Length of data
+     * @return true if all bytes were written
+     */
+    bool writeAt(uint64_t offset, const uint8_t* data, size_t len) const;
+
+    /**
+     * @brief Read into a buffer from an absolute offset
+     * @param offset File offset to read from
+     * @param data Destination buffer
+     * @param len Maximum number of bytes to read
+     * @return Number of bytes read (short only at end of file), or -1 on error
+     */
+    int64_t readAt(uint64_t offset, uint8_t* data, size_t len) const;
+
+    /**
+     * @brief Reserve disk space and set the file length up front
+     *
+     * Parallel writers then fill regions of an already-sized file instead of
+     * extending it out of order, which keeps it from fragmenting. Where the
+     * filesystem can't reserve space cheaply only the length is set; no data
+     * is ever written.
+     * @param size Final file size in bytes
+     * @return true on success
+     */
+    bool preallocate(uint64_t size) const;
+
+private:
+#ifdef _WIN32
+    void* handle_ = nullptr;  // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace blade
+
+#endif // BLADE_POSITIONAL_FILE_H
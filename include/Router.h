@@ -0,0 +1,170 @@
+#ifndef BLADE_ROUTER_H
+#define BLADE_ROUTER_H
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace blade {
+
+/**
+ * @brief HTTP methods as bit flags, so one route can accept several
+ */
+namespace HttpMethod {
+    constexpr unsigned Get = 1u << 0;
+    constexpr unsigned Head = 1u << 1;
+    constexpr unsigned Post = 1u << 2;
+    constexpr unsigned Put = 1u << 3;
+    constexpr unsigned Delete = 1u << 4;
+    constexpr unsigned Options = 1u << 5;
+}
+
+/**
+ * @brief How responses of a route may be cached
+ */
+enum class CachePolicy {
+    NoStore,     // Live data: never cached
+    Revalidate,  // Cached, but checked against the validator on every use
+    Default      // No Cache-Control header
+};
+
+/**
+ * @brief Where the server runs a route's handler
+ */
+enum class Executor {
+    EventLoop,  // Quick and non-blocking: answered on the connection's event loop
+    Control,    // Short but may wait on the disk: a small pool of its own, never queued behind transfers
+    Transfer    // Long-running upload or download: the transfer pool
+};
+
+/**
+ * @brief Per-route behaviour applied by the server around the handler
+ */
+struct RouteOptions {
+    bool cors = true;                          // Allow cross-origin callers (and answer their preflights)
+    CachePolicy cache = CachePolicy::NoStore;
+    bool requiresAuth = false;                 // Needs the login credential when authentication is enabled
+    bool streamsBody = false;                  // Handler reads the request body from the socket itself
+    Executor executor = Executor::EventLoop;
+};
+
+/**
+ * @brief One entry of a route table
+ *
+ * Patterns are absolute paths whose segments are literals, "{name}" for a
+ * single-segment parameter or, as the last segment, "{*name}" for the rest
+ * of the path (possibly empty).
+ */
+struct Route {
+    std::string_view pattern;
+    unsigned methods;      // HttpMethod flags
+    unsigned handler;      // Caller-defined handler identifier
+    RouteOptions options;
+};
+
+/**
+ * @brief Check a route pattern's syntax (usable in static_assert)
+ * @param pattern Route pattern
+ * @return true if well formed
+ */
+constexpr bool isValidRoutePattern(const std::string_view pattern) {
+    if (pattern.empty() || pattern.front() != '/') return false;
+    size_t pos = 1;
+    while (pos <= pattern.size()) {
+        size_t end = pattern.find('/', pos);
+        if (end == std::string_view::npos) end = pattern.size();
+        const std::string_view segment = pattern.substr(pos, end - pos);
+        if (segment.starts_with('{')) {
+            if (segment.size() < 3 || !segment.ends_with('}')) return false;
+            if (segment[1] == '*' && (segment.size() < 4 || end != pattern.size())) return false;
+        } else if (segment.find_first_of("{}") != std::string_view::npos) {
+            return false;
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Result of routing a request
+ */
+struct RouteMatch {
+    static constexpr size_t MAX_PARAMS = 4;
+
+    const Route* route = nullptr;  // Null if no route accepts this method and path
+    unsigned allowedMethods = 0;   // Methods accepted for the path; 0 if the path is unknown
+    std::array<std::string_view, MAX_PARAMS> names{};
+    std::array<std::string_view, MAX_PARAMS> values{};
+    size_t paramCount = 0;
+
+    /**
+     * @brief Value of a path parameter
+     * @param name Parameter name without braces
+     * @return View into the request path, or empty if there is no such parameter
+     */
+    [[nodiscard]] std::string_view param(std::string_view name) const;
+};
+
+/**
+ * @brief Maps request paths to entries of a static route table
+ *
+ * The table is compiled into a segment trie once; matching walks one node per
+ * path segment with a hash lookup for literals, so its cost depends on the
+ * depth of the path rather than on the number of routes. Literal segments
+ * take precedence over parameters, and parameters over catch-alls. Matching
+ * does not allocate; parameters are views into the request path.
+ */
+class Router {
+public:
+    /**
+     * @brief Constructor
+     * @param routes Route table; must outlive the router
+     */
+    explicit Router(std::span<const Route> routes);
+
+    /**
+     * @brief Find the route for a request
+     * @param method Request method
+     * @param path Request path without the query string
+     * @return Match, with route set if one accepts the method
+     */
+    [[nodiscard]] RouteMatch match(std::string_view method, std::string_view path) const;
+
+    /**
+     * @brief Flag for a method name
+     * @param method Method such as "GET"
+     * @return HttpMethod flag, or 0 for methods no route can accept
+     */
+    static unsigned methodFlag(std::string_view method);
+
+    /**
+     * @brief Comma-separated list of method names
+     * @param methods HttpMethod flags
+     * @return List such as "GET, HEAD"
+     */
+    static std::string methodList(unsigned methods);
+
+private:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    struct Node {
+        std::unordered_map<std::string_view, size_t> literals;
+        size_t param = NONE;               // Child for a "{name}" segment
+        std::string_view paramName;
+        std::vector<const Route*> routes;  // Routes whose pattern ends here
+        std::vector<const Route*> rest;    // Routes ending in a "{*name}" segment here
+        std::string_view restName;
+    };
+
+    std::vector<Node> nodes_;
+
+    const std::vector<const Route*>* find(size_t node, std::string_view path, size_t pos, RouteMatch& match) const;
+};
+
+} // namespace blade
+
+#endif // BLADE_ROUTER_H
@@ -11,13 +11,56 @@
 #include <condition_variable>
 #include <thread>
 #include <filesystem>
+#include <optional>
+#include <string_view>
 #include "AuthenticationManager.h"
+#include "ChunkStore.h"
 #include "ConnectionHandler.h"
+#include "DeltaPatcher.h"
+#include "DirectoryWalker.h"
 #include "HTTPServer.h"
+#include "TransferQueue.h"
+#include "UploadSession.h"
 #include <functional>
 
 namespace blade {
 
+/**
+ * @brief Destination for an incoming file that is written as bytes arrive
+ *
+ * Returned by Server::handleUpload(). Data is appended with write(); the file
+ * is only kept once finish() succeeds, otherwise the partial file is removed
+ * when the sink is destroyed.
+ */
+class UploadSink {
+public:
+    virtual ~UploadSink() = default;
+
+    /**
+     * @brief Append a chunk of file data
+     * @param data Pointer to data
+     * @param len Length of data
+     * @return true on success, false on write error
+     */
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+
+    /**
+     * @brief Complete the upload and keep the file
+     * @return true if the file was saved
+     */
+    virtual bool finish() = 0;
+};
+
+/**
+ * @brief Why Server::beginUploadSession() started no session
+ */
+enum class UploadRefusal {
+    None,
+    Unavailable,        // No download directory, or the partial file couldn't be created
+    InsufficientSpace,  // The file wouldn't fit on the download volume
+    TooManySessions     // The client already has the maximum number of unfinished sessions
+};
+
 /**
  * @brief Main Server class that manages network connections
  * 
@@ -58,13 +101,91 @@ public:
     std::string getDownloadDirectory() const;
 
     /**
-     * @brief Handle file upload
+     * @brief Handle file upload by opening a streaming sink in the download directory
      * @param filename Name of the uploaded file
-     * @param data File data as byte vector
-     * @param fileSize Size of the file in bytes (for progress reporting)
-     * @return true if upload was successful
+     * @param fileSize Expected size of the file in bytes (for progress reporting)
+     * @return Sink to stream the file data into, or nullptr on error
+     */
+    std::unique_ptr<UploadSink> handleUpload(const std::string& filename, uint64_t fileSize = 0) const;
+
+    /**
+     * @brief Start a resumable chunked upload session for an announced file
+     * @param filename Name of the file being uploaded
+     * @param fileSize Total size of the file in bytes
+     * @param clientIP Address of the uploading client; each may hold a limited number of unfinished sessions
+     * @param refusal Receives the reason if no session is started
+     * @return Session ID, or empty string if refused
+     */
+    std::string beginUploadSession(const std::string& filename, uint64_t fileSize, const std::string& clientIP,
+                                   UploadRefusal& refusal);
+
+    /**
+     * @brief Open a sink that writes one chunk of an upload session at its offset
+     *
+     * finish() commits the chunk's byte range; the committing chunk that completes
+     * the file moves it into place.
+     * @param sessionId Session ID returned by beginUploadSession()
+     * @param offset Offset of the chunk within the file
+     * @param length Length of the chunk in bytes
+     * @return Sink for the chunk data, or nullptr if the session is unknown or the chunk is out of range
+     */
+    std::unique_ptr<UploadSink> openUploadChunk(const std::string& sessionId, uint64_t offset, uint64_t length);
+
+    /**
+     * @brief Fill an upload session with the chunks the server already has
+     *
+     * The client sends the content-defined chunk list of the file it is about
+     * to upload; every chunk found in the download directory's chunk store is
+     * copied into the session and committed, so the client only has to send
+     * the ranges still missing afterwards. An upload that is an exact copy of
+     * the file already saved under its name completes without a second copy.
+     * @param sessionId Session ID returned by beginUploadSession()
+     * @param offset Offset of the first listed chunk within the file
+     * @param chunks Consecutive chunks of the file from offset on
+     * @return Session JSON as getUploadSessionJson(), or empty string if the session is unknown or the list doesn't fit
+     */
+    std::string fillUploadFromChunkStore(const std::string& sessionId, uint64_t offset,
+                                         const std::vector<ChunkStore::Chunk>& chunks);
+
+    /**
+     * @brief Signature of the saved file an upload session would update
+     *
+     * The basis is the file already saved under the session's name. A client
+     * holding a newer version of it matches its blocks against the signature
+     * and sends only what changed through openUploadDelta().
+     * @param sessionId Session ID returned by beginUploadSession()
+     * @return Signature as DeltaPatcher::signature(), or empty string if there is no basis
      */
-    bool handleUpload(const std::string& filename, const std::vector<uint8_t>& data, size_t fileSize = 0) const;
+    [[nodiscard]] std::string getUploadBasisSignature(const std::string& sessionId) const;
+
+    /**
+     * @brief Open a sink that rebuilds a whole upload from a delta against the saved file
+     *
+     * finish() commits the whole file once every byte has been produced and
+     * the result hashes to the digest of the client's file.
+     * @param sessionId Session ID returned by beginUploadSession()
+     * @param basisModified Basis modification time from the signature
+     * @param basisSize Basis size from the signature
+     * @param digest SHA-256 of the whole new version
+     * @param replace Save the result over the basis instead of next to it
+     * @return Sink for the delta stream, or nullptr if the session is unknown or the basis changed
+     */
+    std::unique_ptr<UploadSink> openUploadDelta(const std::string& sessionId, int64_t basisModified, uint64_t basisSize,
+                                                const ChunkStore::Digest& digest, bool replace);
+
+    /**
+     * @brief Describe an upload session and its committed byte ranges
+     * @param sessionId Session ID
+     * @return JSON object, or empty string if the session is unknown
+     */
+    [[nodiscard]] std::string getUploadSessionJson(const std::string& sessionId) const;
+
+    /**
+     * @brief Abort an upload session and delete its partial file
+     * @param sessionId Session ID
+     * @return true if the session existed
+     */
+    bool cancelUploadSession(const std::string& sessionId);
 
     /**
      * @brief Stop the server
@@ -91,21 +212,90 @@ public:
 
     /**
      * @brief Queue files to be sent to connected client via HTTP
-     * @param filePaths Vector of file paths to send
+     *
+     * Folders are queued at once, as a single entry that downloads as a tar
+     * stream; their total size is filled in by a background scan.
+     * @param filePaths Vector of file and folder paths to send
      */
     void sendFilesToClient(const std::vector<std::string>& filePaths);
 
     /**
      * @brief Get list of pending files for download
-     * @return Vector of file paths queued for download
+     * @return Files queued for download, in queue order
+     */
+    [[nodiscard]] std::vector<PendingFile> getPendingFiles() const;
+
+    /**
+     * @brief Get one pending file by its transfer ID
+     * @param id Transfer ID
+     * @return The file, or nullopt if it is not queued
      */
-    [[nodiscard]] std::vector<std::string> getPendingFiles() const;
+    [[nodiscard]] std::optional<PendingFile> getPendingFile(uint64_t id) const;
+
+    /**
+     * @brief Update a pending file's record after its metadata was read anew
+     * @param id Transfer ID
+     * @param size Current size
+     * @param modified Current modification time
+     */
+    void updatePendingFile(uint64_t id, uint64_t size, std::filesystem::file_time_type modified);
+
+    /**
+     * @brief Record the running totals of a queued folder's background scan
+     * @param id Transfer ID
+     * @param files Files found so far
+     * @param bytes Bytes found so far
+     * @param finished Whether the scan is complete
+     */
+    void updatePendingFolder(uint64_t id, uint64_t files, uint64_t bytes, bool finished);
+
+    /**
+     * @brief Re-read the metadata of every pending file, dropping files that no longer exist
+     */
+    void revalidatePendingFiles();
+
+    /**
+     * @brief Get the generation of the pending file queue
+     *
+     * Incremented on every change of the queue, so a serialized copy tagged
+     * with the generation it was built from stays valid while this is equal.
+     * @return Current generation
+     */
+    [[nodiscard]] uint64_t pendingFilesGeneration() const {
+        return pendingFilesGeneration_.load(std::memory_order_acquire);
+    }
 
     /**
      * @brief Remove a file from the pending queue
-     * @param filePath Path of file to remove
+     * @param id Transfer ID
      */
-    void removePendingFile(const std::string& filePath);
+    void removePendingFile(uint64_t id);
+
+    /**
+     * @brief Mark a pending file as being downloaded
+     *
+     * Every call must be paired with endPendingFileDownload(); the file stays
+     * in flight while any of its downloads runs.
+     * @param id Transfer ID
+     * @return false if the file is not queued
+     */
+    bool beginPendingFileDownload(uint64_t id);
+
+    /**
+     * @brief Record the byte range a download delivered and end it
+     *
+     * Downloads may be split across several (resumed or concurrent) requests,
+     * so a file only leaves the pending queue once every byte of it has been
+     * delivered. A file whose last running download broke off is marked
+     * failed and stays queued for the client to resume.
+     * @param id Transfer ID
+     * @param begin First byte delivered
+     * @param end One past the last byte delivered
+     * @param interrupted Whether the download ended before its range was sent
+     * @param deliveredPct Receives the percentage of the file delivered so far
+     * @return State of the transfer afterwards; Done once it has been dequeued
+     */
+    TransferState endPendingFileDownload(uint64_t id, uint64_t begin, uint64_t end, bool interrupted, int& deliveredPct);
 
     /**
      * @brief Check if there are connected HTTP clients
@@ -119,6 +309,14 @@ public:
      */
     std::vector<std::string> getConnectedDevices() const;
 
+    /**
+     * @brief Get the generation of the connected device list
+     * @return Counter incremented on every change of the list
+     */
+    [[nodiscard]] uint64_t connectedDevicesGeneration() const {
+        return connectedDevicesGeneration_.load(std::memory_order_acquire);
+    }
+
     /**
      * @brief Track an HTTP client connection
      * @param clientIP IP address of the HTTP client
@@ -182,7 +380,8 @@ private:
     int port_;
     bool useAuth_;
     std::string downloadDir_;
-    mutable std::mutex downloadDirMutex_;  // Protects downloadDir_
+    std::shared_ptr<ChunkStore> chunkStore_;  // Index of the files saved in downloadDir_
+    mutable std::mutex downloadDirMutex_;  // Protects downloadDir_ and chunkStore_
     std::atomic<bool> running_;
 
     
@@ -207,8 +406,17 @@ private:
     mutable std::mutex cbMutex_;
 
     // Pending files queue for HTTP-based download
-    std::vector<std::string> pendingFiles_;
+    TransferQueue pendingFiles_;
     mutable std::mutex pendingFilesMutex_;
+    std::atomic<uint64_t> pendingFilesGeneration_{0};  // Bumped under pendingFilesMutex_ on every change
+
+    // Background size scans of queued folders by transfer ID
+    std::unordered_map<uint64_t, std::unique_ptr<DirectoryWalker>> folderScans_;
+    std::mutex folderScansMutex_;
+
+    // Resumable chunked uploads by session ID
+    std::unordered_map<std::string, std::shared_ptr<UploadSession>> uploadSessions_;
+    mutable std::mutex uploadSessionsMutex_;
 
     // Track connected client IPs for clean logging
     std::unordered_set<std::string> connectedIPs_;
@@ -217,6 +425,7 @@ private:
     std::unordered_map<std::string, std::chrono::steady_clock::time_point> httpClientActivity_;
 
     mutable std::mutex ipMutex_;
+    std::atomic<uint64_t> connectedDevicesGeneration_{0};  // Bumped under ipMutex_ when connectedIPs_ changes
     mutable std::mutex stopMutex_;
     std::condition_variable stopCv_;
 
@@ -225,6 +434,12 @@ private:
 
     void acceptConnections();
     void cleanupInactiveHTTPClients();
+    bool commitUploadChunk(UploadSession& session, uint64_t begin, uint64_t end);
+    bool finalizeUploadSession(UploadSession& session) const;
+    [[nodiscard]] std::shared_ptr<ChunkStore> chunkStore() const;
+    void expireUploadSessions();
+    void startFolderScan(uint64_t id, const std::string& path);
+    void reapFolderScans(bool all);
 };
 
 } // namespace blade
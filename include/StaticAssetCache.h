@@ -0,0 +1,93 @@
+#ifndef BLADE_STATIC_ASSET_CACHE_H
+#define BLADE_STATIC_ASSET_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace blade {
+
+struct EmbeddedAsset;
+
+/**
+ * @brief One file of the web UI, ready to be sent
+ */
+struct StaticAsset {
+    std::string contentType;
+    std::string_view body;      // Into the executable's read-only data, or into storage
+    std::string storage;        // Owns body for files read from disk
+    std::string gzipBody;       // Empty if compression does not pay off
+    std::string etag;           // Strong validator of body
+    std::string gzipEtag;       // Strong validator of gzipBody
+    std::string lastModified;   // HTTP-date
+    std::string headers;        // Prebuilt representation headers for body, ETag included
+    std::string gzipHeaders;    // Prebuilt representation headers for gzipBody
+    std::filesystem::file_time_type modified;
+    uint64_t size = 0;          // Size on disk, used with modified to detect changes
+};
+
+/**
+ * @brief In-memory copy of the web root
+ *
+ * Every file under the root is read once, given a content hash ETag and, for
+ * text formats, a gzip-precompressed variant. Requests are answered from the
+ * current snapshot without touching the disk; the root is re-scanned for
+ * changed modification times at most every couple of seconds, or immediately
+ * on reload(). Only files present in the snapshot can be served, so URL paths
+ * can never escape the web root.
+ *
+ * A cache built from the embedded bundle serves bodies straight out of the
+ * executable's read-only data and never touches the disk; only the gzip
+ * variants are produced, once, at startup.
+ */
+class StaticAssetCache {
+public:
+    /**
+     * @brief Constructor (loads the web root)
+     * @param root Web root directory
+     */
+    explicit StaticAssetCache(std::filesystem::path root);
+
+    /**
+     * @brief Constructor (serves a bundle compiled into the executable)
+     * @param bundle Embedded assets; must outlive the cache
+     */
+    explicit StaticAssetCache(std::span<const EmbeddedAsset> bundle);
+
+    /**
+     * @brief Look up an asset by URL path
+     * @param urlPath Request path such as "/index.html"
+     * @return Asset, or nullptr if there is no such file
+     */
+    std::shared_ptr<const StaticAsset> find(const std::string& urlPath);
+
+    /**
+     * @brief Re-read every file of the web root now (no-op for an embedded bundle)
+     */
+    void reload();
+
+private:
+    using AssetMap = std::unordered_map<std::string, std::shared_ptr<const StaticAsset>>;
+
+    std::filesystem::path root_;  // Empty when serving the embedded bundle
+
+    std::mutex snapshotMutex_;
+    std::shared_ptr<const AssetMap> assets_;
+    std::chrono::steady_clock::time_point lastScan_;
+
+    std::mutex scanMutex_;  // Serializes rescans; readers keep using the old snapshot meanwhile
+
+    void rescan(bool force);
+    std::shared_ptr<const StaticAsset> loadAsset(const std::filesystem::path& path, std::filesystem::file_time_type modified,
+                                                 uint64_t size) const;
+};
+
+} // namespace blade
+
+#endif // BLADE_STATIC_ASSET_CACHE_H
@@ -0,0 +1,74 @@
+#ifndef BLADE_TAR_WRITER_H
+#define BLADE_TAR_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace blade {
+
+/**
+ * @brief Streaming POSIX tar (ustar with pax extensions) encoder
+ *
+ * Each entry is a 512-byte header followed by its data padded to a multiple
+ * of 512 bytes, so an archive can be produced front to back while the files
+ * are being read, with nothing held back for the end. Names longer than the
+ * 100-byte ustar field, names that are not plain ASCII and files of 8 GB and
+ * more get a pax extended header that carries the exact path (UTF-8) and size.
+ */
+class TarWriter {
+public:
+    /**
+     * @brief Start an entry and append its header(s)
+     * @param name Path of the entry inside the archive ('/' separated, UTF-8)
+     * @param modified Modification time recorded for the entry
+     * @param size Size of the file's data; ignored for directories
+     * @param directory Whether the entry is a directory
+     * @param out Buffer the headers are appended to
+     */
+    void beginEntry(std::string_view name, std::filesystem::file_time_type modified, uint64_t size,
+                    bool directory, std::string& out);
+
+    /**
+     * @brief Add data to the current entry
+     * @param data Pointer to data
+     * @param len Number of bytes; the entry never takes more than its announced size
+     * @param out Buffer the data is appended to
+     */
+    void write(const uint8_t* data, size_t len, std::string& out);
+
+    /**
+     * @brief End the current entry and append its padding
+     *
+     * The header has promised the entry's size, so exactly that much data
+     * must have been written; a file that shrank meanwhile is made up with
+     * zero bytes by the caller to keep the archive readable, as tar does.
+     * @param out Buffer the padding is appended to
+     */
+    void endEntry(std::string& out);
+
+    /**
+     * @brief Append the end-of-archive marker; no entry may follow
+     * @param out Buffer the marker is appended to
+     */
+    void finish(std::string& out);
+
+    /**
+     * @brief Number of archive bytes appended to the caller's buffers so far
+     * @return Byte count
+     */
+    [[nodiscard]] uint64_t bytesOut() const { return offset_; }
+
+private:
+    uint64_t offset_ = 0;
+
+    // Current entry
+    uint64_t size_ = 0;
+    uint64_t written_ = 0;
+};
+
+} // namespace blade
+
+#endif // BLADE_TAR_WRITER_H
@@ -0,0 +1,111 @@
+#ifndef BLADE_TRANSFER_QUEUE_H
+#define BLADE_TRANSFER_QUEUE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "ByteRangeSet.h"
+
+namespace blade {
+
+/**
+ * @brief Lifecycle of a queued download
+ */
+enum class TransferState {
+    Queued,    // Waiting for a client
+    InFlight,  // At least one download of it is running
+    Done,      // Every byte was delivered; the entry leaves the queue
+    Failed     // A download broke off; the file stays queued and can be resumed
+};
+
+/**
+ * @brief Name of a state as used in the JSON API
+ * @param state Transfer state
+ * @return "queued", "in-flight", "done" or "failed"
+ */
+std::string_view toString(TransferState state);
+
+/**
+ * @brief A file queued for download, with the metadata captured when it was queued
+ *
+ * The file is stat'ed once at enqueue time, so listing the queue never touches
+ * the disk (which may be a slow network share). Records are revalidated
+ * explicitly: when the file is downloaded and periodically in the background.
+ * Folders are the exception: their contents are totalled by a background walk
+ * that starts when they are queued and updates the record as it goes.
+ */
+struct PendingFile {
+    uint64_t id = 0;               // Transfer ID; stable while queued, never reused
+    std::string path;
+    std::string name;              // Display name (the path's file name)
+    std::string_view contentType;  // From MimeTypes, whose strings live as long as the process
+    uint64_t size = 0;
+    std::filesystem::file_time_type modified{};
+    TransferState state = TransferState::Queued;
+
+    // A queued folder is sent as a tar stream; its size is the running total of a background scan
+    bool folder = false;
+    uint64_t fileCount = 0;        // Files found in the folder so far
+    bool scanning = false;         // Whether size and fileCount are still growing
+};
+
+/**
+ * @brief Download queue keyed by transfer ID
+ *
+ * Entries are kept in a list in the order they were queued and indexed by ID
+ * and by path, so lookup, de-duplication and removal take constant time and
+ * iteration follows the queue order. IDs increase monotonically from a value
+ * derived from the start time, so an ID handed out before a restart does not
+ * address a different file afterwards; they stay below 2^53 so JavaScript
+ * numbers hold them exactly. Not thread-safe: the owner locks around it.
+ */
+class TransferQueue {
+public:
+    struct Entry {
+        PendingFile file;
+        ByteRangeSet delivered;       // Bytes served so far, over all (resumed) downloads
+        unsigned activeDownloads = 0;
+    };
+
+    TransferQueue();
+
+    /**
+     * @brief Queue a file unless its path is already queued
+     * @param file Record to queue; its id and state are assigned here
+     * @return The new transfer ID, or 0 if the path was already queued
+     */
+    uint64_t push(PendingFile file);
+
+    /**
+     * @brief Find an entry by transfer ID
+     * @param id Transfer ID
+     * @return The entry, or nullptr if not queued
+     */
+    [[nodiscard]] Entry* find(uint64_t id);
+    [[nodiscard]] const Entry* find(uint64_t id) const;
+
+    /**
+     * @brief Remove an entry
+     * @param id Transfer ID
+     * @return true if it was queued
+     */
+    bool erase(uint64_t id);
+
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+    [[nodiscard]] bool empty() const { return entries_.empty(); }
+    [[nodiscard]] auto begin() const { return entries_.cbegin(); }
+    [[nodiscard]] auto end() const { return entries_.cend(); }
+
+private:
+    std::list<Entry> entries_;  // Queue order; list iterators stay valid across insertions and removals
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> byId_;
+    std::unordered_map<std::string, uint64_t> byPath_;
+    uint64_t nextId_;
+};
+
+} // namespace blade
+
+#endif // BLADE_TRANSFER_QUEUE_H
@@ -0,0 +1,141 @@
+#ifndef BLADE_UPLOAD_SESSION_H
+#define BLADE_UPLOAD_SESSION_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "ByteRangeSet.h"
+#include "PositionalFile.h"
+
+namespace blade {
+
+/**
+ * @brief State of one resumable, chunked upload
+ *
+ * Chunks are written at their offsets into a hidden, preallocated partial file
+ * next to the final destination. Several connections may write chunks of the
+ * same session in parallel through the shared positional file handle. The
+ * session records which byte ranges have been committed so a client can ask
+ * what is missing after a dropped connection and only send that. Once every
+ * byte is present the partial file is renamed into place.
+ */
+class UploadSession {
+public:
+    /**
+     * @brief Constructor
+     * @param id Session identifier handed to the client
+     * @param name Sanitized file name shown in the UI
+     * @param partPath Path of the partial file the chunks are written to
+     * @param size Total size of the file in bytes
+     * @param file Open handle of the partial file
+     * @param clientIP Address of the client that started the upload
+     */
+    UploadSession(std::string id, std::string name, std::filesystem::path partPath, uint64_t size,
+                  std::shared_ptr<PositionalFile> file, std::string clientIP);
+
+    [[nodiscard]] const std::string& id() const { return id_; }
+    [[nodiscard]] const std::string& clientIP() const { return clientIP_; }
+    [[nodiscard]] const std::string& name() const { return name_; }
+    [[nodiscard]] const std::filesystem::path& partPath() const { return partPath_; }
+    [[nodiscard]] uint64_t size() const { return size_; }
+
+    /**
+     * @brief Handle of the partial file shared by all chunk writers
+     * @return File handle, or nullptr once the upload has been finalized
+     */
+    [[nodiscard]] std::shared_ptr<PositionalFile> file() const;
+
+    /**
+     * @brief Account bytes written by chunks that are still in flight
+     *
+     * Progress is the sum over all parallel streams of committed and in-flight
+     * bytes, held below 100% until the file has been finalized.
+     * @param delta Bytes written (negative to retract an abandoned or committed chunk)
+     * @return New progress percentage if it grew since the last report, otherwise -1
+     */
+    int addInFlight(int64_t delta);
+
+    /**
+     * @brief Record a chunk that has been written to the partial file
+     * @param begin First byte of the chunk
+     * @param end One past the last byte of the chunk
+     * @return Number of bytes committed so far
+     */
+    uint64_t commit(uint64_t begin, uint64_t end);
+
+    /**
+     * @brief Check whether every byte of the file has been committed
+     * @return true if the partial file is complete
+     */
+    [[nodiscard]] bool isFilled() const;
+
+    /**
+     * @brief Have the finished file replace the saved file of the same name
+     *
+     * Set for updated versions sent as a delta, once the result is verified
+     * and if the client asked for it; otherwise the file is saved
+     * next to an existing one under a numbered name.
+     */
+    void setReplaceExisting();
+
+    /**
+     * @brief Check whether the finished file replaces the saved file of the same name
+     * @return true if it does
+     */
+    [[nodiscard]] bool replacesExisting() const;
+
+    /**
+     * @brief Mark the session finished once the file has been moved into place
+     *
+     * Drops the session's file handle; writers still holding it close it when they finish.
+     * @param finalPath Path of the saved file
+     */
+    void markFinalized(const std::filesystem::path& finalPath);
+
+    /**
+     * @brief Check whether the file has been moved into place
+     * @return true if the upload is complete
+     */
+    [[nodiscard]] bool isFinalized() const;
+
+    /**
+     * @brief Time of the last chunk or status query
+     * @return Last activity timestamp
+     */
+    [[nodiscard]] std::chrono::steady_clock::time_point lastActivity() const;
+
+    /**
+     * @brief Refresh the activity timestamp
+     */
+    void touch();
+
+    /**
+     * @brief Describe the session for the client
+     * @return JSON object with the committed ranges
+     */
+    [[nodiscard]] std::string toJson() const;
+
+private:
+    const std::string id_;
+    const std::string name_;
+    const std::filesystem::path partPath_;
+    const uint64_t size_;
+    const std::string clientIP_;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<PositionalFile> file_;
+    ByteRangeSet committed_;
+    uint64_t inFlight_ = 0;
+    int lastReportedPct_ = 0;
+    std::filesystem::path finalPath_;
+    bool replaceExisting_ = false;
+    bool finalized_ = false;
+    std::chrono::steady_clock::time_point lastActivity_;
+};
+
+} // namespace blade
+
+#endif // BLADE_UPLOAD_SESSION_H
@@ -0,0 +1,121 @@
+#ifndef BLADE_WEB_SOCKET_H
+#define BLADE_WEB_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace blade {
+
+/**
+ * @brief RFC 6455 WebSocket handshake and framing (server side)
+ *
+ * Frames written by the server are never masked; frames from clients must
+ * be. Only what a small control channel needs is supported: text and binary
+ * messages up to MAX_MESSAGE bytes (possibly fragmented), ping/pong and
+ * close. Extensions such as permessage-deflate are not negotiated.
+ */
+namespace WebSocket {
+
+    constexpr size_t MAX_MESSAGE = 64 * 1024;  // Larger messages are refused with close code 1009
+
+    enum class Opcode : uint8_t {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    namespace CloseCode {
+        constexpr uint16_t Normal = 1000;
+        constexpr uint16_t GoingAway = 1001;
+        constexpr uint16_t ProtocolError = 1002;
+        constexpr uint16_t InvalidData = 1007;
+        constexpr uint16_t PolicyViolation = 1008;
+        constexpr uint16_t TooBig = 1009;
+    }
+
+    /**
+     * @brief Sec-WebSocket-Accept value for a handshake
+     * @param clientKey Sec-WebSocket-Key sent by the client
+     * @return Base64 SHA-1 of the key and the RFC 6455 GUID
+     */
+    std::string acceptKey(std::string_view clientKey);
+
+    /**
+     * @brief Check that a Sec-WebSocket-Key is the base64 form of 16 bytes
+     * @param clientKey Header value
+     * @return true if valid
+     */
+    bool isValidKey(std::string_view clientKey);
+
+    /**
+     * @brief Encode one unmasked, final frame
+     * @param opcode Frame opcode
+     * @param payload Frame payload
+     * @return Frame bytes
+     */
+    std::string frame(Opcode opcode, std::string_view payload);
+
+    /**
+     * @brief Encode a close frame
+     * @param code Close status code
+     * @return Frame bytes
+     */
+    std::string closeFrame(uint16_t code);
+
+    /**
+     * @brief Incremental decoder for frames received from a client
+     *
+     * Bytes are appended with feed() as they arrive; next() then returns
+     * complete messages (fragments already joined) and control frames one at
+     * a time, in order. After an Error, closeCode() tells how to close.
+     */
+    class FrameParser {
+    public:
+        enum class Status {
+            Incomplete,  // More bytes are needed
+            Message,     // A message or control frame was returned
+            Error        // Protocol violation; the connection must be closed
+        };
+
+        /**
+         * @brief Append received bytes
+         * @param data Pointer to data
+         * @param len Number of bytes
+         */
+        void feed(const char* data, size_t len);
+
+        /**
+         * @brief Decode the next message or control frame
+         * @param opcode Receives Text, Binary, Close, Ping or Pong
+         * @param payload Receives the unmasked payload
+         * @return Parse status
+         */
+        Status next(Opcode& opcode, std::string& payload);
+
+        /**
+         * @brief Close code describing the last error
+         * @return RFC 6455 status code
+         */
+        [[nodiscard]] uint16_t closeCode() const { return closeCode_; }
+
+    private:
+        std::string buffer_;
+        size_t consumed_ = 0;
+        std::string message_;         // Fragments of the message in progress
+        Opcode messageOpcode_ = Opcode::Text;
+        bool inMessage_ = false;
+        uint16_t closeCode_ = CloseCode::ProtocolError;
+
+        Status fail(uint16_t code);
+    };
+
+} // namespace WebSocket
+
+} // namespace blade
+
+#endif // BLADE_WEB_SOCKET_H
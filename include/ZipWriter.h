@@ -0,0 +1,117 @@
+#ifndef BLADE_ZIP_WRITER_H
+#define BLADE_ZIP_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace blade {
+
+class DeflateEncoder;
+
+/**
+ * @brief Streaming ZIP archive encoder
+ *
+ * Entries are written one after another with no seeking back: each local
+ * header leaves CRC and sizes empty and a data descriptor after the data
+ * carries them, so an archive can be sent while its files are being read.
+ * Only the central directory (about 60 bytes per entry) is held until
+ * finish(). Entries of 4 GB and more, archives past 4 GB and more than
+ * 65535 entries use ZIP64 records. Names are stored as UTF-8.
+ */
+class ZipWriter {
+public:
+    enum class Method : uint16_t {
+        Store = 0,
+        Deflate = 8
+    };
+
+    /**
+     * @brief Name length and size of an entry, for sizing a stored archive up front
+     */
+    struct EntrySize {
+        size_t nameLength;
+        uint64_t size;
+    };
+
+    ZipWriter();
+    ~ZipWriter();
+
+    ZipWriter(const ZipWriter&) = delete;
+    ZipWriter& operator=(const ZipWriter&) = delete;
+
+    /**
+     * @brief Start an entry and append its local header
+     * @param name Path of the entry inside the archive ('/' separated)
+     * @param modified Modification time recorded for the entry
+     * @param size Expected uncompressed size; decides whether the entry needs ZIP64 records
+     * @param method Store or Deflate
+     * @param out Buffer the header is appended to
+     */
+    void beginEntry(std::string_view name, std::filesystem::file_time_type modified, uint64_t size,
+                    Method method, std::string& out);
+
+    /**
+     * @brief Add data to the current entry
+     * @param data Pointer to data
+     * @param len Number of bytes
+     * @param out Buffer the (compressed) data is appended to
+     */
+    void write(const uint8_t* data, size_t len, std::string& out);
+
+    /**
+     * @brief End the current entry and append its data descriptor
+     * @param out Buffer the descriptor is appended to
+     * @return Uncompressed bytes written to the entry
+     */
+    uint64_t endEntry(std::string& out);
+
+    /**
+     * @brief Append the central directory and end records; no entry may follow
+     * @param out Buffer the records are appended to
+     */
+    void finish(std::string& out);
+
+    /**
+     * @brief Number of archive bytes appended to the caller's buffers so far
+     * @return Byte count
+     */
+    [[nodiscard]] uint64_t bytesOut() const { return offset_; }
+
+    /**
+     * @brief Exact size of an archive of stored entries
+     *
+     * A stored archive's size depends only on the names and sizes of its
+     * entries, so it can be announced with Content-Length before any data
+     * has been read.
+     * @param entries Entries in archive order
+     * @return Archive size in bytes
+     */
+    static uint64_t storedSize(std::span<const EntrySize> entries);
+
+private:
+    std::string centralDirectory_;
+    uint64_t entryCount_ = 0;
+    uint64_t offset_ = 0;  // Bytes written so far; local header offsets are taken from it
+
+    // Current entry
+    std::unique_ptr<DeflateEncoder> deflate_;
+    bool zip64_ = false;
+    uint64_t headerOffset_ = 0;
+    uint64_t bytesIn_ = 0;
+    uint64_t bytesCompressed_ = 0;
+    uint32_t crc_ = 0;
+    uint16_t flags_ = 0;
+    uint16_t method_ = 0;
+    uint16_t dosTime_ = 0;
+    uint16_t dosDate_ = 0;
+    std::string name_;
+};
+
+} // namespace blade
+
+#endif // BLADE_ZIP_WRITER_H
@@ -0,0 +1,45 @@
+#include "ByteRangeSet.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace blade {
+
+void ByteRangeSet::add(uint64_t begin, uint64_t end) {
+    if (begin >= end) return;
+
+    // Start from the last range beginning at or before `begin`
+    auto it = ranges_.upper_bound(begin);
+    if (it != ranges_.begin()) {
+        if (const auto prev = std::prev(it); prev->second >= begin) {
+            begin = prev->first;
+            end = std::max(end, prev->second);
+            it = ranges_.erase(prev);
+        }
+    }
+    // Swallow every following range that overlaps or touches the new one
+    while (it != ranges_.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = ranges_.erase(it);
+    }
+    ranges_.emplace(begin, end);
+}
+
+bool ByteRangeSet::covers(const uint64_t begin, const uint64_t end) const {
+    if (begin >= end) return true;
+    const auto it = ranges_.upper_bound(begin);
+    if (it == ranges_.begin()) return false;
+    return std::prev(it)->second >= end;
+}
+
+uint64_t ByteRangeSet::total() const {
+    uint64_t sum = 0;
+    for (const auto& [begin, end] : ranges_) sum += end - begin;
+    return sum;
+}
+
+const std::map<uint64_t, uint64_t>& ByteRangeSet::ranges() const {
+    return ranges_;
+}
+
+} // namespace blade
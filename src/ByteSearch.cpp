@@ -0,0 +1,160 @@
+#include "ByteSearch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define BLADE_SEARCH_SSE2 1
+    #include <emmintrin.h>
+    // AVX2 is compiled per function and chosen at runtime, which needs the GCC/Clang target attribute
+    #if defined(__GNUC__)
+        #define BLADE_SEARCH_AVX2 1
+        #include <immintrin.h>
+    #endif
+#endif
+
+namespace blade {
+
+namespace {
+
+#ifdef BLADE_SEARCH_SSE2
+
+// The vector scanners compare the needle's first and last byte against a block
+// of candidate offsets at once and only memcmp() the middle where both agree,
+// which rejects almost every offset in a multipart body (boundaries start with
+// "\r\n--" but CRLF followed by the boundary's last byte is rare). They stop
+// where a full block would read past the end and leave `pos` at the first
+// offset not examined, so the scalar search finishes the tail.
+
+size_t findSse2(const uint8_t* data, const size_t len, const std::string_view needle, size_t& pos) {
+    const size_t m = needle.size();
+    const __m128i first = _mm_set1_epi8(static_cast<char>(needle.front()));
+    const __m128i last = _mm_set1_epi8(static_cast<char>(needle.back()));
+    size_t p = pos;
+    while (p + m - 1 + 16 <= len) {
+        const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + p));
+        const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + p + m - 1));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+        while (mask != 0) {
+            const size_t i = p + static_cast<size_t>(std::countr_zero(mask));
+            if (std::memcmp(data + i + 1, needle.data() + 1, m - 2) == 0) return i;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    pos = p;
+    return ByteSearcher::npos;
+}
+
+#ifdef BLADE_SEARCH_AVX2
+
+__attribute__((target("avx2")))
+size_t findAvx2(const uint8_t* data, const size_t len, const std::string_view needle, size_t& pos) {
+    const size_t m = needle.size();
+    const __m256i first = _mm256_set1_epi8(static_cast<char>(needle.front()));
+    const __m256i last = _mm256_set1_epi8(static_cast<char>(needle.back()));
+    size_t p = pos;
+    while (p + m - 1 + 32 <= len) {
+        const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + p));
+        const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + p + m - 1));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last))));
+        while (mask != 0) {
+            const size_t i = p + static_cast<size_t>(std::countr_zero(mask));
+            if (std::memcmp(data + i + 1, needle.data() + 1, m - 2) == 0) return i;
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    pos = p;
+    return ByteSearcher::npos;
+}
+
+bool cpuHasAvx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif // BLADE_SEARCH_AVX2
+
+#endif // BLADE_SEARCH_SSE2
+
+// Vectorized part of a search for needles of two or more bytes
+size_t findVector([[maybe_unused]] const uint8_t* data, [[maybe_unused]] const size_t len,
+                  [[maybe_unused]] const std::string_view needle, [[maybe_unused]] size_t& pos) {
+#ifdef BLADE_SEARCH_AVX2
+    if (cpuHasAvx2()) {
+        if (const size_t hit = findAvx2(data, len, needle, pos); hit != ByteSearcher::npos) return hit;
+    }
+#endif
+#ifdef BLADE_SEARCH_SSE2
+    return findSse2(data, len, needle, pos);
+#else
+    return ByteSearcher::npos;
+#endif
+}
+
+size_t findByte(const uint8_t* data, const size_t len, const uint8_t byte, const size_t from) {
+    if (from >= len) return ByteSearcher::npos;
+    const auto* hit = static_cast<const uint8_t*>(std::memchr(data + from, byte, len - from));
+    return hit ? static_cast<size_t>(hit - data) : ByteSearcher::npos;
+}
+
+} // namespace
+
+ByteSearcher::ByteSearcher(const std::string_view needle) : needle_(needle) {
+    const size_t m = needle_.size();
+    shift_.fill(static_cast<uint32_t>(std::max<size_t>(m, 1)));
+    for (size_t k = 0; k + 1 < m; ++k) {
+        shift_[static_cast<uint8_t>(needle_[k])] = static_cast<uint32_t>(m - 1 - k);
+    }
+}
+
+size_t ByteSearcher::find(const uint8_t* data, const size_t len, size_t from) const {
+    const size_t m = needle_.size();
+    if (m == 0 || len < m || from > len - m) return npos;
+    if (m == 1) return findByte(data, len, static_cast<uint8_t>(needle_[0]), from);
+
+    if (const size_t hit = findVector(data, len, needle_, from); hit != npos) return hit;
+    return findHorspool(data, len, from);
+}
+
+size_t ByteSearcher::find(const uint8_t* data, const size_t len, const std::string_view needle, size_t from) {
+    const size_t m = needle.size();
+    if (m == 0 || len < m || from > len - m) return npos;
+    if (m == 1) return findByte(data, len, static_cast<uint8_t>(needle[0]), from);
+
+    if (const size_t hit = findVector(data, len, needle, from); hit != npos) return hit;
+    // Short tail (or no SIMD): anchor on the first byte without building a shift table
+    const size_t last = len - m;
+    while (from <= last) {
+        from = findByte(data, last + 1, static_cast<uint8_t>(needle[0]), from);
+        if (from == npos) return npos;
+        if (std::memcmp(data + from + 1, needle.data() + 1, m - 1) == 0) return from;
+        ++from;
+    }
+    return npos;
+}
+
+size_t ByteSearcher::partialMatchLength(const uint8_t* data, const size_t len) const {
+    const size_t m = needle_.size();
+    for (size_t k = std::min(len, m == 0 ? 0 : m - 1); k > 0; --k) {
+        if (std::memcmp(data + len - k, needle_.data(), k) == 0) return k;
+    }
+    return 0;
+}
+
+size_t ByteSearcher::findHorspool(const uint8_t* data, const size_t len, size_t from) const {
+    const size_t m = needle_.size();
+    const auto lastByte = static_cast<uint8_t>(needle_.back());
+    while (from <= len - m) {
+        const uint8_t c = data[from + m - 1];
+        if (c == lastByte && std::memcmp(data + from, needle_.data(), m - 1) == 0) return from;
+        from += shift_[c];
+    }
+    return npos;
+}
+
+} // namespace blade
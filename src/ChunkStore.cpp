@@ -0,0 +1,354 @@
+#include "ChunkStore.h"
+#include "Hashing.h"
+#include "Logger.h"
+#include "PositionalFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace blade {
+
+namespace {
+
+constexpr std::string_view INDEX_FILE_NAME = ".blade-chunks.idx";
+constexpr std::string_view INDEX_HEADER = "BLADE-CHUNKS 1";
+
+// Cut-point masks over the high bits of the 32-bit gear hash, which depend on the most bytes.
+// Normalized chunking: a stricter mask below the average size, a looser one above it.
+constexpr uint32_t MASK_SMALL = 0xFFFFFC00u;  // 22 bits
+constexpr uint32_t MASK_LARGE = 0xFFFFC000u;  // 18 bits
+
+// Random gear values from xorshift32; clients regenerate the same table
+constexpr std::array<uint32_t, 256> makeGearTable() {
+    std::array<uint32_t, 256> table{};
+    uint32_t state = 0x9E3779B9u;
+    for (auto& value : table) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        value = state;
+    }
+    return table;
+}
+
+constexpr auto GEAR = makeGearTable();
+
+std::string toHex(const ChunkStore::Digest& digest) {
+    constexpr char HEX[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * digest.size());
+    for (const uint8_t b : digest) {
+        hex += HEX[b >> 4];
+        hex += HEX[b & 0xF];
+    }
+    return hex;
+}
+
+std::string utf8Name(const std::filesystem::path& path) {
+    const std::u8string name = path.filename().u8string();
+    return {name.begin(), name.end()};
+}
+
+std::filesystem::path fromUtf8(const std::string_view name) {
+    return {std::u8string(name.begin(), name.end())};
+}
+
+bool statFile(const std::filesystem::path& path, uint64_t& size, int64_t& modified) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    modified = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+template <typename T>
+bool parseNumber(const std::string_view text, T& value) {
+    const auto [ptr, err] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return err == std::errc() && ptr == text.data() + text.size();
+}
+
+} // namespace
+
+size_t ChunkStore::DigestHash::operator()(const Digest& digest) const noexcept {
+    // The digest is uniformly distributed already
+    size_t value;
+    std::memcpy(&value, digest.data(), sizeof(value));
+    return value;
+}
+
+ChunkStore::ChunkStore(std::filesystem::path directory)
+    : directory_(std::move(directory)), indexPath_(directory_ / INDEX_FILE_NAME) {
+    load();
+    indexer_ = std::thread(&ChunkStore::index, this);
+}
+
+ChunkStore::~ChunkStore() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_.store(true, std::memory_order_relaxed);
+    }
+    queueCv_.notify_all();
+    if (indexer_.joinable()) indexer_.join();
+}
+
+size_t ChunkStore::chunkLength(const uint8_t* data, const size_t len) {
+    if (len <= MIN_CHUNK_SIZE) return len;
+    const size_t end = std::min(len, MAX_CHUNK_SIZE);
+    const size_t normal = std::min(end, AVG_CHUNK_SIZE);
+    uint32_t hash = 0;
+    size_t i = MIN_CHUNK_SIZE;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + GEAR[data[i]];
+        if ((hash & MASK_SMALL) == 0) return i + 1;
+    }
+    for (; i < end; ++i) {
+        hash = (hash << 1) + GEAR[data[i]];
+        if ((hash & MASK_LARGE) == 0) return i + 1;
+    }
+    return end;
+}
+
+std::optional<ChunkStore::Digest> ChunkStore::parseDigest(const std::string_view hex) {
+    Digest digest{};
+    if (hex.size() != 2 * digest.size()) return std::nullopt;
+    for (size_t i = 0; i < digest.size(); ++i) {
+        const auto [ptr, err] = std::from_chars(hex.data() + 2 * i, hex.data() + 2 * i + 2, digest[i], 16);
+        if (err != std::errc() || ptr != hex.data() + 2 * i + 2) return std::nullopt;
+    }
+    return digest;
+}
+
+void ChunkStore::addFile(const std::filesystem::path& path) {
+    {
+        std::lock_guard lock(mutex_);
+        queue_.push_back(path);
+    }
+    queueCv_.notify_one();
+}
+
+std::optional<ChunkStore::Location> ChunkStore::find(const Chunk& chunk) {
+    std::lock_guard lock(mutex_);
+    while (true) {
+        std::optional<size_t> stale;
+        for (auto [it, end] = chunks_.equal_range(chunk.digest); it != end; ++it) {
+            const IndexedFile& file = files_[it->second.file];
+            if (!isUnchanged(file)) {
+                stale = it->second.file;
+                break;
+            }
+            const Chunk& indexed = file.chunks[it->second.chunk];
+            if (indexed.length != chunk.length) continue;
+            return Location{directory_ / fromUtf8(file.name), it->second.offset};
+        }
+        if (!stale) return std::nullopt;
+        // Changed or deleted since it was indexed; look again without it
+        drop(*stale);
+    }
+}
+
+bool ChunkStore::isCopyOf(const std::filesystem::path& path, const std::span<const Chunk> chunks) {
+    std::lock_guard lock(mutex_);
+    if (path.parent_path() != directory_) return false;
+    const auto it = filesByName_.find(utf8Name(path));
+    if (it == filesByName_.end()) return false;
+    const IndexedFile& file = files_[it->second];
+    if (!std::ranges::equal(file.chunks, chunks, [](const Chunk& a, const Chunk& b) {
+            return a.length == b.length && a.digest == b.digest;
+        })) {
+        return false;
+    }
+    return isUnchanged(file);
+}
+
+bool ChunkStore::isUnchanged(const IndexedFile& file) const {
+    uint64_t size;
+    int64_t modified;
+    return statFile(directory_ / fromUtf8(file.name), size, modified) && size == file.size && modified == file.modified;
+}
+
+void ChunkStore::insert(IndexedFile file) {
+    std::lock_guard lock(mutex_);
+    // Appended as one record; a torn record at the end is ignored when loading
+    std::error_code ec;
+    const bool created = !std::filesystem::exists(indexPath_, ec);
+    std::ofstream out(indexPath_, std::ios::binary | std::ios::app);
+    if (created) out << INDEX_HEADER << '\n';
+    std::string record = "F " + std::to_string(file.size) + ' ' + std::to_string(file.modified) + ' ' + file.name + '\n';
+    for (const Chunk& chunk : file.chunks) record += toHex(chunk.digest) + ' ' + std::to_string(chunk.length) + '\n';
+    record += "E\n";
+    out << record;
+    if (!out) Logger::getInstance().warning("Failed to update chunk index: " + indexPath_.string());
+
+    link(std::move(file));
+}
+
+void ChunkStore::link(IndexedFile file) {
+    // A file saved again under the same name replaces its old record
+    if (const auto it = filesByName_.find(file.name); it != filesByName_.end()) drop(it->second);
+
+    const size_t id = files_.size();
+    uint64_t offset = 0;
+    for (size_t i = 0; i < file.chunks.size(); ++i) {
+        chunks_.emplace(file.chunks[i].digest, ChunkRef{id, i, offset});
+        offset += file.chunks[i].length;
+    }
+    filesByName_[file.name] = id;
+    files_.push_back(std::move(file));
+}
+
+void ChunkStore::drop(const size_t id) {
+    IndexedFile& file = files_[id];
+    if (!file.live) return;
+    for (const Chunk& chunk : file.chunks) {
+        for (auto [it, end] = chunks_.equal_range(chunk.digest); it != end;) {
+            it = it->second.file == id ? chunks_.erase(it) : std::next(it);
+        }
+    }
+    if (const auto it = filesByName_.find(file.name); it != filesByName_.end() && it->second == id) filesByName_.erase(it);
+    file.live = false;
+    file.chunks.clear();
+    file.chunks.shrink_to_fit();
+}
+
+void ChunkStore::load() {
+    std::ifstream in(indexPath_, std::ios::binary);
+    if (!in) return;
+
+    std::string line;
+    if (!std::getline(in, line) || line != INDEX_HEADER) {
+        Logger::getInstance().warning("Ignoring chunk index in an unknown format: " + indexPath_.string());
+        rewrite();
+        return;
+    }
+
+    size_t records = 0;
+    std::optional<IndexedFile> file;
+    while (std::getline(in, line)) {
+        const std::string_view text(line);
+        if (text.starts_with("F ")) {
+            // "F <size> <modified> <name>"
+            file.reset();
+            const size_t sizeEnd = text.find(' ', 2);
+            const size_t timeEnd = sizeEnd == std::string_view::npos ? sizeEnd : text.find(' ', sizeEnd + 1);
+            if (timeEnd == std::string_view::npos) continue;
+            IndexedFile parsed;
+            parsed.name = std::string(text.substr(timeEnd + 1));
+            if (parseNumber(text.substr(2, sizeEnd - 2), parsed.size) &&
+                parseNumber(text.substr(sizeEnd + 1, timeEnd - sizeEnd - 1), parsed.modified)) {
+                file = std::move(parsed);
+            }
+        } else if (text == "E") {
+            // Complete record; later records for the same name supersede earlier ones
+            ++records;
+            if (file && isUnchanged(*file)) link(std::move(*file));
+            file.reset();
+        } else if (file) {
+            // "<sha256 hex> <length>"
+            const size_t space = text.find(' ');
+            const auto digest = parseDigest(text.substr(0, space));
+            Chunk chunk;
+            if (space == std::string_view::npos || !digest || !parseNumber(text.substr(space + 1), chunk.length)) {
+                file.reset();
+                continue;
+            }
+            chunk.digest = *digest;
+            file->chunks.push_back(chunk);
+        }
+    }
+
+    const size_t live = filesByName_.size();
+    Logger::getInstance().info("Chunk index: " + std::to_string(live) + " files, " + std::to_string(chunks_.size()) +
+                               " chunks in " + directory_.string());
+    // Leave out superseded records and files that changed or disappeared
+    if (records != live) rewrite();
+}
+
+void ChunkStore::rewrite() {
+    const std::filesystem::path temp = indexPath_.string() + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out << INDEX_HEADER << '\n';
+        for (const IndexedFile& file : files_) {
+            if (!file.live) continue;
+            out << "F " << file.size << ' ' << file.modified << ' ' << file.name << '\n';
+            for (const Chunk& chunk : file.chunks) out << toHex(chunk.digest) << ' ' << chunk.length << '\n';
+            out << "E\n";
+        }
+        if (!out) {
+            Logger::getInstance().warning("Failed to write chunk index: " + temp.string());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, indexPath_, ec);
+    if (ec) Logger::getInstance().warning("Failed to replace chunk index: " + ec.message());
+}
+
+void ChunkStore::index() {
+    while (true) {
+        std::filesystem::path path;
+        {
+            std::unique_lock lock(mutex_);
+            queueCv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            path = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        IndexedFile file;
+        const auto start = std::chrono::steady_clock::now();
+        if (!indexFile(path, file) || file.chunks.empty()) continue;
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        Logger::getInstance().debug("Indexed " + std::to_string(file.chunks.size()) + " chunks of " + path.string() +
+                                    " in " + std::to_string(ms) + " ms");
+        insert(std::move(file));
+    }
+}
+
+bool ChunkStore::indexFile(const std::filesystem::path& path, IndexedFile& file) const {
+    if (!statFile(path, file.size, file.modified)) return false;
+    file.name = utf8Name(path);
+
+    PositionalFile in;
+    if (!in.open(path, PositionalFile::Mode::Read)) {
+        Logger::getInstance().warning("Failed to open file for indexing: " + path.string());
+        return false;
+    }
+
+    // Keeps at least one maximum chunk buffered ahead of the cut point until the end of the file
+    std::vector<uint8_t> buffer(2 * MAX_CHUNK_SIZE);
+    size_t begin = 0;
+    size_t end = 0;
+    uint64_t offset = 0;
+    while (offset < file.size) {
+        if (stopping_.load(std::memory_order_relaxed)) return false;
+        if (end - begin < MAX_CHUNK_SIZE && offset + (end - begin) < file.size) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            const int64_t n = in.readAt(offset + end, buffer.data() + end, buffer.size() - end);
+            if (n <= 0) {
+                Logger::getInstance().warning("File shrank while being indexed: " + path.string());
+                return false;
+            }
+            end += static_cast<size_t>(n);
+            continue;
+        }
+        Chunk chunk;
+        chunk.length = chunkLength(buffer.data() + begin, end - begin);
+        chunk.digest = Hashing::sha256(buffer.data() + begin, static_cast<size_t>(chunk.length));
+        file.chunks.push_back(chunk);
+        begin += static_cast<size_t>(chunk.length);
+        offset += chunk.length;
+    }
+
+    // A file written to meanwhile is indexed again when it is saved anew
+    uint64_t size;
+    int64_t modified;
+    return statFile(path, size, modified) && size == file.size && modified == file.modified;
+}
+
+} // namespace blade
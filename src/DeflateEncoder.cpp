@@ -0,0 +1,560 @@
+#include "DeflateEncoder.h"
+#include "Hashing.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+namespace blade {
+
+namespace {
+
+constexpr size_t WINDOW_SIZE = 32768;
+constexpr size_t WINDOW_MASK = WINDOW_SIZE - 1;
+constexpr size_t HASH_BITS = 15;
+constexpr size_t HASH_SIZE = size_t{1} << HASH_BITS;
+constexpr uint32_t MIN_MATCH = 3;
+constexpr uint32_t MAX_MATCH = 258;
+constexpr size_t BLOCK_INPUT = 64 * 1024;       // Input bytes per emitted block
+constexpr size_t MAX_STORED = 65535;            // Largest stored block payload
+
+constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+                                    513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7,
+                                    8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// Length (3..258) -> index into LENGTH_BASE
+constexpr std::array<uint8_t, MAX_MATCH + 1> makeLengthCodes() {
+    std::array<uint8_t, MAX_MATCH + 1> codes{};
+    for (uint8_t code = 0; code < 29; ++code) {
+        const uint32_t end = code == 28 ? MAX_MATCH + 1 : LENGTH_BASE[code + 1];
+        for (uint32_t len = LENGTH_BASE[code]; len < end && len <= MAX_MATCH; ++len) codes[len] = code;
+    }
+    codes[MAX_MATCH] = 28;
+    return codes;
+}
+
+constexpr auto LENGTH_CODES = makeLengthCodes();
+
+unsigned distanceCode(const uint32_t distance) {
+    return static_cast<unsigned>(std::upper_bound(std::begin(DIST_BASE), std::end(DIST_BASE), distance) - std::begin(DIST_BASE)) - 1;
+}
+
+// Huffman code lengths for the given symbol frequencies, limited to maxBits
+std::vector<uint8_t> buildLengths(std::vector<uint32_t> freqs, const unsigned maxBits) {
+    const size_t n = freqs.size();
+    std::vector<uint8_t> lengths(n, 0);
+
+    while (true) {
+        struct Node { uint64_t weight; int left; int right; };
+        std::vector<Node> nodes;
+        using Entry = std::pair<uint64_t, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> heap;
+        for (size_t i = 0; i < n; ++i) {
+            if (freqs[i] == 0) continue;
+            nodes.push_back({freqs[i], -1, static_cast<int>(i)});
+            heap.emplace(freqs[i], static_cast<int>(nodes.size() - 1));
+        }
+        std::fill(lengths.begin(), lengths.end(), 0);
+        if (nodes.size() < 2) {
+            // A decodable code needs two symbols; pad with unused ones
+            if (!nodes.empty()) lengths[static_cast<size_t>(nodes[0].right)] = 1;
+            size_t assigned = nodes.size();
+            for (size_t i = 0; i < n && assigned < 2; ++i) {
+                if (lengths[i] == 0) {
+                    lengths[i] = 1;
+                    ++assigned;
+                }
+            }
+            return lengths;
+        }
+        while (heap.size() > 1) {
+            const auto [wa, a] = heap.top(); heap.pop();
+            const auto [wb, b] = heap.top(); heap.pop();
+            nodes.push_back({wa + wb, a, b});
+            heap.emplace(wa + wb, static_cast<int>(nodes.size() - 1));
+        }
+
+        // Walk the tree to assign depths (leaves have left == -1, symbol in right)
+        unsigned longest = 0;
+        std::vector<std::pair<int, unsigned>> stack{{heap.top().second, 0}};
+        while (!stack.empty()) {
+            const auto [index, depth] = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[static_cast<size_t>(index)];
+            if (node.left < 0) {
+                lengths[static_cast<size_t>(node.right)] = static_cast<uint8_t>(depth);
+                longest = std::max(longest, depth);
+            } else {
+                stack.emplace_back(node.left, depth + 1);
+                stack.emplace_back(node.right, depth + 1);
+            }
+        }
+        if (longest <= maxBits) return lengths;
+
+        // Flatten the distribution and try again
+        for (auto& f : freqs) {
+            if (f != 0) f = (f >> 1) | 1;
+        }
+    }
+}
+
+// Canonical codes (already bit-reversed for LSB-first output) from code lengths
+std::vector<uint16_t> buildCodes(const std::vector<uint8_t>& lengths) {
+    uint16_t count[16] = {};
+    for (const auto len : lengths) if (len) ++count[len];
+    uint16_t next[16] = {};
+    uint16_t code = 0;
+    for (int bits = 1; bits < 16; ++bits) {
+        code = static_cast<uint16_t>((code + count[bits - 1]) << 1);
+        next[bits] = code;
+    }
+    std::vector<uint16_t> codes(lengths.size(), 0);
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        const unsigned len = lengths[i];
+        if (len == 0) continue;
+        uint16_t c = next[len]++;
+        uint16_t reversed = 0;
+        for (unsigned b = 0; b < len; ++b) {
+            reversed = static_cast<uint16_t>((reversed << 1) | (c & 1));
+            c >>= 1;
+        }
+        codes[i] = reversed;
+    }
+    return codes;
+}
+
+const std::vector<uint8_t>& fixedLiteralLengths() {
+    static const std::vector<uint8_t> lengths = [] {
+        std::vector<uint8_t> l(288);
+        for (size_t i = 0; i < 144; ++i) l[i] = 8;
+        for (size_t i = 144; i < 256; ++i) l[i] = 9;
+        for (size_t i = 256; i < 280; ++i) l[i] = 7;
+        for (size_t i = 280; i < 288; ++i) l[i] = 8;
+        return l;
+    }();
+    return lengths;
+}
+
+const std::vector<uint8_t>& fixedDistanceLengths() {
+    static const std::vector<uint8_t> lengths(30, 5);
+    return lengths;
+}
+
+// Run-length encoded code length sequence: symbol | extra value << 8
+std::vector<uint16_t> encodeCodeLengths(const std::vector<uint8_t>& lengths) {
+    std::vector<uint16_t> out;
+    size_t i = 0;
+    while (i < lengths.size()) {
+        const uint8_t value = lengths[i];
+        size_t run = 1;
+        while (i + run < lengths.size() && lengths[i + run] == value) ++run;
+        if (value == 0 && run >= 3) {
+            size_t left = run;
+            while (left >= 3) {
+                const size_t take = std::min<size_t>(left, 138);
+                if (take >= 11) out.push_back(static_cast<uint16_t>(18 | (take - 11) << 8));
+                else out.push_back(static_cast<uint16_t>(17 | (take - 3) << 8));
+                left -= take;
+            }
+            for (size_t k = 0; k < left; ++k) out.push_back(0);
+        } else if (value != 0 && run >= 4) {
+            out.push_back(value);
+            size_t left = run - 1;
+            while (left >= 3) {
+                const size_t take = std::min<size_t>(left, 6);
+                out.push_back(static_cast<uint16_t>(16 | (take - 3) << 8));
+                left -= take;
+            }
+            for (size_t k = 0; k < left; ++k) out.push_back(value);
+        } else {
+            for (size_t k = 0; k < run; ++k) out.push_back(value);
+        }
+        i += run;
+    }
+    return out;
+}
+
+} // namespace
+
+DeflateEncoder::DeflateEncoder(const Format format, int level)
+    : format_(format)
+{
+    level = std::clamp(level, 0, 9);
+    static constexpr int CHAINS[10] = {0, 4, 8, 16, 32, 64, 128, 256, 1024, 4096};
+    static constexpr uint32_t NICE[10] = {0, 8, 16, 32, 64, 128, 128, 192, 258, 258};
+    maxChain_ = CHAINS[level];
+    niceLength_ = NICE[level];
+    lazy_ = level >= 4;
+    store_ = level == 0;
+    if (!store_) {
+        head_.assign(HASH_SIZE, -1);
+        prev_.assign(WINDOW_SIZE, -1);
+    }
+    window_.reserve(WINDOW_SIZE + BLOCK_INPUT + MAX_MATCH);
+}
+
+void DeflateEncoder::write(const uint8_t* data, size_t len, std::string& out) {
+    if (finished_) return;
+    writeHeader();
+    bytesIn_ += len;
+    if (format_ == Format::Gzip) crc_ = Hashing::crc32(data, len, crc_);
+    if (format_ == Format::Zlib) adler_ = Hashing::adler32(data, len, adler_);
+
+    while (len > 0) {
+        // Keep room for a full block plus lookahead so matches can run across the block edge
+        const size_t room = BLOCK_INPUT + MAX_MATCH - (window_.size() - blockStart_);
+        const size_t take = std::min(len, room);
+        window_.insert(window_.end(), data, data + take);
+        data += take;
+        len -= take;
+        if (window_.size() - blockStart_ >= BLOCK_INPUT + MAX_MATCH) compressAvailable(false);
+    }
+    drain(out);
+}
+
+void DeflateEncoder::flush(std::string& out) {
+    if (finished_) return;
+    writeHeader();
+    compressAvailable(true);
+    // Empty stored block: realigns the stream so everything so far can be decoded
+    putBits(0, 3);
+    alignToByte();
+    pending_.append("\x00\x00\xFF\xFF", 4);
+    drain(out);
+}
+
+void DeflateEncoder::finish(std::string& out) {
+    if (finished_) return;
+    writeHeader();
+    if (window_.size() > blockStart_) {
+        // Tokenize the remainder, then close with the final block
+        compressAvailable(true);
+    }
+    putBits(1, 1);  // BFINAL
+    putBits(1, 2);  // Fixed Huffman block containing only end-of-block
+    putBits(0, 7);
+    alignToByte();
+
+    if (format_ == Format::Gzip) {
+        for (int i = 0; i < 4; ++i) pending_.push_back(static_cast<char>((crc_ >> (8 * i)) & 0xFF));
+        for (int i = 0; i < 4; ++i) pending_.push_back(static_cast<char>((bytesIn_ >> (8 * i)) & 0xFF));
+    } else if (format_ == Format::Zlib) {
+        for (int i = 3; i >= 0; --i) pending_.push_back(static_cast<char>((adler_ >> (8 * i)) & 0xFF));
+    }
+    finished_ = true;
+    drain(out);
+}
+
+std::string DeflateEncoder::compress(const uint8_t* data, const size_t len, const Format format, const int level) {
+    DeflateEncoder encoder(format, level);
+    std::string out;
+    out.reserve(len / 2 + 64);
+    encoder.write(data, len, out);
+    encoder.finish(out);
+    return out;
+}
+
+bool DeflateEncoder::looksCompressible(const uint8_t* data, const size_t len) {
+    // Compressed formats measure about 7.9-8 bits per byte, text 4.5-5.5, executables around 6
+    constexpr double MAX_BITS_PER_BYTE = 7.5;
+    if (len == 0) return false;
+    std::array<uint32_t, 256> counts{};
+    for (size_t i = 0; i < len; ++i) ++counts[data[i]];
+    double bits = 0;
+    for (const uint32_t count : counts) {
+        if (count == 0) continue;
+        const double p = static_cast<double>(count) / static_cast<double>(len);
+        bits -= p * std::log2(p);
+    }
+    return bits < MAX_BITS_PER_BYTE;
+}
+
+void DeflateEncoder::writeHeader() {
+    if (headerWritten_) return;
+    headerWritten_ = true;
+    if (format_ == Format::Gzip) {
+        // ID1 ID2 CM=8 FLG=0 MTIME=0 XFL OS=255 (unknown)
+        static constexpr char header[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff'};
+        pending_.append(header, sizeof(header));
+    } else if (format_ == Format::Zlib) {
+        pending_.append("\x78\x9c", 2); // 32KB window, default level, checksum-valid
+    }
+}
+
+// Turns buffered input into tokens and blocks; with `all` set, everything is emitted
+void DeflateEncoder::compressAvailable(const bool all) {
+    while (window_.size() > blockStart_) {
+        const size_t available = window_.size() - blockStart_;
+        if (!all && available < BLOCK_INPUT + MAX_MATCH) break;
+
+        const size_t blockEnd = std::min(window_.size(), blockStart_ + BLOCK_INPUT);
+        if (store_) {
+            pos_ = blockEnd;
+        } else {
+            // Tokens may run past blockEnd into the lookahead; the block then ends where they stop
+            tokenize(blockEnd, window_.size());
+        }
+        emitBlock(false, pos_);
+        blockStart_ = pos_;
+        slideWindow();
+    }
+}
+
+void DeflateEncoder::insertHash(const size_t index) {
+    const uint8_t* p = window_.data() + index;
+    const size_t h = ((static_cast<size_t>(p[0]) << 10) ^ (static_cast<size_t>(p[1]) << 5) ^ p[2]) & (HASH_SIZE - 1);
+    const int64_t abs = static_cast<int64_t>(base_ + index);
+    prev_[static_cast<size_t>(abs) & WINDOW_MASK] = head_[h];
+    head_[h] = abs;
+}
+
+uint32_t DeflateEncoder::longestMatch(const size_t index, const size_t end, const uint32_t prevLength, uint32_t& distance) const {
+    const uint8_t* p = window_.data() + index;
+    const size_t h = ((static_cast<size_t>(p[0]) << 10) ^ (static_cast<size_t>(p[1]) << 5) ^ p[2]) & (HASH_SIZE - 1);
+    const auto abs = static_cast<int64_t>(base_ + index);
+    const auto maxLen = static_cast<uint32_t>(std::min<size_t>(MAX_MATCH, end - index));
+    uint32_t best = prevLength;
+    int chain = maxChain_;
+
+    int64_t candidate = head_[h];
+    while (candidate >= 0 && chain-- > 0) {
+        const int64_t dist = abs - candidate;
+        if (dist <= 0 || dist > static_cast<int64_t>(WINDOW_SIZE) || candidate < static_cast<int64_t>(base_)) break;
+        const uint8_t* q = window_.data() + (static_cast<size_t>(candidate) - base_);
+        if (q[best < maxLen ? best : 0] == p[best < maxLen ? best : 0] && q[0] == p[0]) {
+            uint32_t len = 0;
+            while (len < maxLen && q[len] == p[len]) ++len;
+            if (len > best) {
+                best = len;
+                distance = static_cast<uint32_t>(dist);
+                if (len >= niceLength_ || len == maxLen) break;
+            }
+        }
+        const int64_t next = prev_[static_cast<size_t>(candidate) & WINDOW_MASK];
+        if (next >= candidate) break; // Slot reused by a newer position
+        candidate = next;
+    }
+    return best > prevLength ? best : 0;
+}
+
+void DeflateEncoder::tokenize(const size_t limit, const size_t end) {
+    size_t i = pos_;
+    bool havePrev = false;
+    uint32_t prevLength = 0;
+    uint32_t prevDistance = 0;
+
+    auto emitMatch = [&](const size_t start, const uint32_t length, const uint32_t distance) {
+        tokens_.push_back(distance << 16 | length);
+        // Index the positions covered by the match (start was indexed already)
+        for (size_t j = start + 1; j < start + length; ++j) {
+            if (j + MIN_MATCH <= end) insertHash(j);
+        }
+    };
+
+    while (i < limit) {
+        uint32_t length = 0;
+        uint32_t distance = 0;
+        if (i + MIN_MATCH <= end) {
+            if (!(havePrev && prevLength >= niceLength_)) {
+                length = longestMatch(i, end, MIN_MATCH - 1, distance);
+            }
+            insertHash(i);
+        }
+
+        if (!lazy_) {
+            if (length >= MIN_MATCH) {
+                emitMatch(i, length, distance);
+                i += length;
+            } else {
+                tokens_.push_back(window_[i]);
+                ++i;
+            }
+            continue;
+        }
+
+        // Lazy evaluation: keep the previous match unless this position has a longer one
+        if (havePrev && prevLength >= MIN_MATCH && length <= prevLength) {
+            emitMatch(i - 1, prevLength, prevDistance);
+            i = i - 1 + prevLength;
+            havePrev = false;
+            continue;
+        }
+        if (havePrev) tokens_.push_back(window_[i - 1]);
+        havePrev = true;
+        prevLength = length;
+        prevDistance = distance;
+        ++i;
+    }
+    if (havePrev) {
+        if (prevLength >= MIN_MATCH) {
+            emitMatch(i - 1, prevLength, prevDistance);
+            i = i - 1 + prevLength;
+        } else {
+            tokens_.push_back(window_[i - 1]);
+        }
+    }
+    pos_ = i;
+}
+
+void DeflateEncoder::emitBlock(const bool final, const size_t blockEnd) {
+    const uint8_t* raw = window_.data() + blockStart_;
+    const size_t rawLen = blockEnd - blockStart_;
+    if (store_) {
+        emitStored(final, raw, rawLen);
+        return;
+    }
+
+    std::vector<uint32_t> litFreq(286, 0), distFreq(30, 0);
+    for (const uint32_t t : tokens_) {
+        const uint32_t dist = t >> 16;
+        if (dist == 0) {
+            ++litFreq[t & 0xFF];
+        } else {
+            ++litFreq[257 + LENGTH_CODES[t & 0xFFFF]];
+            ++distFreq[distanceCode(dist)];
+        }
+    }
+    litFreq[256] = 1;
+
+    const auto litLengths = buildLengths(litFreq, 15);
+    const auto distLengths = buildLengths(distFreq, 15);
+
+    size_t hlit = 286;
+    while (hlit > 257 && litLengths[hlit - 1] == 0) --hlit;
+    size_t hdist = 30;
+    while (hdist > 1 && distLengths[hdist - 1] == 0) --hdist;
+
+    std::vector<uint8_t> allLengths(litLengths.begin(), litLengths.begin() + static_cast<std::ptrdiff_t>(hlit));
+    allLengths.insert(allLengths.end(), distLengths.begin(), distLengths.begin() + static_cast<std::ptrdiff_t>(hdist));
+    const auto clSymbols = encodeCodeLengths(allLengths);
+    std::vector<uint32_t> clFreq(19, 0);
+    for (const uint16_t s : clSymbols) ++clFreq[s & 0xFF];
+    const auto clLengths = buildLengths(clFreq, 7);
+    size_t hclen = 19;
+    while (hclen > 4 && clLengths[CODE_LENGTH_ORDER[hclen - 1]] == 0) --hclen;
+
+    // Compare the cost of the three block types
+    auto payloadBits = [&](const std::vector<uint8_t>& lit, const std::vector<uint8_t>& dist) {
+        uint64_t bits = 0;
+        for (size_t s = 0; s < 286; ++s) {
+            bits += static_cast<uint64_t>(litFreq[s]) * lit[s];
+            if (s >= 257) bits += static_cast<uint64_t>(litFreq[s]) * LENGTH_EXTRA[s - 257];
+        }
+        for (size_t s = 0; s < 30; ++s) bits += static_cast<uint64_t>(distFreq[s]) * (dist[s] + DIST_EXTRA[s]);
+        return bits;
+    };
+    uint64_t dynamicBits = 3 + 14 + 3 * hclen + payloadBits(litLengths, distLengths);
+    for (const uint16_t s : clSymbols) {
+        const unsigned sym = s & 0xFF;
+        dynamicBits += clLengths[sym] + (sym == 16 ? 2 : sym == 17 ? 3 : sym == 18 ? 7 : 0);
+    }
+    const uint64_t fixedBits = 3 + payloadBits(fixedLiteralLengths(), fixedDistanceLengths());
+    const uint64_t storedBits = (rawLen / MAX_STORED + 1) * 40 + 8 * static_cast<uint64_t>(rawLen) + 7;
+
+    if (storedBits <= dynamicBits && storedBits <= fixedBits) {
+        emitStored(final, raw, rawLen);
+        tokens_.clear();
+        return;
+    }
+
+    const bool useFixed = fixedBits <= dynamicBits;
+    const auto& lit = useFixed ? fixedLiteralLengths() : litLengths;
+    const auto& dist = useFixed ? fixedDistanceLengths() : distLengths;
+    const auto litCodes = buildCodes(lit);
+    const auto distCodes = buildCodes(dist);
+
+    putBits(final ? 1 : 0, 1);
+    putBits(useFixed ? 1 : 2, 2);
+    if (!useFixed) {
+        putBits(static_cast<uint32_t>(hlit - 257), 5);
+        putBits(static_cast<uint32_t>(hdist - 1), 5);
+        putBits(static_cast<uint32_t>(hclen - 4), 4);
+        for (size_t k = 0; k < hclen; ++k) putBits(clLengths[CODE_LENGTH_ORDER[k]], 3);
+        const auto clCodes = buildCodes(clLengths);
+        for (const uint16_t s : clSymbols) {
+            const unsigned sym = s & 0xFF;
+            putBits(clCodes[sym], clLengths[sym]);
+            if (sym == 16) putBits(s >> 8, 2);
+            else if (sym == 17) putBits(s >> 8, 3);
+            else if (sym == 18) putBits(s >> 8, 7);
+        }
+    }
+
+    for (const uint32_t t : tokens_) {
+        const uint32_t distance = t >> 16;
+        if (distance == 0) {
+            putBits(litCodes[t & 0xFF], lit[t & 0xFF]);
+            continue;
+        }
+        const uint32_t length = t & 0xFFFF;
+        const unsigned lc = LENGTH_CODES[length];
+        putBits(litCodes[257 + lc], lit[257 + lc]);
+        if (LENGTH_EXTRA[lc]) putBits(length - LENGTH_BASE[lc], LENGTH_EXTRA[lc]);
+        const unsigned dc = distanceCode(distance);
+        putBits(distCodes[dc], dist[dc]);
+        if (DIST_EXTRA[dc]) putBits(distance - DIST_BASE[dc], DIST_EXTRA[dc]);
+    }
+    putBits(litCodes[256], lit[256]);
+    tokens_.clear();
+}
+
+void DeflateEncoder::emitStored(const bool final, const uint8_t* data, size_t len) {
+    do {
+        const size_t take = std::min(len, MAX_STORED);
+        len -= take;
+        putBits(final && len == 0 ? 1 : 0, 1);
+        putBits(0, 2);
+        alignToByte();
+        const auto n = static_cast<uint16_t>(take);
+        pending_.push_back(static_cast<char>(n & 0xFF));
+        pending_.push_back(static_cast<char>(n >> 8));
+        pending_.push_back(static_cast<char>(~n & 0xFF));
+        pending_.push_back(static_cast<char>((~n >> 8) & 0xFF));
+        pending_.append(reinterpret_cast<const char*>(data), take);
+        data += take;
+    } while (len > 0);
+}
+
+// Drops input that has fallen out of the match window
+void DeflateEncoder::slideWindow() {
+    if (blockStart_ <= WINDOW_SIZE) return;
+    const size_t drop = blockStart_ - WINDOW_SIZE;
+    window_.erase(window_.begin(), window_.begin() + static_cast<std::ptrdiff_t>(drop));
+    base_ += drop;
+    pos_ -= drop;
+    blockStart_ -= drop;
+}
+
+void DeflateEncoder::putBits(const uint32_t bits, const unsigned count) {
+    bitBuffer_ |= static_cast<uint64_t>(bits) << bitCount_;
+    bitCount_ += count;
+    while (bitCount_ >= 8) {
+        pending_.push_back(static_cast<char>(bitBuffer_ & 0xFF));
+        bitBuffer_ >>= 8;
+        bitCount_ -= 8;
+    }
+}
+
+void DeflateEncoder::alignToByte() {
+    if (bitCount_ > 0) {
+        pending_.push_back(static_cast<char>(bitBuffer_ & 0xFF));
+        bitBuffer_ = 0;
+        bitCount_ = 0;
+    }
+}
+
+void DeflateEncoder::drain(std::string& out) {
+    if (pending_.empty()) return;
+    out.append(pending_);
+    pending_.clear();
+}
+
+} // namespace blade
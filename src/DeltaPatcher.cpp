@@ -0,0 +1,152 @@
+#include "DeltaPatcher.h"
+#include "Hashing.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace blade {
+
+namespace {
+
+constexpr uint8_t OP_COPY = 0x01;
+constexpr uint8_t OP_DATA = 0x02;
+constexpr size_t COPY_HEADER_SIZE = 9;
+constexpr size_t DATA_HEADER_SIZE = 5;
+constexpr size_t SIGNATURE_HEADER_SIZE = 24;
+constexpr size_t SIGNATURE_READ_SIZE = 4 * 1024 * 1024;  // Basis bytes read per call while signing
+constexpr size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+void put32(std::string& out, const uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) out += static_cast<char>(value >> shift & 0xFF);
+}
+
+void put64(std::string& out, const uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) out += static_cast<char>(value >> shift & 0xFF);
+}
+
+uint32_t get32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+} // namespace
+
+uint32_t DeltaPatcher::blockSizeFor(const uint64_t size) {
+    const auto root = static_cast<uint64_t>(std::sqrt(static_cast<double>(size)));
+    return static_cast<uint32_t>(std::clamp<uint64_t>(std::bit_floor(std::max<uint64_t>(root, 1)), MIN_BLOCK_SIZE, MAX_BLOCK_SIZE));
+}
+
+uint32_t DeltaPatcher::weakChecksum(const uint8_t* data, const size_t len) {
+    uint32_t s1 = 0;
+    uint32_t s2 = 0;
+    for (size_t i = 0; i < len; ++i) {
+        s1 += data[i];
+        s2 += s1;
+    }
+    return (s1 & 0xFFFF) | (s2 & 0xFFFF) << 16;
+}
+
+bool DeltaPatcher::signature(const PositionalFile& basis, const uint64_t size, const int64_t modified, std::string& out) {
+    const uint32_t blockSize = blockSizeFor(size);
+    const uint64_t blocks = size / blockSize;  // A short last block is never matched; it is sent as data
+    out.clear();
+    out.reserve(SIGNATURE_HEADER_SIZE + blocks * (4 + STRONG_SIZE));
+    out += "BLDS";
+    put32(out, blockSize);
+    put64(out, size);
+    put64(out, static_cast<uint64_t>(modified));
+
+    std::vector<uint8_t> buffer(SIGNATURE_READ_SIZE / blockSize * blockSize);
+    for (uint64_t block = 0; block < blocks;) {
+        const uint64_t batch = std::min<uint64_t>(buffer.size() / blockSize, blocks - block);
+        const auto len = static_cast<size_t>(batch * blockSize);
+        if (basis.readAt(block * blockSize, buffer.data(), len) != static_cast<int64_t>(len)) return false;
+        for (uint64_t i = 0; i < batch; ++i) {
+            const uint8_t* data = buffer.data() + i * blockSize;
+            put32(out, weakChecksum(data, blockSize));
+            const auto strong = Hashing::sha256(data, blockSize);
+            out.append(reinterpret_cast<const char*>(strong.data()), STRONG_SIZE);
+        }
+        block += batch;
+    }
+    return true;
+}
+
+DeltaPatcher::DeltaPatcher(std::shared_ptr<PositionalFile> basis, const uint64_t basisSize,
+                           std::shared_ptr<PositionalFile> output, const uint64_t outputSize)
+    : basis_(std::move(basis)), output_(std::move(output)), blockSize_(blockSizeFor(basisSize)),
+      blockCount_(basisSize / blockSize_), outputSize_(outputSize) {}
+
+bool DeltaPatcher::write(const uint8_t* data, size_t len) {
+    if (!output_) return false;
+    while (len > 0) {
+        if (literalLeft_ > 0) {
+            const auto n = static_cast<size_t>(std::min<uint64_t>(len, literalLeft_));
+            if (!output_->writeAt(produced_, data, n)) return false;
+            produced_ += n;
+            literalLeft_ -= n;
+            data += n;
+            len -= n;
+            continue;
+        }
+
+        // Gather the operation header, which may arrive split across writes
+        op_[opLength_++] = *data++;
+        --len;
+        const size_t needed = op_[0] == OP_COPY ? COPY_HEADER_SIZE : op_[0] == OP_DATA ? DATA_HEADER_SIZE : 0;
+        if (needed == 0) {
+            Logger::getInstance().warning("Unknown delta operation " + std::to_string(op_[0]));
+            return false;
+        }
+        if (opLength_ == needed) {
+            opLength_ = 0;
+            if (!execute()) return false;
+        }
+    }
+    return true;
+}
+
+bool DeltaPatcher::execute() {
+    if (op_[0] == OP_COPY) return copyBlocks(get32(&op_[1]), get32(&op_[5]));
+
+    const uint32_t length = get32(&op_[1]);
+    if (length > outputSize_ - produced_) {
+        Logger::getInstance().warning("Delta data runs past the end of the file");
+        return false;
+    }
+    literalLeft_ = length;
+    return true;
+}
+
+bool DeltaPatcher::copyBlocks(const uint32_t first, const uint32_t count) {
+    const uint64_t bytes = static_cast<uint64_t>(count) * blockSize_;
+    if (static_cast<uint64_t>(first) + count > blockCount_ || bytes > outputSize_ - produced_) {
+        Logger::getInstance().warning("Delta copies blocks past the end of a file");
+        return false;
+    }
+    if (copyBuffer_.empty()) copyBuffer_.resize(std::max<size_t>(COPY_BUFFER_SIZE, blockSize_));
+
+    uint64_t source = static_cast<uint64_t>(first) * blockSize_;
+    for (uint64_t left = bytes; left > 0;) {
+        const auto n = static_cast<size_t>(std::min<uint64_t>(left, copyBuffer_.size()));
+        if (basis_->readAt(source, copyBuffer_.data(), n) != static_cast<int64_t>(n)) return false;
+        if (!output_->writeAt(produced_, copyBuffer_.data(), n)) return false;
+        source += n;
+        produced_ += n;
+        left -= n;
+    }
+    return true;
+}
+
+bool DeltaPatcher::isComplete() const {
+    return produced_ == outputSize_ && literalLeft_ == 0 && opLength_ == 0;
+}
+
+void DeltaPatcher::release() {
+    basis_.reset();
+    output_.reset();
+}
+
+} // namespace blade
@@ -0,0 +1,183 @@
+#include "DirectoryWalker.h"
+#include "Logger.h"
+
+#include <algorithm>
+
+namespace blade {
+
+namespace {
+
+constexpr size_t MAX_QUEUED_ENTRIES = 4096;  // Entries waiting for next() before the workers pause
+constexpr size_t BATCH_SIZE = 256;           // Entries a worker gathers before taking the lock
+constexpr unsigned MAX_THREADS = 8;          // Listing is bound by the file system, not the CPU
+constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(250);
+
+std::string utf8Name(const std::filesystem::path& path) {
+    const std::u8string name = path.filename().u8string();
+    return {name.begin(), name.end()};
+}
+
+} // namespace
+
+DirectoryWalker::DirectoryWalker(std::filesystem::path root, const bool collect, ProgressCallback onProgress)
+    : collect_(collect), onProgress_(std::move(onProgress)) {
+    // "dir/" names the directory itself, as "dir" does
+    root = root.lexically_normal();
+    if (!root.has_filename()) root = root.parent_path();
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) {
+        Logger::getInstance().warning("Not a directory, nothing to walk: " + root.string());
+        finished_.store(true, std::memory_order_release);
+        return;
+    }
+
+    Entry top;
+    top.path = root;
+    top.name = utf8Name(root);
+    top.directory = true;
+    top.modified = std::filesystem::last_write_time(root, ec);
+    directories_.push_back({root, top.name});
+    unlisted_ = 1;
+    if (collect_) entries_.push_back(std::move(top));
+
+    const unsigned threads = std::clamp(std::thread::hardware_concurrency(), 2u, MAX_THREADS);
+    threads_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) threads_.emplace_back(&DirectoryWalker::work, this);
+}
+
+DirectoryWalker::~DirectoryWalker() {
+    cancel();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+bool DirectoryWalker::next(Entry& entry) {
+    std::unique_lock lock(mutex_);
+    entriesCv_.wait(lock, [this] { return cancelled_ || !entries_.empty() || unlisted_ == 0; });
+    if (cancelled_ || entries_.empty()) return false;
+    entry = std::move(entries_.front());
+    entries_.pop_front();
+    if (entries_.size() < MAX_QUEUED_ENTRIES) spaceCv_.notify_one();
+    return true;
+}
+
+bool DirectoryWalker::available() const {
+    std::lock_guard lock(mutex_);
+    return cancelled_ || !entries_.empty() || unlisted_ == 0;
+}
+
+void DirectoryWalker::cancel() {
+    {
+        std::lock_guard lock(mutex_);
+        cancelled_ = true;
+    }
+    workCv_.notify_all();
+    entriesCv_.notify_all();
+    spaceCv_.notify_all();
+}
+
+void DirectoryWalker::work() {
+    std::vector<Entry> batch;
+    std::vector<Directory> subdirectories;
+    while (true) {
+        Directory directory;
+        {
+            std::unique_lock lock(mutex_);
+            workCv_.wait(lock, [this] { return cancelled_ || !directories_.empty() || unlisted_ == 0; });
+            if (cancelled_ || directories_.empty()) return;
+            directory = std::move(directories_.back());
+            directories_.pop_back();
+        }
+
+        list(directory, batch, subdirectories);
+
+        bool done;
+        {
+            std::lock_guard lock(mutex_);
+            done = --unlisted_ == 0 && !cancelled_;
+        }
+        if (!done) continue;
+
+        // The last directory is listed: wake the idle workers and the consumer
+        finished_.store(true, std::memory_order_release);
+        workCv_.notify_all();
+        entriesCv_.notify_all();
+        if (onProgress_) onProgress_(filesFound(), bytesFound(), true);
+        return;
+    }
+}
+
+void DirectoryWalker::list(const Directory& directory, std::vector<Entry>& batch, std::vector<Directory>& subdirectories) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(directory.path, std::filesystem::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        Logger::getInstance().warning("Skipping unreadable directory " + directory.path.string() + ": " + ec.message());
+        return;
+    }
+
+    for (const std::filesystem::directory_iterator end; it != end; it.increment(ec)) {
+        const std::filesystem::directory_entry& item = *it;
+        Entry entry;
+        std::error_code itemEc;
+        // A link to a directory could lead back up the tree; links to files are sent as the file
+        if (item.is_directory(itemEc) && !item.is_symlink(itemEc)) {
+            entry.directory = true;
+        } else if (item.is_regular_file(itemEc)) {
+            entry.size = item.file_size(itemEc);
+            if (itemEc) continue;
+        } else {
+            continue;  // Sockets, devices, dangling links
+        }
+        entry.path = item.path();
+        entry.name = directory.name + '/' + utf8Name(entry.path);
+        entry.modified = item.last_write_time(itemEc);
+        if (entry.directory) subdirectories.push_back({entry.path, entry.name});
+        batch.push_back(std::move(entry));
+
+        if (batch.size() >= BATCH_SIZE && !publish(batch, subdirectories)) return;
+    }
+    if (ec) Logger::getInstance().warning("Listing of " + directory.path.string() + " broke off: " + ec.message());
+    (void)publish(batch, subdirectories);
+}
+
+// Hands a batch to the consumer and its subdirectories to the workers; false once cancelled
+bool DirectoryWalker::publish(std::vector<Entry>& batch, std::vector<Directory>& subdirectories) {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    for (const auto& entry : batch) {
+        if (entry.directory) continue;
+        ++files;
+        bytes += entry.size;
+    }
+
+    bool report = false;
+    {
+        std::unique_lock lock(mutex_);
+        if (collect_) {
+            spaceCv_.wait(lock, [this] { return cancelled_ || entries_.size() < MAX_QUEUED_ENTRIES; });
+            std::move(batch.begin(), batch.end(), std::back_inserter(entries_));
+        }
+        if (cancelled_) return false;
+        unlisted_ += subdirectories.size();
+        std::move(subdirectories.begin(), subdirectories.end(), std::back_inserter(directories_));
+        files_.fetch_add(files, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+
+        const auto now = std::chrono::steady_clock::now();
+        if (onProgress_ && now - lastProgress_ >= PROGRESS_INTERVAL) {
+            lastProgress_ = now;
+            report = true;
+        }
+    }
+    if (collect_ && !batch.empty()) entriesCv_.notify_one();
+    if (!subdirectories.empty()) workCv_.notify_all();
+    batch.clear();
+    subdirectories.clear();
+
+    if (report) onProgress_(filesFound(), bytesFound(), false);
+    return true;
+}
+
+} // namespace blade
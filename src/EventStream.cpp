@@ -0,0 +1,365 @@
+#include "EventStream.h"
+#include "Logger.h"
+
+#include <algorithm>
+
+namespace blade {
+
+namespace {
+
+// Reconnection delay for EventSource, sent ahead of the snapshots
+constexpr std::string_view RETRY_FIELD = "retry: 3000\n\n";
+
+// Coalescing key of the ping event, so a sleeping client holds at most one
+constexpr std::string_view PING_KEY = "ping\n";
+
+} // namespace
+
+EventStream::EventStream(SnapshotCallback snapshot, AliveCallback onAlive, MessageCallback onMessage)
+    : snapshot_(std::move(snapshot)), onAlive_(std::move(onAlive)), onMessage_(std::move(onMessage)) {}
+
+EventStream::~EventStream() {
+    stop();
+}
+
+bool EventStream::start() {
+    if (running_ || !poller_.isValid()) return false;
+    running_ = true;
+    thread_ = std::thread(&EventStream::run, this);
+    if (onMessage_) worker_ = std::thread(&EventStream::work, this);
+    return true;
+}
+
+void EventStream::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    requested_.notify_all();
+    poller_.wakeup();
+    if (thread_.joinable()) thread_.join();
+    if (worker_.joinable()) worker_.join();
+
+    // Best effort: whatever the socket takes without blocking
+    for (auto& subscriber : subscribers_) {
+        if (subscriber.transport == Transport::WebSocket) {
+            (void)deliver(subscriber, {}, WebSocket::closeFrame(WebSocket::CloseCode::GoingAway));
+        }
+    }
+    while (!subscribers_.empty()) drop(subscribers_.size() - 1);
+    std::lock_guard lock(mutex_);
+    for (const auto& subscriber : incoming_) NetworkUtils::closeSocket(subscriber.socket);
+    incoming_.clear();
+    pending_.clear();
+    requests_.clear();
+    replies_.clear();
+    subscriberCount_ = 0;
+}
+
+bool EventStream::subscribe(const SocketType socket, std::string clientIP, const Transport transport) {
+    {
+        std::lock_guard lock(mutex_);
+        if (!running_ || subscriberCount_ >= MAX_SUBSCRIBERS) return false;
+        Subscriber& subscriber = incoming_.emplace_back();
+        subscriber.id = nextId_++;
+        subscriber.socket = socket;
+        subscriber.clientIP = std::move(clientIP);
+        subscriber.transport = transport;
+        subscriber.lastSeen = std::chrono::steady_clock::now();
+        ++subscriberCount_;
+    }
+    poller_.wakeup();
+    return true;
+}
+
+void EventStream::publish(const std::string_view event, const std::string_view data, const std::string_view key) {
+    if (!hasSubscribers()) return;
+    std::string pendingKey(event);
+    pendingKey += '\n';
+    pendingKey += key;
+    Message message{std::string(event), std::string(data)};
+    {
+        std::lock_guard lock(mutex_);
+        const auto it = std::ranges::find(pending_, pendingKey, &Pending::key);
+        if (it != pending_.end()) {
+            it->message = std::move(message);
+        } else {
+            pending_.push_back({std::move(pendingKey), std::move(message)});
+        }
+    }
+    poller_.wakeup();
+}
+
+std::string EventStream::format(const std::string_view event, const std::string_view data) {
+    std::string frame;
+    frame.reserve(event.size() + data.size() + 16);
+    frame += "event: ";
+    frame += event;
+    frame += "\ndata: ";
+    frame += data;
+    frame += "\n\n";
+    return frame;
+}
+
+std::string EventStream::envelope(const std::string_view event, const std::string_view data) {
+    std::string json;
+    json.reserve(event.size() + data.size() + 20);
+    json += "{\"event\":\"";
+    json += event;
+    json += "\",\"data\":";
+    json += data;
+    json += '}';
+    return json;
+}
+
+void EventStream::run() {
+    std::vector<NetworkUtils::Poller::Event> events;
+    std::vector<Subscriber> incoming;
+    std::vector<Pending> pending;
+    std::vector<Reply> replies;
+    auto nextPing = std::chrono::steady_clock::now() + PING_INTERVAL;
+
+    while (running_) {
+        const auto untilPing = std::chrono::duration_cast<std::chrono::milliseconds>(nextPing - std::chrono::steady_clock::now());
+        (void)poller_.wait(events, static_cast<int>(std::max<int64_t>(0, untilPing.count())));
+
+        for (const auto& ev : events) {
+            const auto it = std::ranges::find(subscribers_, ev.socket, &Subscriber::socket);
+            if (it == subscribers_.end()) continue;
+            if (ev.error || (ev.readable && !receive(*it)) || (ev.writable && !flush(*it))) {
+                drop(static_cast<size_t>(it - subscribers_.begin()));
+            }
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            incoming.swap(incoming_);
+            pending.swap(pending_);
+            replies.swap(replies_);
+        }
+        for (auto& reply : replies) {
+            const auto it = std::ranges::find(subscribers_, reply.subscriber, &Subscriber::id);
+            if (it == subscribers_.end()) continue;  // Gone while its message was handled
+            --it->outstanding;
+            if (!reply.message.empty() &&
+                !deliver(*it, {}, WebSocket::frame(WebSocket::Opcode::Text, reply.message))) {
+                drop(static_cast<size_t>(it - subscribers_.begin()));
+            }
+        }
+        replies.clear();
+        // Events go out before new subscribers are adopted: their snapshots are taken
+        // afterwards, so they already reflect everything published so far
+        for (const auto& event : pending) broadcast(event.message, event.key);
+        pending.clear();
+        adopt(incoming);
+
+        if (std::chrono::steady_clock::now() >= nextPing) {
+            ping();
+            nextPing = std::chrono::steady_clock::now() + PING_INTERVAL;
+        }
+    }
+}
+
+// Message worker: runs the callback for each request and hands the reply to the stream thread
+void EventStream::work() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        requested_.wait(lock, [this] { return !running_ || !requests_.empty(); });
+        if (!running_) return;
+        Request request = std::move(requests_.front());
+        requests_.pop_front();
+
+        lock.unlock();
+        std::string reply = onMessage_(request.clientIP, request.message);
+        lock.lock();
+        replies_.push_back({request.subscriber, std::move(reply)});
+        poller_.wakeup();
+    }
+}
+
+void EventStream::adopt(std::vector<Subscriber>& incoming) {
+    for (auto& subscriber : incoming) {
+        std::string initial;
+        if (subscriber.transport == Transport::EventSource) {
+            initial = RETRY_FIELD;
+            for (const auto& message : snapshot_()) initial += format(message.event, message.data);
+        } else {
+            for (const auto& message : snapshot_()) {
+                initial += WebSocket::frame(WebSocket::Opcode::Text, envelope(message.event, message.data));
+            }
+        }
+        // Events are small, separate writes; Nagle would hold each one until the previous was ACKed
+        (void)NetworkUtils::setNoDelay(subscriber.socket);
+        if (!NetworkUtils::setNonBlocking(subscriber.socket) || !poller_.add(subscriber.socket) ||
+            !deliver(subscriber, {}, std::move(initial))) {
+            poller_.remove(subscriber.socket);
+            NetworkUtils::closeSocket(subscriber.socket);
+            --subscriberCount_;
+            continue;
+        }
+        Logger::getInstance().debug("[EVENTS] " + subscriber.clientIP + " subscribed" +
+                                    (subscriber.transport == Transport::WebSocket ? " (WebSocket)" : ""));
+        subscribers_.push_back(std::move(subscriber));
+    }
+    incoming.clear();
+}
+
+void EventStream::broadcast(const Message& message, const std::string_view key) {
+    // Each encoding is built at most once per event, and only if someone uses it
+    std::string sseFrame;
+    std::string wsFrame;
+    for (size_t i = subscribers_.size(); i-- > 0;) {
+        std::string& frame = subscribers_[i].transport == Transport::EventSource ? sseFrame : wsFrame;
+        if (frame.empty()) {
+            frame = subscribers_[i].transport == Transport::EventSource
+                        ? format(message.event, message.data)
+                        : WebSocket::frame(WebSocket::Opcode::Text, envelope(message.event, message.data));
+        }
+        if (!deliver(subscribers_[i], key, frame)) drop(i);
+    }
+}
+
+// Adds a frame to a subscriber's queue, replacing an unsent one with the same key;
+// false if the queue has grown past MAX_QUEUED_BYTES
+bool EventStream::enqueue(Subscriber& subscriber, const std::string_view key, std::string frame) {
+    if (!key.empty()) {
+        // The front frame may be partly written already and has to go out as it is
+        const auto first = subscriber.queue.begin() + (subscriber.sent > 0 ? 1 : 0);
+        const auto it = std::find_if(first, subscriber.queue.end(),
+            [key](const Outgoing& outgoing) { return outgoing.key == key; });
+        if (it != subscriber.queue.end()) {
+            subscriber.queuedBytes = subscriber.queuedBytes - it->frame.size() + frame.size();
+            it->frame = std::move(frame);
+            return subscriber.queuedBytes <= MAX_QUEUED_BYTES;
+        }
+    }
+    subscriber.queuedBytes += frame.size();
+    subscriber.queue.push_back({std::string(key), std::move(frame)});
+    return subscriber.queuedBytes <= MAX_QUEUED_BYTES;
+}
+
+// Writes queued frames until the socket would block, and watches for writability
+// while anything is left; false on a socket error
+bool EventStream::flush(Subscriber& subscriber) {
+    while (!subscriber.queue.empty()) {
+        const std::string& frame = subscriber.queue.front().frame;
+        const int n = NetworkUtils::sendSome(subscriber.socket, frame.data() + subscriber.sent,
+                                             frame.size() - subscriber.sent);
+        if (n < 0) return false;
+        if (n == 0) break;
+        subscriber.sent += static_cast<size_t>(n);
+        if (subscriber.sent == frame.size()) {
+            subscriber.queuedBytes -= frame.size();
+            subscriber.queue.pop_front();
+            subscriber.sent = 0;
+        }
+    }
+    const bool backlog = !subscriber.queue.empty();
+    if (backlog != subscriber.watchingWrite) {
+        if (!poller_.watchWritable(subscriber.socket, backlog)) return false;
+        subscriber.watchingWrite = backlog;
+    }
+    return true;
+}
+
+bool EventStream::deliver(Subscriber& subscriber, const std::string_view key, std::string frame) {
+    return enqueue(subscriber, key, std::move(frame)) && flush(subscriber);
+}
+
+// Reads what a readable subscriber sent; false if it has to be dropped
+bool EventStream::receive(Subscriber& subscriber) {
+    char buffer[4096];
+    const int n = NetworkUtils::receiveData(subscriber.socket, buffer, sizeof(buffer));
+    // EventSource clients never send anything, so readability means they closed their end
+    if (n <= 0) return false;
+    if (subscriber.transport == Transport::EventSource) return true;
+
+    subscriber.lastSeen = std::chrono::steady_clock::now();
+    subscriber.parser.feed(buffer, static_cast<size_t>(n));
+    WebSocket::Opcode opcode;
+    std::string payload;
+    while (true) {
+        switch (subscriber.parser.next(opcode, payload)) {
+        case WebSocket::FrameParser::Status::Incomplete:
+            return true;
+        case WebSocket::FrameParser::Status::Error:
+            Logger::getInstance().warning("[EVENTS] Closing WebSocket from " + subscriber.clientIP + " (code " +
+                                          std::to_string(subscriber.parser.closeCode()) + ")");
+            (void)deliver(subscriber, {}, WebSocket::closeFrame(subscriber.parser.closeCode()));
+            return false;
+        case WebSocket::FrameParser::Status::Message:
+            break;
+        }
+
+        switch (opcode) {
+        case WebSocket::Opcode::Ping:
+            if (!deliver(subscriber, {}, WebSocket::frame(WebSocket::Opcode::Pong, payload))) return false;
+            break;
+        case WebSocket::Opcode::Close: {
+            // Echo the status code to complete the closing handshake
+            const uint16_t code = payload.size() >= 2
+                ? static_cast<uint16_t>(static_cast<uint8_t>(payload[0]) << 8 | static_cast<uint8_t>(payload[1]))
+                : WebSocket::CloseCode::Normal;
+            (void)deliver(subscriber, {}, WebSocket::closeFrame(code));
+            return false;
+        }
+        case WebSocket::Opcode::Text:
+        case WebSocket::Opcode::Binary:
+            if (onMessage_) {
+                // A client that keeps sending without waiting for answers would grow requests_ without bound
+                if (subscriber.outstanding >= MAX_OUTSTANDING_MESSAGES) {
+                    Logger::getInstance().warning("[EVENTS] Closing WebSocket from " + subscriber.clientIP +
+                                                  " (too many unanswered messages)");
+                    (void)deliver(subscriber, {}, WebSocket::closeFrame(WebSocket::CloseCode::PolicyViolation));
+                    return false;
+                }
+                ++subscriber.outstanding;
+                {
+                    std::lock_guard lock(mutex_);
+                    requests_.push_back({subscriber.id, subscriber.clientIP, std::move(payload)});
+                }
+                requested_.notify_one();
+            }
+            break;
+        default:
+            break;  // Pong: lastSeen is all it is for
+        }
+    }
+}
+
+void EventStream::ping() {
+    const auto now = std::chrono::steady_clock::now();
+    const std::string ssePing = format("ping", "{}");
+    const std::string wsPing = WebSocket::frame(WebSocket::Opcode::Text, envelope("ping", "{}"));
+    const std::string wsProtocolPing = WebSocket::frame(WebSocket::Opcode::Ping, {});
+    for (size_t i = subscribers_.size(); i-- > 0;) {
+        Subscriber& subscriber = subscribers_[i];
+        // Only a client that took everything up to now counts as alive
+        const bool keepingUp = subscriber.queue.empty();
+        if (subscriber.transport == Transport::EventSource) {
+            if (!deliver(subscriber, PING_KEY, ssePing)) {
+                drop(i);
+                continue;
+            }
+        } else if (now - subscriber.lastSeen > STALE_AFTER ||
+                   !deliver(subscriber, PING_KEY, wsPing) || !deliver(subscriber, {}, wsProtocolPing)) {
+            // A peer that answers neither pings nor anything else is gone even if the socket is still open
+            drop(i);
+            continue;
+        }
+        if (keepingUp) onAlive_(subscriber.clientIP);
+    }
+}
+
+void EventStream::drop(const size_t index) {
+    Subscriber& subscriber = subscribers_[index];
+    Logger::getInstance().debug("[EVENTS] " + subscriber.clientIP + " unsubscribed");
+    poller_.remove(subscriber.socket);
+    NetworkUtils::closeSocket(subscriber.socket);
+    subscriber = std::move(subscribers_.back());
+    subscribers_.pop_back();
+    --subscriberCount_;
+}
+
+} // namespace blade
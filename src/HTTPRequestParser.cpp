@@ -0,0 +1,160 @@
+#include "HTTPRequestParser.h"
+
+#include <cstring>
+#include <limits>
+
+namespace blade {
+
+namespace {
+
+constexpr char toLowerAscii(const char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool isWhitespace(const char c) {
+    return c == ' ' || c == '\t';
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && isWhitespace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isWhitespace(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+} // namespace
+
+HTTPRequestParser::Status HTTPRequestParser::parse(const uint8_t* data, const size_t len) {
+    base_ = reinterpret_cast<const char*>(data);
+    if (status_ != Status::Incomplete) return status_;
+    if (len > std::numeric_limits<uint32_t>::max()) return status_ = Status::Error;
+
+    while (true) {
+        // Each byte is searched for a line feed once; a line is parsed once it is complete
+        const size_t from = scanned_ > pos_ ? scanned_ : pos_;
+        const void* lf = from < len ? std::memchr(base_ + from, '\n', len - from) : nullptr;
+        if (!lf) {
+            scanned_ = len;
+            return status_;
+        }
+        const auto lineFeed = static_cast<size_t>(static_cast<const char*>(lf) - base_);
+        size_t end = lineFeed;
+        if (end > pos_ && base_[end - 1] == '\r') --end;  // Bare LF line ends are tolerated
+
+        if (!sawRequestLine_) {
+            // Empty lines before the request line are ignored (RFC 9112 2.2)
+            if (end != pos_) {
+                if (!parseRequestLine(pos_, end)) return status_ = Status::Error;
+                sawRequestLine_ = true;
+            }
+        } else if (end == pos_) {
+            pos_ = lineFeed + 1;
+            return status_ = Status::Complete;
+        } else if (!parseField(pos_, end)) {
+            return status_ = Status::Error;
+        }
+        pos_ = lineFeed + 1;
+        scanned_ = pos_;
+    }
+}
+
+void HTTPRequestParser::reset() {
+    status_ = Status::Incomplete;
+    pos_ = 0;
+    scanned_ = 0;
+    sawRequestLine_ = false;
+    method_ = target_ = version_ = Span{};
+    fieldCount_ = 0;
+}
+
+std::string_view HTTPRequestParser::path() const {
+    const std::string_view t = target();
+    return t.substr(0, t.find('?'));
+}
+
+std::string_view HTTPRequestParser::query() const {
+    const std::string_view t = target();
+    const size_t q = t.find('?');
+    return q == std::string_view::npos ? std::string_view() : t.substr(q + 1);
+}
+
+std::string_view HTTPRequestParser::header(const std::string_view name) const {
+    for (size_t i = 0; i < fieldCount_; ++i) {
+        if (equalsIgnoreCase(view(fields_[i].name), name)) return view(fields_[i].value);
+    }
+    return {};
+}
+
+bool HTTPRequestParser::uniqueHeader(const std::string_view name, std::string_view& value) const {
+    value = {};
+    bool found = false;
+    for (size_t i = 0; i < fieldCount_; ++i) {
+        if (!equalsIgnoreCase(view(fields_[i].name), name)) continue;
+        const std::string_view v = view(fields_[i].value);
+        if (found && v != value) return false;
+        value = v;
+        found = true;
+    }
+    return true;
+}
+
+bool HTTPRequestParser::hasHeader(const std::string_view name) const {
+    for (size_t i = 0; i < fieldCount_; ++i) {
+        if (equalsIgnoreCase(view(fields_[i].name), name)) return true;
+    }
+    return false;
+}
+
+bool HTTPRequestParser::headerHasToken(const std::string_view name, const std::string_view token) const {
+    // A list-valued field may be split over several lines
+    for (size_t i = 0; i < fieldCount_; ++i) {
+        if (!equalsIgnoreCase(view(fields_[i].name), name)) continue;
+        const std::string_view value = view(fields_[i].value);
+        size_t start = 0;
+        while (start <= value.size()) {
+            size_t comma = value.find(',', start);
+            if (comma == std::string_view::npos) comma = value.size();
+            if (equalsIgnoreCase(trim(value.substr(start, comma - start)), token)) return true;
+            start = comma + 1;
+        }
+    }
+    return false;
+}
+
+bool HTTPRequestParser::equalsIgnoreCase(const std::string_view a, const std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (toLowerAscii(a[i]) != toLowerAscii(b[i])) return false;
+    }
+    return true;
+}
+
+bool HTTPRequestParser::parseRequestLine(const size_t begin, const size_t end) {
+    const std::string_view line(base_ + begin, end - begin);
+    const size_t methodEnd = line.find(' ');
+    if (methodEnd == std::string_view::npos || methodEnd == 0) return false;
+    const size_t targetEnd = line.find(' ', methodEnd + 1);
+    if (targetEnd == std::string_view::npos || targetEnd == methodEnd + 1) return false;
+    if (!line.substr(targetEnd + 1).starts_with("HTTP/")) return false;
+
+    method_ = {static_cast<uint32_t>(begin), static_cast<uint32_t>(methodEnd)};
+    target_ = {static_cast<uint32_t>(begin + methodEnd + 1), static_cast<uint32_t>(targetEnd - methodEnd - 1)};
+    version_ = {static_cast<uint32_t>(begin + targetEnd + 1), static_cast<uint32_t>(line.size() - targetEnd - 1)};
+    return true;
+}
+
+bool HTTPRequestParser::parseField(const size_t begin, const size_t end) {
+    if (fieldCount_ == MAX_FIELDS) return false;
+    const std::string_view line(base_ + begin, end - begin);
+    // Folded continuation lines and whitespace before the colon are rejected (RFC 9112 5.1, 5.2)
+    if (isWhitespace(line.front())) return false;
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0 || isWhitespace(line[colon - 1])) return false;
+
+    const std::string_view value = trim(line.substr(colon + 1));
+    Field& field = fields_[fieldCount_++];
+    field.name = {static_cast<uint32_t>(begin), static_cast<uint32_t>(colon)};
+    field.value = {static_cast<uint32_t>(value.data() - base_), static_cast<uint32_t>(value.size())};
+    return true;
+}
+
+} // namespace blade
@@ -0,0 +1,113 @@
+#include "HTTPResponseWriter.h"
+#include "Logger.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace blade {
+
+HTTPResponseWriter::HTTPResponseWriter(const std::string_view statusLine) {
+    add(statusLine);
+}
+
+HTTPResponseWriter& HTTPResponseWriter::add(const std::string_view block) {
+    if (block.empty()) return *this;
+    if (partCount_ == MAX_PARTS) {
+        overflow_ = true;
+        return *this;
+    }
+    parts_[partCount_++] = {Storage::External, block.data(), 0, block.size()};
+    return *this;
+}
+
+HTTPResponseWriter& HTTPResponseWriter::header(const std::string_view name, const std::string_view value) {
+    append(name, value);
+    return *this;
+}
+
+HTTPResponseWriter& HTTPResponseWriter::header(const std::string_view name, const uint64_t value) {
+    char digits[20];
+    const auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    append(name, std::string_view(digits, static_cast<size_t>(end - digits)));
+    return *this;
+}
+
+void HTTPResponseWriter::append(const std::string_view name, const std::string_view value) {
+    const size_t size = name.size() + value.size() + 4;
+
+    // Once anything has spilled, later lines follow it so the parts stay in order
+    Storage storage;
+    size_t offset;
+    if (spill_.empty() && used_ + size <= BUFFER_SIZE) {
+        storage = Storage::Buffer;
+        offset = used_;
+        char* out = buffer_.data() + used_;
+        std::memcpy(out, name.data(), name.size());
+        out += name.size();
+        *out++ = ':';
+        *out++ = ' ';
+        std::memcpy(out, value.data(), value.size());
+        out += value.size();
+        *out++ = '\r';
+        *out = '\n';
+        used_ += size;
+    } else {
+        storage = Storage::Spill;
+        offset = spill_.size();
+        spill_.append(name).append(": ").append(value).append("\r\n");
+    }
+
+    // Consecutive formatted lines share one part
+    if (partCount_ > 0) {
+        Part& last = parts_[partCount_ - 1];
+        if (last.storage == storage && last.offset + last.size == offset) {
+            last.size += size;
+            return;
+        }
+    }
+    if (partCount_ == MAX_PARTS) {
+        overflow_ = true;
+        return;
+    }
+    parts_[partCount_++] = {storage, nullptr, offset, size};
+}
+
+std::string_view HTTPResponseWriter::view(const Part& part) const {
+    switch (part.storage) {
+    case Storage::External: return {part.data, part.size};
+    case Storage::Buffer:   return {buffer_.data() + part.offset, part.size};
+    case Storage::Spill:    return std::string_view(spill_).substr(part.offset, part.size);
+    }
+    return {};
+}
+
+bool HTTPResponseWriter::send(const SocketType socket, const std::string_view body) {
+    if (overflow_) {
+        Logger::getInstance().error("Response head has more than " + std::to_string(MAX_PARTS) + " parts");
+        return false;
+    }
+    std::array<std::string_view, MAX_PARTS + 2> buffers;
+    size_t count = 0;
+    for (size_t i = 0; i < partCount_; ++i) buffers[count++] = view(parts_[i]);
+    buffers[count++] = "\r\n";
+    if (!body.empty()) buffers[count++] = body;
+    return NetworkUtils::sendBuffers(socket, std::span(buffers.data(), count));
+}
+
+bool HTTPResponseWriter::sendChunk(const SocketType socket, const std::string_view data, const bool last) {
+    char size[20];
+    const auto [end, ec] = std::to_chars(size, size + sizeof(size) - 2, data.size(), 16);
+    end[0] = '\r';
+    end[1] = '\n';
+    std::array<std::string_view, 4> buffers;
+    size_t count = 0;
+    if (!data.empty()) {
+        buffers[count++] = std::string_view(size, end + 2);
+        buffers[count++] = data;
+        buffers[count++] = "\r\n";
+    }
+    if (last) buffers[count++] = "0\r\n\r\n";
+    return count == 0 || NetworkUtils::sendBuffers(socket, std::span(buffers.data(), count));
+}
+
+} // namespace blade
@@ -1,5 +1,8 @@
 #include "HTTPServer.h"
+#include "HTTPResponseWriter.h"
 
+#include <charconv>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <iomanip>
@@ -7,16 +10,251 @@
 
 #include "Server.h"
 #include "NetworkUtils.h"
+#include "MultipartParser.h"
+#include "EmbeddedAssets.h"
+#include "MimeTypes.h"
+#include "PositionalFile.h"
+#include "StaticAssetCache.h"
+#include "DeflateEncoder.h"
+#include "DirectoryWalker.h"
+#include "Hashing.h"
+#include "TarWriter.h"
+#include "WebSocket.h"
+#include "ZipWriter.h"
 #include "Logger.h"
-#include <fstream>
 #include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace blade {
 
+namespace {
+
+// Handlers behind the entries of ROUTES
+enum class Endpoint : unsigned {
+    Upload,
+    UploadAnnounce,
+    UploadSession,
+    UploadChunkList,
+    UploadSignature,
+    UploadDelta,
+    Heartbeat,
+    AuthConfig,
+    Login,
+    ConnectedDevices,
+    PendingFiles,
+    Download,
+    Archive,
+    Events,
+    WebSocket,
+    StaticFile
+};
+
+constexpr Route route(const std::string_view pattern, const unsigned methods, const Endpoint endpoint,
+                      const RouteOptions options = {}) {
+    return {pattern, methods, static_cast<unsigned>(endpoint), options};
+}
+
+constexpr RouteOptions PROTECTED{.requiresAuth = true};
+constexpr RouteOptions PROTECTED_SNAPSHOT{.cache = CachePolicy::Revalidate, .requiresAuth = true};
+constexpr RouteOptions PROTECTED_CONTROL{.requiresAuth = true, .executor = Executor::Control};
+constexpr RouteOptions PROTECTED_TRANSFER{.requiresAuth = true, .executor = Executor::Transfer};
+constexpr RouteOptions PROTECTED_UPLOAD{.requiresAuth = true, .streamsBody = true, .executor = Executor::Transfer};
+constexpr RouteOptions WEB_UI{.cors = false, .cache = CachePolicy::Revalidate};
+
+// Every endpoint of the server. Routes marked PROTECTED need the login credential when
+// authentication is enabled; the web UI, auth config, login and heartbeat stay public so the
+// login page can load.
+constexpr Route ROUTES[] = {
+    route("/api/upload", HttpMethod::Post, Endpoint::Upload, PROTECTED_UPLOAD),
+    route("/api/upload/announce", HttpMethod::Post, Endpoint::UploadAnnounce, PROTECTED_CONTROL),
+    route("/api/upload/{id}", HttpMethod::Put, Endpoint::UploadSession, PROTECTED_UPLOAD),
+    route("/api/upload/{id}", HttpMethod::Get | HttpMethod::Delete, Endpoint::UploadSession, PROTECTED),
+    route("/api/upload/{id}/chunks", HttpMethod::Post, Endpoint::UploadChunkList, PROTECTED_CONTROL),
+    route("/api/upload/{id}/signature", HttpMethod::Get, Endpoint::UploadSignature, PROTECTED_CONTROL),
+    route("/api/upload/{id}/delta", HttpMethod::Put, Endpoint::UploadDelta, PROTECTED_UPLOAD),
+    route("/api/heartbeat", HttpMethod::Get | HttpMethod::Post, Endpoint::Heartbeat),
+    route("/api/auth-config", HttpMethod::Get, Endpoint::AuthConfig),
+    route("/api/login", HttpMethod::Post, Endpoint::Login),
+    route("/api/connected-devices", HttpMethod::Get, Endpoint::ConnectedDevices, PROTECTED_SNAPSHOT),
+    route("/api/pending-files", HttpMethod::Get, Endpoint::PendingFiles, PROTECTED_SNAPSHOT),
+    route("/api/events", HttpMethod::Get, Endpoint::Events, PROTECTED),
+    route("/api/ws", HttpMethod::Get, Endpoint::WebSocket, PROTECTED),
+    route("/api/download/{id}", HttpMethod::Get | HttpMethod::Head, Endpoint::Download, PROTECTED_TRANSFER),
+    route("/api/download/{id}/{name}", HttpMethod::Get | HttpMethod::Head, Endpoint::Download, PROTECTED_TRANSFER),
+    route("/api/archive", HttpMethod::Get | HttpMethod::Head, Endpoint::Archive, PROTECTED_TRANSFER),
+    route("/api/archive/{name}", HttpMethod::Get | HttpMethod::Head, Endpoint::Archive, PROTECTED_TRANSFER),
+    route("/{*file}", HttpMethod::Get | HttpMethod::Head, Endpoint::StaticFile, WEB_UI),
+};
+
+static_assert(std::ranges::all_of(ROUTES, [](const Route& r) { return isValidRoutePattern(r.pattern); }),
+              "malformed route pattern");
+
+// Headers implementing a route's CORS and cache options, one prebuilt block per combination
+constexpr std::string_view POLICY_HEADERS[2][3] = {
+    {
+        "Cache-Control: no-cache, no-store, must-revalidate\r\nPragma: no-cache\r\nExpires: 0\r\n",
+        "Cache-Control: no-cache\r\n",
+        "",
+    },
+    {
+        "Access-Control-Allow-Origin: *\r\n"
+        "Cache-Control: no-cache, no-store, must-revalidate\r\nPragma: no-cache\r\nExpires: 0\r\n",
+        "Access-Control-Allow-Origin: *\r\nCache-Control: no-cache\r\n",
+        "Access-Control-Allow-Origin: *\r\n",
+    },
+};
+
+constexpr std::string_view policyHeaders(const RouteOptions& options) {
+    return POLICY_HEADERS[options.cors ? 1 : 0][static_cast<size_t>(options.cache)];
+}
+
+constexpr std::string_view PREFLIGHT_HEADERS =
+    "Access-Control-Allow-Origin: *\r\n"
+    "Access-Control-Allow-Headers: Content-Type, Cache-Control, Pragma, Expires, Range, If-Range, If-None-Match, X-Blade-Auth\r\n"
+    "Access-Control-Max-Age: 86400\r\n";
+
+constexpr std::string_view DOWNLOAD_HEADERS =
+    "Accept-Ranges: bytes\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Access-Control-Expose-Headers: Accept-Ranges, Content-Range, ETag\r\n"
+    "Cache-Control: no-cache\r\n";
+
+constexpr std::string_view ARCHIVE_HEADERS =
+    "Content-Type: application/zip\r\n"
+    "Content-Disposition: attachment; filename=\"blade-files.zip\"\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Cache-Control: no-cache\r\n";
+
+constexpr std::string_view FOLDER_HEADERS =
+    "Content-Type: application/x-tar\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Cache-Control: no-cache\r\n";
+
+constexpr std::string_view EVENT_STREAM_HEADERS =
+    "Content-Type: text/event-stream\r\n"
+    "X-Accel-Buffering: no\r\n";
+
+constexpr uint64_t MIN_COMPRESS_SIZE = 1024;       // Smaller bodies gain less than the gzip framing costs
+constexpr size_t COMPRESS_BLOCK_SIZE = 256 * 1024;  // File bytes compressed per chunk; the first is the probe
+constexpr int STREAM_GZIP_LEVEL = 1;                // Keeps up with Wi-Fi on one core
+constexpr int SNAPSHOT_GZIP_LEVEL = 6;              // Compressed once per generation, sent many times
+
+constexpr std::string_view FILE_NOT_FOUND = "File not found";
+constexpr std::string_view HTML_NOT_FOUND = "<html><body><h1>404 Not Found</h1></body></html>";
+
+// The UI compiled into the executable is served unless BLADE_WEB_ROOT names a
+// directory to use instead (for editing the UI without rebuilding); builds
+// without an embedded bundle read the configured web root. A mime.types file
+// beside the web root adds or corrects content types before any file is loaded.
+std::unique_ptr<StaticAssetCache> createAssetCache(const std::string& webRoot) {
+    (void)MimeTypes::loadFile(std::filesystem::path(webRoot).parent_path() / "mime.types");
+    if (const char* overrideRoot = std::getenv("BLADE_WEB_ROOT"); overrideRoot && *overrideRoot) {
+        Logger::getInstance().info("Serving web UI from override directory " + std::string(overrideRoot));
+        return std::make_unique<StaticAssetCache>(overrideRoot);
+    }
+    if (const auto bundle = embeddedAssets(); !bundle.empty()) {
+        return std::make_unique<StaticAssetCache>(bundle);
+    }
+    return std::make_unique<StaticAssetCache>(webRoot);
+}
+
+// Validators of JSON snapshots embed the process start time, so a restarted server (whose
+// generations start over) never matches an ETag handed out by an earlier run
+std::string makeEtagPrefix() {
+    char digits[16];
+    const auto now = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    const auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), now, 16);
+    return std::string(digits, end) + "-";
+}
+
+// Entry names for an archive of the given files; a name that is taken (ignoring case, as
+// the file systems the archive is likely extracted to do) gets " (2)", " (3)", ... before its extension
+std::vector<std::string> archiveEntryNames(const std::vector<PendingFile>& files) {
+    std::vector<std::string> names;
+    names.reserve(files.size());
+    std::unordered_set<std::string> taken;
+    const auto key = [](std::string name) {
+        std::ranges::transform(name, name.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return name;
+    };
+    for (const auto& file : files) {
+        std::string name = file.name;
+        const size_t dot = name.rfind('.');
+        const size_t stemEnd = dot == std::string::npos || dot == 0 ? name.size() : dot;
+        for (int n = 2; taken.contains(key(name)); ++n) {
+            name = file.name.substr(0, stemEnd) + " (" + std::to_string(n) + ")" + file.name.substr(stemEnd);
+        }
+        taken.insert(key(name));
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+// Streams a file gzip-compressed in chunked coding, starting with the `buffered` bytes already
+// read into `buffer`. Each chunk ends with a sync flush, so everything read so far can be decoded
+// once it arrives; returns the number of file bytes whose compressed form was sent.
+uint64_t sendGzipChunked(const SocketType socket, PositionalFile& input, const uint64_t length,
+                         std::vector<uint8_t>& buffer, size_t buffered, const std::function<void(uint64_t)>& onProgress) {
+    DeflateEncoder encoder(DeflateEncoder::Format::Gzip, STREAM_GZIP_LEVEL);
+    std::string out;
+    uint64_t done = 0;
+    while (done < length) {
+        if (buffered == 0) {
+            const auto want = static_cast<size_t>(std::min<uint64_t>(buffer.size(), length - done));
+            const int64_t n = input.readAt(done, buffer.data(), want);
+            if (n <= 0) return done;  // Shrank since it was measured; the stream stays unterminated
+            buffered = static_cast<size_t>(n);
+        }
+        encoder.write(buffer.data(), buffered, out);
+        const bool last = done + buffered >= length;
+        if (last) {
+            encoder.finish(out);
+        } else {
+            encoder.flush(out);
+        }
+        if (!HTTPResponseWriter::sendChunk(socket, out, last)) return done;
+        out.clear();
+        done += buffered;
+        buffered = 0;
+        if (onProgress) onProgress(done);
+    }
+    return done;
+}
+
+// Content-Disposition value offering a download under the given name; both filename and
+// filename* are given for maximum browser compatibility
+std::string attachmentDisposition(const std::string& filename) {
+    std::ostringstream encoded;
+    for (const unsigned char c : filename) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded << c;
+        } else {
+            encoded << '%' << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
+        }
+    }
+    return "attachment; filename=\"" + filename + "\"; filename*=UTF-8''" + encoded.str();
+}
+
+} // namespace
+
 HTTPServer::HTTPServer(const int port, std::string webRoot, Server* server, const bool useAuth, std::string password)
-    : port_(port), webRoot_(std::move(webRoot)), running_(false), server_(server),
-      useAuth_(useAuth), password_(std::move(password))
+    : port_(port), webRoot_(std::move(webRoot)),
+      assets_(createAssetCache(webRoot_)), router_(ROUTES),
+      events_(std::make_unique<EventStream>(
+          [this] {
+              return std::vector<EventStream::Message>{{"queue", pendingFilesSnapshot()->json},
+                                                       {"devices", devicesSnapshot()->json}};
+          },
+          [this](const std::string& clientIP) {
+              // An open event stream keeps its client counted as connected
+              if (server_ && isRemoteClient(clientIP)) server_->trackHTTPConnection(clientIP);
+          },
+          [this](const std::string& clientIP, const std::string_view message) { return handleControlMessage(clientIP, message); })),
+      running_(false), server_(server), useAuth_(useAuth), password_(std::move(password)),
+      etagPrefix_(makeEtagPrefix())
 {
     Logger::getInstance().debug("HTTPServer constructor - useAuth_: " + std::string(useAuth_ ? "true" : "false") +
                                  ", password_: '" + password_ + "'");
@@ -27,26 +265,310 @@ HTTPServer::~HTTPServer() {
     stop();
 }
 
+namespace {
+
+constexpr size_t MAX_HEADER_SIZE = 1024 * 1024;  // Sanity limit on headers + early body
+constexpr auto HEADER_TIMEOUT = std::chrono::seconds(10);  // Time allowed to send a complete request (head and buffered body)
+constexpr auto KEEP_ALIVE_TIMEOUT = std::chrono::seconds(15);  // Idle time before a persistent connection is closed
+constexpr unsigned MAX_REQUESTS_PER_CONNECTION = 1000;
+constexpr unsigned MIN_TRANSFER_THREADS = 8;  // Each parallel upload stream or download blocks a transfer thread
+constexpr unsigned CONTROL_THREADS = 4;        // Announcements, chunk lists and signatures of a few clients at once
+
+unsigned workerCount() {
+    const unsigned cores = std::thread::hardware_concurrency();
+    return cores == 0 ? 2 : cores;
+}
+
+constexpr uint64_t UPLOAD_CHUNK_SIZE = 4 * 1024 * 1024;  // Chunk size suggested to clients for resumable uploads
+constexpr int DEDUP_VERSION = 1;  // Chunking scheme of ChunkStore that clients reproduce to skip known data
+
+// Value of `name` in an application/x-www-form-urlencoded query string (no percent-decoding)
+std::string queryParam(const std::string_view query, const std::string_view name) {
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        size_t end = query.find('&', pos);
+        if (end == std::string_view::npos) end = query.size();
+        const std::string_view pair = query.substr(pos, end - pos);
+        if (const size_t eq = pair.find('='); eq != std::string_view::npos && pair.substr(0, eq) == name) {
+            return std::string(pair.substr(eq + 1));
+        }
+        pos = end + 1;
+    }
+    return "";
+}
+
+// Simple JSON parsing: the string value of "name" (no unescaping), or "" if absent
+std::string jsonStringField(const std::string_view json, const std::string_view name) {
+    const std::string quoted = "\"" + std::string(name) + "\"";
+    const size_t namePos = json.find(quoted);
+    if (namePos == std::string_view::npos) return "";
+    const size_t colonPos = json.find(':', namePos + quoted.size());
+    if (colonPos == std::string_view::npos) return "";
+    const size_t quoteStart = json.find('"', colonPos + 1);
+    if (quoteStart == std::string_view::npos) return "";
+    const size_t quoteEnd = json.find('"', quoteStart + 1);
+    if (quoteEnd == std::string_view::npos) return "";
+    return std::string(json.substr(quoteStart + 1, quoteEnd - quoteStart - 1));
+}
+
+// Simple JSON parsing: the unsigned integer value of "name", or 0 if absent
+uint64_t jsonNumberField(const std::string_view json, const std::string_view name) {
+    const std::string quoted = "\"" + std::string(name) + "\"";
+    const size_t namePos = json.find(quoted);
+    if (namePos == std::string_view::npos) return 0;
+    const size_t colonPos = json.find(':', namePos + quoted.size());
+    if (colonPos == std::string_view::npos) return 0;
+    size_t numStart = colonPos + 1;
+    while (numStart < json.size() && (json[numStart] == ' ' || json[numStart] == '\t')) ++numStart;
+    uint64_t value = 0;
+    (void)std::from_chars(json.data() + numStart, json.data() + json.size(), value);
+    return value;
+}
+
+// Compares a credential without an early exit, so response timing doesn't reveal how much of it
+// matched; comparing digests keeps the time independent of the lengths too
+bool credentialMatches(const std::string_view given, const std::string_view expected) {
+    const auto a = Hashing::sha256(given.data(), given.size());
+    const auto b = Hashing::sha256(expected.data(), expected.size());
+    uint8_t diff = 0;
+    for (size_t i = 0; i < a.size(); ++i) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+// Decodes %XX escapes and '+' in a query string value
+std::string percentDecode(const std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned value = 0;
+        if (text[i] == '%' && i + 2 < text.size() &&
+            std::from_chars(text.data() + i + 1, text.data() + i + 3, value, 16).ptr == text.data() + i + 3) {
+            out += static_cast<char>(value);
+            i += 2;
+        } else {
+            out += text[i] == '+' ? ' ' : text[i];
+        }
+    }
+    return out;
+}
+
+// Quotes and control characters escaped for use inside a JSON string
+std::string jsonEscape(const std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            constexpr char HEX[] = "0123456789abcdef";
+            out += "\\u00";
+            out += HEX[(c >> 4) & 0xf];
+            out += HEX[c & 0xf];
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// Whether an Accept-Encoding value allows `coding` (a q=0 parameter refuses it)
+bool acceptsEncoding(const std::string_view header, const std::string_view coding) {
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t end = header.find(',', pos);
+        if (end == std::string_view::npos) end = header.size();
+        std::string_view item = header.substr(pos, end - pos);
+        pos = end + 1;
+
+        std::string_view params;
+        if (const size_t semi = item.find(';'); semi != std::string_view::npos) {
+            params = item.substr(semi + 1);
+            item = item.substr(0, semi);
+        }
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+        if (item.size() != coding.size() ||
+            !std::equal(item.begin(), item.end(), coding.begin(),
+                        [](const char a, const char b) { return std::tolower(static_cast<unsigned char>(a)) == b; })) {
+            continue;
+        }
+        const size_t q = params.find("q=");
+        if (q == std::string_view::npos) return true;
+        std::string_view value = params.substr(q + 2);
+        value = value.substr(0, value.find_first_of(" ;"));
+        return value.find_first_not_of("0.") != std::string_view::npos;
+    }
+    return false;
+}
+
+// Whether an If-None-Match value lists `etag` (weak comparison, RFC 9110 13.1.2)
+bool etagMatches(const std::string_view header, const std::string_view etag) {
+    if (header.empty()) return false;
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t end = header.find(',', pos);
+        if (end == std::string_view::npos) end = header.size();
+        std::string_view item = header.substr(pos, end - pos);
+        pos = end + 1;
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+        if (item == "*") return true;
+        if (item.starts_with("W/")) item.remove_prefix(2);
+        if (item == etag) return true;
+    }
+    return false;
+}
+
+// Declared body length of a request; false if Content-Length is malformed or repeated with different values
+bool parseContentLength(const HTTPRequestParser& request, uint64_t& contentLength) {
+    contentLength = 0;
+    std::string_view cl;
+    if (!request.uniqueHeader("Content-Length", cl)) return false;
+    if (cl.empty()) return !request.hasHeader("Content-Length");
+    const auto [ptr, err] = std::from_chars(cl.data(), cl.data() + cl.size(), contentLength);
+    return err == std::errc() && ptr == cl.data() + cl.size();
+}
+
+enum class RangeResult { None, Satisfiable, Unsatisfiable };
+
+// Parses a single "bytes=" range (RFC 9110 14.1.2) against the file size. Anything we don't
+// serve (other units, multiple ranges, bad syntax) is ignored and the full file is sent.
+RangeResult parseByteRange(std::string_view header, const uint64_t size, uint64_t& first, uint64_t& last) {
+    while (!header.empty() && header.front() == ' ') header.remove_prefix(1);
+    while (!header.empty() && header.back() == ' ') header.remove_suffix(1);
+    if (header.size() < 6 || (header.substr(0, 6) != "bytes=" && header.substr(0, 6) != "BYTES=")) return RangeResult::None;
+    header.remove_prefix(6);
+    if (header.find(',') != std::string_view::npos) return RangeResult::None;
+
+    const size_t dash = header.find('-');
+    if (dash == std::string_view::npos) return RangeResult::None;
+
+    auto parseNumber = [](const std::string_view text, uint64_t& out) {
+        const auto [ptr, err] = std::from_chars(text.data(), text.data() + text.size(), out);
+        return !text.empty() && err == std::errc() && ptr == text.data() + text.size();
+    };
+
+    uint64_t a = 0, b = 0;
+    if (dash == 0) {
+        // Suffix range: the last N bytes
+        if (!parseNumber(header.substr(1), b)) return RangeResult::None;
+        if (b == 0 || size == 0) return RangeResult::Unsatisfiable;
+        first = size - std::min(b, size);
+        last = size - 1;
+        return RangeResult::Satisfiable;
+    }
+
+    if (!parseNumber(header.substr(0, dash), a)) return RangeResult::None;
+    const std::string_view end = header.substr(dash + 1);
+    if (end.empty()) {
+        b = UINT64_MAX;
+    } else if (!parseNumber(end, b) || b < a) {
+        return RangeResult::None;
+    }
+    if (a >= size) return RangeResult::Unsatisfiable;
+    first = a;
+    last = std::min(b, size - 1);
+    return RangeResult::Satisfiable;
+}
+
+} // namespace
+
+// One event loop per thread: owns a poller and the connections waiting for a request head
+struct HTTPServer::EventLoop {
+    NetworkUtils::Poller poller;
+    std::mutex inboxMutex;
+    std::vector<std::unique_ptr<HTTPConnection>> inbox;  // Handed over by the acceptor
+    std::unordered_map<SocketType, std::unique_ptr<HTTPConnection>> connections;
+};
+
 bool HTTPServer::start() {
     if (running_) {
         return false;
     }
     
     running_ = true;
+    serverIP_ = NetworkUtils::getLocalIPAddress();
+
+    const unsigned workers = workerCount();
+    for (unsigned i = 0; i < workers; ++i) {
+        auto loop = std::make_unique<EventLoop>();
+        if (!loop->poller.isValid()) {
+            Logger::getInstance().error("Failed to create HTTP event loop poller");
+            continue;
+        }
+        loops_.push_back(std::move(loop));
+    }
+    if (loops_.empty()) {
+        running_ = false;
+        return false;
+    }
+    for (auto& loop : loops_) {
+        loopThreads_.emplace_back(&HTTPServer::runLoop, this, std::ref(*loop));
+    }
+    for (unsigned i = 0; i < std::max(workers, MIN_TRANSFER_THREADS); ++i) {
+        transfers_.threads.emplace_back(&HTTPServer::runPool, this, std::ref(transfers_));
+    }
+    for (unsigned i = 0; i < CONTROL_THREADS; ++i) {
+        controls_.threads.emplace_back(&HTTPServer::runPool, this, std::ref(controls_));
+    }
+
+    if (!events_->start()) {
+        Logger::getInstance().warning("Failed to start the event stream; clients will fall back to polling");
+    }
+
     serverThread_ = std::thread(&HTTPServer::run, this);
     return true;
 }
 
 void HTTPServer::stop() {
-    if (running_) {
-        running_ = false;
-        if (serverThread_.joinable()) {
-            serverThread_.join();
+    running_ = false;
+    events_->stop();
+
+    for (const auto& loop : loops_) {
+        loop->poller.wakeup();
+    }
+    for (WorkPool* pool : {&transfers_, &controls_}) {
+        // Unblock requests stuck in send/recv so their threads can exit
+        std::lock_guard lock(pool->mutex);
+        for (const SocketType s : pool->active) {
+            NetworkUtils::shutdownSocket(s);
+        }
+        pool->cv.notify_all();
+    }
+
+    if (serverThread_.joinable()) {
+        serverThread_.join();
+    }
+    for (auto& t : loopThreads_) {
+        if (t.joinable()) t.join();
+    }
+    for (WorkPool* pool : {&transfers_, &controls_}) {
+        for (auto& t : pool->threads) {
+            if (t.joinable()) t.join();
+        }
+        pool->threads.clear();
+    }
+    loopThreads_.clear();
+    // Connections returned by transfers after their loop exited
+    for (const auto& loop : loops_) {
+        for (auto& conn : loop->inbox) closeConnection(std::move(conn));
+    }
+    loops_.clear();
+
+    for (WorkPool* pool : {&transfers_, &controls_}) {
+        while (!pool->queue.empty()) {
+            closeConnection(std::move(pool->queue.front()));
+            pool->queue.pop_front();
         }
     }
     Logger::getInstance().info("HTTP Server stopped");
 }
 
+void HTTPServer::reloadStaticAssets() {
+    assets_->reload();
+}
+
 bool HTTPServer::isRunning() const {
     return running_;
 }
@@ -66,432 +588,1006 @@ void HTTPServer::run() {
         return;
     }
     
-    if (!NetworkUtils::listenSocket(serverSocket)) {
+    if (!NetworkUtils::listenSocket(serverSocket, SOMAXCONN)) {
         Logger::getInstance().error("Failed to listen on HTTP server socket");
         NetworkUtils::closeSocket(serverSocket);
         running_ = false;
         return;
     }
-    
-    // Silently accept and handle HTTP requests (no logging of every request)
+
+    size_t nextLoop = 0;
+
+    // Silently accept HTTP connections and hand them to the event loops (no logging of every request)
     while (running_) {
         std::string clientAddr;
         // Use non-blocking accept with timeout
         SocketType clientSocket = NetworkUtils::acceptConnectionWithTimeout(serverSocket, clientAddr, 1000); // 1s timeout
-        if (!running_) break;
+        if (!running_) {
+            NetworkUtils::closeSocket(clientSocket);
+            break;
+        }
         if (clientSocket != INVALID_SOCKET) {
             // Track this client connection if it's not localhost, and we have a server reference
-            if (server_ && clientAddr != "127.0.0.1" && clientAddr != "::1" && clientAddr.find("127.") != 0) {
-                // Get server's own IP to filter it out
-                const std::string serverIP = NetworkUtils::getLocalIPAddress();
-                if (clientAddr != serverIP) {
-                    server_->trackHTTPConnection(clientAddr);
-                }
+            if (server_ && isRemoteClient(clientAddr)) {
+                server_->trackHTTPConnection(clientAddr);
             }
 
-            // Handle each request in a separate thread (detached) for non-blocking behavior
-            std::thread([this, clientSocket, clientAddr]() {
-                handleRequest(clientSocket, clientAddr);
-                NetworkUtils::closeSocket(clientSocket);
-            }).detach();
+            setSocketTimeout(clientSocket);
+
+            // Round-robin connections across the event loops
+            const size_t loopIndex = nextLoop++ % loops_.size();
+            EventLoop& loop = *loops_[loopIndex];
+            auto conn = std::make_unique<HTTPConnection>(clientSocket, clientAddr);
+            conn->loopIndex = loopIndex;
+            {
+                std::lock_guard lock(loop.inboxMutex);
+                loop.inbox.push_back(std::move(conn));
+            }
+            loop.poller.wakeup();
         }
     }
     
     NetworkUtils::closeSocket(serverSocket);
 }
 
-// Called from run() method which executes in a separate thread
-void HTTPServer::handleRequest(const SocketType clientSocket, const std::string& clientIP) const {
-    setSocketTimeout(clientSocket);
-
-    auto recvSome = [&](std::vector<uint8_t>& dst) -> int {
-        uint8_t tmp[4096];
-        const int n = NetworkUtils::receiveData(clientSocket, reinterpret_cast<char*>(tmp), sizeof(tmp));
-        if (n > 0) dst.insert(dst.end(), tmp, tmp + n);
-        return n;
+// Event loop thread: reads request heads, and the bodies of requests that are buffered rather than
+// streamed, from all of its connections without blocking on any of them
+void HTTPServer::runLoop(EventLoop& loop) {
+    std::vector<NetworkUtils::Poller::Event> events;
+    std::vector<uint8_t> readBuffer(16 * 1024);
+    auto lastSweep = std::chrono::steady_clock::now();
+
+    auto drop = [&](const SocketType socket) {
+        const auto it = loop.connections.find(socket);
+        if (it == loop.connections.end()) return;
+        loop.poller.remove(socket);
+        auto conn = std::move(it->second);
+        loop.connections.erase(it);
+        closeConnection(std::move(conn));
     };
 
-    // 1) Read until we have full headers: "\r\n\r\n"
-    std::vector<uint8_t> raw;
-    raw.reserve(8192);
+    while (running_) {
+        {
+            std::lock_guard lock(loop.inboxMutex);
+            for (auto& conn : loop.inbox) {
+                const SocketType socket = conn->socket;
+                if (loop.poller.add(socket)) {
+                    loop.connections.emplace(socket, std::move(conn));
+                } else {
+                    closeConnection(std::move(conn));
+                }
+            }
+            loop.inbox.clear();
+        }
 
-    const auto findSeq = [](const std::vector<uint8_t>& hay, const std::string& needle, const size_t start = 0) -> size_t {
-        if (needle.empty()) return std::string::npos;
-        const auto* n = reinterpret_cast<const uint8_t*>(needle.data());
-        for (size_t i = start; i + needle.size() <= hay.size(); ++i) {
-            if (std::memcmp(hay.data() + i, n, needle.size()) == 0) return i;
+        if (loop.poller.wait(events, 1000) < 0) {
+            Logger::getInstance().error("HTTP event loop poll failed");
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
         }
-        return std::string::npos;
-    };
 
-    while (true) {
-        if (raw.size() > 1024 * 1024) return; // sanity limit on headers+early body
-        if (findSeq(raw, "\r\n\r\n") != std::string::npos) break;
-        int n = recvSome(raw);
-        if (n <= 0) return;
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto& ev : events) {
+            const auto it = loop.connections.find(ev.socket);
+            if (it == loop.connections.end()) continue;
+            HTTPConnection& conn = *it->second;
+
+            // Level-triggered readiness: a single recv() never blocks here
+            const int n = NetworkUtils::receiveData(conn.socket, reinterpret_cast<char*>(readBuffer.data()), readBuffer.size());
+            if (n <= 0) {
+                drop(ev.socket);
+                continue;
+            }
+            conn.buffer.insert(conn.buffer.end(), readBuffer.begin(), readBuffer.begin() + n);
+            conn.lastActivity = now;
+
+            // The parser resumes where the previous read left off
+            const auto status = conn.request.parse(conn.buffer.data(), conn.buffer.size());
+            if (status == HTTPRequestParser::Status::Complete) {
+                // Keep reading here until the body is buffered too, so serving it never waits on the client
+                if (!hasWholeRequest(conn)) continue;
+
+                // Complete request: take the connection off this loop while it is served
+                loop.poller.remove(ev.socket);
+                auto ready = std::move(it->second);
+                loop.connections.erase(it);
+                dispatch(std::move(ready));
+            } else if (status == HTTPRequestParser::Status::Error) {
+                static constexpr std::string_view badRequest =
+                    "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                (void)NetworkUtils::sendAll(conn.socket, badRequest.data(), badRequest.size());
+                drop(ev.socket);
+            } else if (conn.buffer.size() > MAX_HEADER_SIZE) {
+                drop(ev.socket);
+            }
+        }
+
+        // Drop idle persistent connections and clients that never finish a request
+        if (now - lastSweep >= std::chrono::seconds(1)) {
+            lastSweep = now;
+            std::vector<SocketType> expired;
+            for (const auto& [socket, conn] : loop.connections) {
+                const bool idle = conn->buffer.empty() && conn->requestsServed > 0;
+                if (now - conn->lastActivity > (idle ? KEEP_ALIVE_TIMEOUT : HEADER_TIMEOUT)) expired.push_back(socket);
+            }
+            for (const SocketType socket : expired) drop(socket);
+        }
     }
 
-    size_t headerEnd = findSeq(raw, "\r\n\r\n");
-    size_t bodyStart = headerEnd + 4;
+    for (auto& [socket, conn] : loop.connections) {
+        loop.poller.remove(socket);
+        closeConnection(std::move(conn));
+    }
+    loop.connections.clear();
+    std::lock_guard lock(loop.inboxMutex);
+    for (auto& conn : loop.inbox) closeConnection(std::move(conn));
+    loop.inbox.clear();
+}
 
-    // Convert ONLY headers to string (safe: headers are text)
-    std::string headerStr(reinterpret_cast<const char*>(raw.data()), headerEnd);
+// Transfer pool thread: serves requests that stream large request or response bodies
+void HTTPServer::runPool(WorkPool& pool) {
+    const Executor executor = &pool == &transfers_ ? Executor::Transfer : Executor::Control;
+    while (true) {
+        std::unique_ptr<HTTPConnection> conn;
+        {
+            std::unique_lock lock(pool.mutex);
+            pool.cv.wait(lock, [this, &pool] { return !running_ || !pool.queue.empty(); });
+            if (!running_) break;
+            conn = std::move(pool.queue.front());
+            pool.queue.pop_front();
+            pool.active.insert(conn->socket);
+        }
 
-    // 2) Parse request line (method/path)
-    size_t lineEnd = headerStr.find("\r\n");
-    if (lineEnd == std::string::npos) return;
-    std::string requestLine = headerStr.substr(0, lineEnd);
+        const SocketType socket = conn->socket;
+        serve(std::move(conn), executor);
 
-    size_t methodEnd = requestLine.find(' ');
-    size_t pathEnd   = requestLine.find(' ', methodEnd + 1);
-    if (methodEnd == std::string::npos || pathEnd == std::string::npos) return;
+        {
+            std::lock_guard lock(pool.mutex);
+            pool.active.erase(socket);
+        }
+    }
+}
 
-    std::string method = requestLine.substr(0, methodEnd);
-    std::string path   = requestLine.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+void HTTPServer::dispatch(std::unique_ptr<HTTPConnection> conn) {
+    serve(std::move(conn), Executor::EventLoop);
+}
 
-    Logger::getInstance().debug("[HTTP] " + method + " " + path + " from " + clientIP);
+// Answers every complete request buffered on the connection, in order, then hands the
+// connection back to its event loop (keep-alive) or closes it. A request meant for another
+// executor is handed over with the connection; a transfer thread serves whatever follows.
+void HTTPServer::serve(std::unique_ptr<HTTPConnection> conn, const Executor current) {
+    while (conn->request.parse(conn->buffer.data(), conn->buffer.size()) == HTTPRequestParser::Status::Complete) {
+        if (current != Executor::Transfer) {
+            // A pipelined request whose body is still arriving goes back to the loop until it is buffered
+            if (!hasWholeRequest(*conn)) break;
+
+            const Executor wanted = executorFor(conn->request);
+            if (wanted != current && wanted != Executor::EventLoop) {
+                WorkPool& pool = wanted == Executor::Transfer ? transfers_ : controls_;
+                {
+                    std::lock_guard lock(pool.mutex);
+                    pool.queue.push_back(std::move(conn));
+                }
+                pool.cv.notify_one();
+                return;
+            }
+        }
 
-    if (size_t queryPos = path.find('?'); queryPos != std::string::npos) {
-        path = path.substr(0, queryPos);
-    }
-
-    // Handle CORS preflight OPTIONS requests
-    if (method == "OPTIONS") {
-        std::string response = "HTTP/1.1 204 No Content\r\n";
-        response += "Access-Control-Allow-Origin: *\r\n";
-        response += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
-        response += "Access-Control-Allow-Headers: Content-Type, Cache-Control, Pragma, Expires\r\n";
-        response += "Access-Control-Max-Age: 86400\r\n";
-        response += "Content-Length: 0\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        (void)NetworkUtils::sendData(clientSocket, response);
+        if (!handleRequest(*conn) || !running_) {
+            closeConnection(std::move(conn));
+            return;
+        }
+        ++conn->requestsServed;
+        conn->request.reset();
+    }
+    if (conn->request.status() == HTTPRequestParser::Status::Error) {
+        closeConnection(std::move(conn)); // Malformed pipelined request
         return;
     }
 
-    // Helper: get a header value (case-insensitive match for typical headers)
-    auto getHeaderValue = [&](const std::string& name) -> std::string {
-        std::string needle = "\r\n" + name + ":";
-        size_t p = headerStr.find(needle);
-        if (p == std::string::npos) {
-            // also allow header at start (first line already removed)
-            needle = name + ":";
-            p = headerStr.find(needle);
-            if (p != 0) return "";
-        } else {
-            p += 2; // skip leading \r\n
-        }
-        p += name.size() + 1; // skip "Name:"
-        while (p < headerStr.size() && headerStr[p] == ' ') ++p;
-        size_t e = headerStr.find("\r\n", p);
-        if (e == std::string::npos) e = headerStr.size();
-        return headerStr.substr(p, e - p);
+    conn->lastActivity = std::chrono::steady_clock::now();
+    EventLoop& loop = *loops_[conn->loopIndex];
+    {
+        std::lock_guard lock(loop.inboxMutex);
+        loop.inbox.push_back(std::move(conn));
+    }
+    loop.poller.wakeup();
+}
+
+std::string_view HTTPServer::connectionHeader(const HTTPConnection& conn) {
+    return conn.keepAlive ? HttpHeaders::KeepAlive : HttpHeaders::Close;
+}
+
+void HTTPServer::closeConnection(std::unique_ptr<HTTPConnection> conn) const {
+    if (conn) {
+        NetworkUtils::closeSocket(conn->socket);
+    }
+}
+
+// A request can be served once its head is parsed and, unless its route streams the body, the whole
+// body has arrived. Requests that will be refused without reading the body count as whole.
+bool HTTPServer::hasWholeRequest(const HTTPConnection& conn) const {
+    uint64_t contentLength = 0;
+    if (!parseContentLength(conn.request, contentLength) || contentLength == 0 || contentLength > MAX_HEADER_SIZE) {
+        return true;
+    }
+    const RouteMatch match = router_.match(conn.request.method(), conn.request.path());
+    if (match.route && match.route->options.streamsBody) return true;
+    return conn.buffer.size() - conn.request.headSize() >= contentLength;
+}
+
+// Uploads and downloads may run for minutes and must not block an event loop; requests that
+// touch the disk briefly must not wait behind them either
+Executor HTTPServer::executorFor(const HTTPRequestParser& request) const {
+    const RouteMatch match = router_.match(request.method(), request.path());
+    return match.route ? match.route->options.executor : Executor::EventLoop;
+}
+
+bool HTTPServer::handleRequest(HTTPConnection& conn) const {
+    const SocketType clientSocket = conn.socket;
+    const std::string& clientIP = conn.clientIP;
+
+    auto recvSome = [&](std::vector<uint8_t>& dst) -> int {
+        uint8_t tmp[4096];
+        const int n = NetworkUtils::receiveData(clientSocket, reinterpret_cast<char*>(tmp), sizeof(tmp));
+        if (n > 0) dst.insert(dst.end(), tmp, tmp + n);
+        return n;
     };
 
-    // --- File upload handling ---
-    if (path == "/api/upload" && method == "POST") {
-        // 3) Read full body using Content-Length
-        std::string cl = getHeaderValue("Content-Length");
-        if (cl.empty()) return;
+    // 1) The event loop only hands over connections whose request head has been parsed
+    HTTPRequestParser& request = conn.request;
+    std::vector<uint8_t> raw = std::move(conn.buffer);
+    request.rebase(raw.data());
+    const size_t bodyStart = request.headSize();
+
+    // 2) Request line (copied: streaming handlers release the receive buffer)
+    const std::string method(request.method());
+    const std::string path(request.path());
+    const std::string query(request.query());
 
-        size_t contentLength = 0;
-        try { contentLength = std::stoull(cl); }
-        catch (...) { return; }
+    Logger::getInstance().debug("[HTTP] " + method + " " + path + " from " + clientIP);
+
+    // 3) Decide whether the connection survives this request (HTTP/1.1 defaults to keep-alive)
+    conn.keepAlive = request.version() == "HTTP/1.1"
+        ? !request.headerHasToken("Connection", "close")
+        : request.headerHasToken("Connection", "keep-alive");
+    if (conn.requestsServed + 1 >= MAX_REQUESTS_PER_CONNECTION) conn.keepAlive = false;
+
+    // Chunked request bodies are not supported; without a length the body can't be skipped
+    if (request.hasHeader("Transfer-Encoding")) conn.keepAlive = false;
+
+    // A malformed or conflicting length leaves the framing of the following requests ambiguous (RFC 9112 6.3)
+    uint64_t contentLength = 0;
+    if (!parseContentLength(request, contentLength)) {
+        conn.keepAlive = false;
+        static constexpr std::string_view text = "Bad Request";
+        HTTPResponseWriter response(HttpStatus::BadRequest);
+        response.add(HttpHeaders::PlainText).contentLength(text.size()).add(connectionHeader(conn));
+        (void)response.send(clientSocket, text);
+        return false;
+    }
+
+    // 4) Route; a preflight is routed as the request it announces
+    const bool preflight = method == "OPTIONS";
+    const RouteMatch match = router_.match(preflight ? request.header("Access-Control-Request-Method") : method, path);
 
-        // Ensure we have exactly Content-Length bytes after headers
+    // Buffer small request bodies completely; uploads stream theirs. The event loop has already
+    // buffered the body unless this runs on a transfer thread, where waiting for it is harmless.
+    // Whatever follows the body belongs to the next pipelined request and is handed back to the connection.
+    if (!match.route || !match.route->options.streamsBody) {
+        if (contentLength > MAX_HEADER_SIZE) return false;
         while (raw.size() - bodyStart < contentLength) {
-            if (int n = recvSome(raw); n <= 0)
-                break;
+            if (recvSome(raw) <= 0) return false;
         }
-        if (raw.size() - bodyStart < contentLength) return;
-
-        // Copy body bytes
-        std::vector body(raw.begin() + bodyStart, raw.begin() + bodyStart + contentLength);
-
-        // 4) Parse multipart boundary from Content-Type
-        std::string ct = getHeaderValue("Content-Type");
-        size_t bpos = ct.find("boundary=");
-        if (bpos == std::string::npos) return;
-        std::string boundaryToken = ct.substr(bpos + 9);
-        // Trim optional quotes and spaces
-        while (!boundaryToken.empty() && (boundaryToken.front() == ' ')) boundaryToken.erase(boundaryToken.begin());
-        if (!boundaryToken.empty() && boundaryToken.front() == '"') {
-            boundaryToken.erase(boundaryToken.begin());
-            if (size_t q = boundaryToken.find('"'); q != std::string::npos)
-                boundaryToken.resize(q);
-        } else {
-            if (size_t sc = boundaryToken.find(';'); sc != std::string::npos)
-                boundaryToken.resize(sc);
+        request.rebase(raw.data()); // Reading the body may have moved the buffer
+        conn.buffer.assign(raw.begin() + static_cast<std::ptrdiff_t>(bodyStart + contentLength), raw.end());
+    }
+
+    if (preflight) return sendPreflight(conn, match);
+
+    if (!match.route) {
+        const std::string_view status = match.allowedMethods ? HttpStatus::MethodNotAllowed : HttpStatus::NotFound;
+        const std::string_view text = status.substr(9, status.size() - 11); // Reason phrase as the body
+        HTTPResponseWriter response(status);
+        if (match.allowedMethods) response.header("Allow", Router::methodList(match.allowedMethods));
+        response.add(HttpHeaders::PlainText).contentLength(text.size()).add(connectionHeader(conn));
+        (void)response.send(clientSocket, text);
+        return conn.keepAlive;
+    }
+
+    const RouteOptions& options = match.route->options;
+    if (options.requiresAuth && !isAuthorized(request)) {
+        if (options.streamsBody) conn.keepAlive = false; // Body is left unread
+        (void)sendJson(conn, options, HttpStatus::Unauthorized, R"({"status":"unauthorized"})");
+        return conn.keepAlive;
+    }
+
+    RequestContext ctx{request, match, method, path, query, raw, bodyStart, contentLength};
+    switch (static_cast<Endpoint>(match.route->handler)) {
+    case Endpoint::Upload:           return handleUpload(conn, ctx);
+    case Endpoint::UploadAnnounce:   return handleUploadAnnounce(conn, ctx);
+    case Endpoint::UploadSession:    return handleUploadSession(conn, ctx);
+    case Endpoint::UploadChunkList:  return handleUploadChunkList(conn, ctx);
+    case Endpoint::UploadSignature:  return handleUploadSignature(conn, ctx);
+    case Endpoint::UploadDelta:      return handleUploadDelta(conn, ctx);
+    case Endpoint::Heartbeat:        return handleHeartbeat(conn, ctx);
+    case Endpoint::AuthConfig:       return sendJson(conn, options, HttpStatus::Ok, getAuthConfig());
+    case Endpoint::Login:            return handleLogin(conn, ctx);
+    case Endpoint::ConnectedDevices: return sendSnapshot(conn, ctx, *devicesSnapshot());
+    case Endpoint::PendingFiles:     return sendSnapshot(conn, ctx, *pendingFilesSnapshot());
+    case Endpoint::Download:         return handleDownload(conn, ctx);
+    case Endpoint::Archive:          return handleArchive(conn, ctx);
+    case Endpoint::Events:           return handleEvents(conn, ctx);
+    case Endpoint::WebSocket:        return handleWebSocket(conn, ctx);
+    case Endpoint::StaticFile:       return handleStaticFile(conn, ctx);
+    }
+    return false;
+}
+
+// EventSource can't send headers, so the credential may also come as an "auth" query parameter
+bool HTTPServer::isAuthorized(const HTTPRequestParser& request) const {
+    return !useAuth_ || credentialMatches(request.header("X-Blade-Auth"), password_) ||
+           credentialMatches(percentDecode(queryParam(request.query(), "auth")), password_);
+}
+
+// Local connections (this PC's browser) are not shown as connected devices
+bool HTTPServer::isRemoteClient(const std::string& clientIP) const {
+    return clientIP != "127.0.0.1" && clientIP != "::1" && !clientIP.starts_with("127.") && clientIP != serverIP_;
+}
+
+bool HTTPServer::sendPreflight(HTTPConnection& conn, const RouteMatch& match) {
+    HTTPResponseWriter response(HttpStatus::NoContent);
+    if (match.allowedMethods) response.header("Allow", Router::methodList(match.allowedMethods | HttpMethod::Options));
+    if (match.route && match.route->options.cors) {
+        response.header("Access-Control-Allow-Methods", Router::methodList(match.allowedMethods));
+        response.add(PREFLIGHT_HEADERS);
+    }
+    response.contentLength(0).add(connectionHeader(conn));
+    (void)response.send(conn.socket);
+    return conn.keepAlive;
+}
+
+bool HTTPServer::sendJson(HTTPConnection& conn, const RouteOptions& options, const std::string_view status,
+                          const std::string_view json) {
+    HTTPResponseWriter response(status);
+    response.add(HttpHeaders::Json).contentLength(json.size()).add(policyHeaders(options)).add(connectionHeader(conn));
+    (void)response.send(conn.socket, json);
+    return conn.keepAlive;
+}
+
+// Multipart upload: every part is streamed straight to disk
+bool HTTPServer::handleUpload(HTTPConnection& conn, RequestContext& ctx) const {
+    const SocketType clientSocket = conn.socket;
+    const uint64_t contentLength = ctx.contentLength;
+    std::vector<uint8_t>& raw = ctx.raw;
+    if (!ctx.head.hasHeader("Content-Length")) return false;
+
+    // Parse multipart boundary from Content-Type
+    const std::string boundaryToken = MultipartParser::boundaryFromContentType(std::string(ctx.head.header("Content-Type")));
+    if (boundaryToken.empty()) return false;
+
+    // Closing delimiter after the last part: "\r\n--" + boundary + "--\r\n"
+    const uint64_t trailerSize = boundaryToken.size() + 8;
+    std::unique_ptr<UploadSink> sink;
+    bool anyOk = false;
+
+    MultipartParser parser(boundaryToken, {
+        [&](const std::string& partFilename) {
+            const std::string filename = partFilename.empty() ? "upload.bin" : partFilename;
+            // Remaining body minus the closing delimiter is exact for single-file requests
+            const uint64_t offset = parser.bytesConsumed();
+            const uint64_t expected = contentLength > offset + trailerSize ? contentLength - offset - trailerSize : 0;
+            sink = server_ ? server_->handleUpload(filename, expected) : nullptr;
+            return sink != nullptr;
+        },
+        [&](const uint8_t* data, const size_t len) {
+            return sink->write(data, len);
+        },
+        [&] {
+            const bool ok = sink->finish();
+            sink.reset();
+            anyOk = anyOk || ok;
+            return ok;
         }
+    });
 
-        std::string boundary = "--" + boundaryToken;
-        std::string boundaryNext = "\r\n" + boundary;
+    uint64_t received = std::min<uint64_t>(raw.size() - ctx.bodyStart, contentLength);
+    bool parsedOk = parser.feed(raw.data() + ctx.bodyStart, static_cast<size_t>(received));
+    if (raw.size() > ctx.bodyStart + contentLength) {
+        conn.buffer.assign(raw.begin() + static_cast<std::ptrdiff_t>(ctx.bodyStart + contentLength), raw.end());
+    }
+    raw.clear();
+    raw.shrink_to_fit();
+
+    constexpr size_t CHUNK_SIZE = 64 * 1024; // Bounded receive buffer regardless of upload size
+    std::vector<uint8_t> chunk(CHUNK_SIZE);
+    while (parsedOk && received < contentLength) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(chunk.size(), contentLength - received));
+        const int n = NetworkUtils::receiveData(clientSocket, reinterpret_cast<char*>(chunk.data()), want);
+        if (n <= 0) {
+            Logger::getInstance().warning("Upload connection lost after " + std::to_string(received) + "/" + std::to_string(contentLength) + " bytes from " + conn.clientIP);
+            parsedOk = false;
+            break;
+        }
+        received += static_cast<uint64_t>(n);
+        parsedOk = parser.feed(chunk.data(), static_cast<size_t>(n));
+    }
+    sink.reset(); // Drops any part left unfinished by a truncated body
+    anyOk = anyOk && parsedOk;
+    // A body that was not read to the end leaves the stream out of sync
+    if (received < contentLength) conn.keepAlive = false;
+
+    const std::string_view text = anyOk ? "OK" : "ERROR";
+    HTTPResponseWriter response(anyOk ? HttpStatus::Ok : HttpStatus::InternalServerError);
+    response.add(HttpHeaders::PlainText).contentLength(text.size())
+            .add(policyHeaders(ctx.match.route->options)).add(connectionHeader(conn));
+    (void)response.send(clientSocket, text);
+    return conn.keepAlive;
+}
 
-        size_t partPos = 0;
-        bool anyOk = false;
-        while ((partPos = findSeq(body, boundary, partPos)) != std::string::npos) {
-            partPos += boundary.size();
-            // Skip optional leading \r\n
-            if (partPos + 2 <= body.size() && body[partPos] == '\r' && body[partPos + 1] == '\n') {
-                partPos += 2;
-            }
-            // Check for end marker
-            if (partPos + 2 <= body.size() && body[partPos] == '-' && body[partPos + 1] == '-') {
-                break; // End of multipart
-            }
+// Upload announcement: notifies the UI before the upload starts and opens a resumable session
+bool HTTPServer::handleUploadAnnounce(HTTPConnection& conn, RequestContext& ctx) const {
+    const RouteOptions& options = ctx.match.route->options;
 
-            // Find headers end
-            size_t headersEnd = findSeq(body, "\r\n\r\n", partPos);
-            if (headersEnd == std::string::npos) break;
+    // Parse JSON body for filename and size
+    const std::string bodyStr(ctx.raw.begin() + static_cast<std::ptrdiff_t>(ctx.bodyStart),
+                              ctx.raw.begin() + static_cast<std::ptrdiff_t>(ctx.bodyStart + ctx.contentLength));
 
-            std::string partHeaderStr(reinterpret_cast<const char*>(&body[partPos]), headersEnd - partPos);
+    const std::string filename = jsonStringField(bodyStr, "filename");
+    const uint64_t fileSize = jsonNumberField(bodyStr, "size");
 
-            // Extract filename
-            std::string filename;
-            if (size_t fn = partHeaderStr.find("filename="); fn != std::string::npos) {
-                fn += 9;
-                if (fn < partHeaderStr.size() && partHeaderStr[fn] == '"') {
-                    ++fn;
-                    if (size_t endq = partHeaderStr.find('"', fn); endq != std::string::npos)
-                        filename = partHeaderStr.substr(fn, endq - fn);
-                } else {
-                    size_t end = partHeaderStr.find(';', fn);
-                    if (end == std::string::npos) end = partHeaderStr.find("\r\n", fn);
-                    filename = partHeaderStr.substr(fn, end - fn);
-                }
-            }
-            if (filename.empty()) filename = "upload.bin";
+    std::string_view status;
+    const std::string json = announceUpload(filename, fileSize, conn.clientIP, status);
+    if (json.empty()) return sendJson(conn, options, HttpStatus::BadRequest, R"({"status":"error"})");
+    return sendJson(conn, options, status, json);
+}
 
-            // File data
-            size_t dataStart = headersEnd + 4;
-            size_t nextBoundary = findSeq(body, boundaryNext, dataStart);
-            if (nextBoundary == std::string::npos) break;
-            size_t dataEnd = nextBoundary;
+// Announces an upload and opens its resumable session; returns the reply JSON, or "" if invalid.
+// A refused upload gets an error reply with a reason, and the client doesn't send the file.
+std::string HTTPServer::announceUpload(const std::string& filename, const uint64_t fileSize, const std::string& clientIP,
+                                       std::string_view& status) const {
+    if (filename.empty() || !server_) return "";
+
+    // Every announced file also gets a resumable chunked upload session
+    UploadRefusal refusal = UploadRefusal::None;
+    const std::string uploadId = server_->beginUploadSession(filename, fileSize, clientIP, refusal);
+    if (refusal == UploadRefusal::InsufficientSpace) {
+        status = HttpStatus::InsufficientStorage;
+        return R"({"status":"error","reason":"insufficient-space"})";
+    }
+    if (refusal == UploadRefusal::TooManySessions) {
+        status = HttpStatus::TooManyRequests;
+        return R"({"status":"error","reason":"too-many-uploads"})";
+    }
 
-            if (std::vector fileData(body.begin() + dataStart, body.begin() + dataEnd);
-                server_ && server_->handleUpload(filename, fileData, fileData.size())) {
-                anyOk = true;
-            }
+    server_->announceIncomingFile(filename, fileSize);
+    status = HttpStatus::Ok;
+    std::string json = "{\"status\":\"ok\"";
+    if (!uploadId.empty()) {
+        json += ",\"uploadId\":\"" + uploadId + "\",\"chunkSize\":" + std::to_string(UPLOAD_CHUNK_SIZE);
+        // Version of the content-defined chunking the client must use for /api/upload/{id}/chunks
+        json += ",\"dedup\":" + std::to_string(DEDUP_VERSION);
+    }
+    json += "}";
+    return json;
+}
 
-            partPos = nextBoundary;
+// Chunked upload sessions: PUT /api/upload/{id}?offset=N, GET for status, DELETE to cancel
+bool HTTPServer::handleUploadSession(HTTPConnection& conn, RequestContext& ctx) const {
+    const RouteOptions& options = ctx.match.route->options;
+    const std::string sessionId(ctx.match.param("id"));
+    if (ctx.method == "PUT") {
+        uint64_t offset = 0;
+        const std::string offsetStr = queryParam(ctx.query, "offset");
+        const auto [ptr, err] = std::from_chars(offsetStr.data(), offsetStr.data() + offsetStr.size(), offset);
+        if (offsetStr.empty() || err != std::errc() || ptr != offsetStr.data() + offsetStr.size()) {
+            conn.keepAlive = false; // Body is left unread
+            (void)sendJson(conn, options, HttpStatus::BadRequest, R"({"status":"error"})");
+            return false;
         }
+        return handleUploadChunk(conn, sessionId, offset, ctx.contentLength, ctx.raw, ctx.bodyStart);
+    }
 
-        std::string resp = anyOk
-            ? "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\nConnection: close\r\n\r\nOK"
-            : "HTTP/1.1 500 Internal Server Error\r\nContent-Type: text/plain\r\nContent-Length: 5\r\nConnection: close\r\n\r\nERROR";
-        (void)NetworkUtils::sendData(clientSocket, resp);
-        return;
+    std::string json;
+    if (server_ && ctx.method == "DELETE") {
+        if (server_->cancelUploadSession(sessionId)) json = "{\"status\":\"cancelled\"}";
+    } else if (server_) {
+        json = server_->getUploadSessionJson(sessionId);
     }
-    // --- End file upload handling ---
+    if (json.empty()) return sendJson(conn, options, HttpStatus::NotFound, R"({"status":"error"})");
+    return sendJson(conn, options, HttpStatus::Ok, json);
+}
 
-    // --- Handle file upload announcement (notify UI before upload starts) ---
-    if (path == "/api/upload/announce" && method == "POST") {
-        // Read body
-        std::string cl = getHeaderValue("Content-Length");
-        size_t contentLength = 0;
-        if (!cl.empty()) {
-            try { contentLength = std::stoull(cl); }
-            catch (...) { contentLength = 0; }
+// Chunk list of an upload session: POST /api/upload/{id}/chunks?offset=N with one
+// "<sha256 hex> <length>" line per consecutive chunk from offset N on. The server copies
+// the chunks it already has and replies with the session status, whose ranges are then
+// all the client has left to send.
+bool HTTPServer::handleUploadChunkList(HTTPConnection& conn, RequestContext& ctx) const {
+    const RouteOptions& options = ctx.match.route->options;
+    const std::string sessionId(ctx.match.param("id"));
+
+    uint64_t offset = 0;
+    if (const std::string offsetStr = queryParam(ctx.query, "offset"); !offsetStr.empty()) {
+        const auto [ptr, err] = std::from_chars(offsetStr.data(), offsetStr.data() + offsetStr.size(), offset);
+        if (err != std::errc() || ptr != offsetStr.data() + offsetStr.size()) {
+            return sendJson(conn, options, HttpStatus::BadRequest, R"({"status":"error"})");
         }
+    }
 
-        // Read body data
-        while (raw.size() - bodyStart < contentLength) {
-            if (int n = recvSome(raw); n <= 0)
-                break;
+    const std::string_view body(reinterpret_cast<const char*>(ctx.raw.data()) + ctx.bodyStart, ctx.contentLength);
+    std::vector<ChunkStore::Chunk> chunks;
+    for (size_t pos = 0; pos < body.size();) {
+        size_t eol = body.find('\n', pos);
+        if (eol == std::string_view::npos) eol = body.size();
+        std::string_view line = body.substr(pos, eol - pos);
+        pos = eol + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+
+        const size_t space = line.find(' ');
+        const auto digest = ChunkStore::parseDigest(line.substr(0, space));
+        ChunkStore::Chunk chunk;
+        const std::string_view length = space == std::string_view::npos ? std::string_view{} : line.substr(space + 1);
+        const auto [ptr, err] = std::from_chars(length.data(), length.data() + length.size(), chunk.length);
+        if (!digest || length.empty() || err != std::errc() || ptr != length.data() + length.size() ||
+            chunk.length == 0 || chunk.length > ChunkStore::MAX_CHUNK_SIZE) {
+            return sendJson(conn, options, HttpStatus::BadRequest, R"({"status":"error"})");
         }
+        chunk.digest = *digest;
+        chunks.push_back(chunk);
+    }
 
-        // Parse JSON body for filename and size
-        std::string bodyStr(raw.begin() + bodyStart, raw.begin() + bodyStart + contentLength);
+    const std::string json = server_ ? server_->fillUploadFromChunkStore(sessionId, offset, chunks) : "";
+    if (json.empty()) return sendJson(conn, options, HttpStatus::NotFound, R"({"status":"error"})");
+    return sendJson(conn, options, HttpStatus::Ok, json);
+}
 
-        // Simple JSON parsing for {"filename": "...", "size": ...}
-        std::string filename;
-        uint64_t fileSize = 0;
+// Signature of the saved file an upload session would update (see DeltaPatcher); 404 if there is none
+bool HTTPServer::handleUploadSignature(HTTPConnection& conn, RequestContext& ctx) const {
+    const std::string signature = server_ ? server_->getUploadBasisSignature(std::string(ctx.match.param("id"))) : "";
+    if (signature.empty()) return sendJson(conn, ctx.match.route->options, HttpStatus::NotFound, R"({"status":"error"})");
 
-        // Extract filename
-        if (size_t fnPos = bodyStr.find("\"filename\""); fnPos != std::string::npos) {
-            size_t colonPos = bodyStr.find(':', fnPos);
-            if (colonPos != std::string::npos) {
-                size_t quoteStart = bodyStr.find('"', colonPos + 1);
-                if (quoteStart != std::string::npos) {
-                    size_t quoteEnd = bodyStr.find('"', quoteStart + 1);
-                    if (quoteEnd != std::string::npos) {
-                        filename = bodyStr.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                    }
-                }
-            }
+    HTTPResponseWriter response(HttpStatus::Ok);
+    response.add(HttpHeaders::OctetStream).contentLength(signature.size())
+            .add(policyHeaders(ctx.match.route->options)).add(connectionHeader(conn));
+    (void)response.send(conn.socket, signature);
+    return conn.keepAlive;
+}
+
+// Delta upload: PUT /api/upload/{id}/delta?basis=T&basisSize=N&sha256=H[&replace=1] with the
+// operation stream as the body, where T and N are the basis modification time and size from the
+// signature and H is the SHA-256 of the client's whole file. 409 if the basis changed. The result
+// is saved next to the basis unless replace=1.
+bool HTTPServer::handleUploadDelta(HTTPConnection& conn, RequestContext& ctx) const {
+    const std::string sessionId(ctx.match.param("id"));
+    const auto parseInteger = [](const std::string& text, auto& out) {
+        const auto [ptr, err] = std::from_chars(text.data(), text.data() + text.size(), out);
+        return !text.empty() && err == std::errc() && ptr == text.data() + text.size();
+    };
+    int64_t basisModified = 0;
+    uint64_t basisSize = 0;
+    const auto digest = ChunkStore::parseDigest(queryParam(ctx.query, "sha256"));
+    if (!parseInteger(queryParam(ctx.query, "basis"), basisModified) ||
+        !parseInteger(queryParam(ctx.query, "basisSize"), basisSize) || !digest) {
+        conn.keepAlive = false; // Body is left unread
+        (void)sendJson(conn, ctx.match.route->options, HttpStatus::BadRequest, R"({"status":"error"})");
+        return false;
+    }
+
+    const bool replace = queryParam(ctx.query, "replace") == "1";
+    std::unique_ptr<UploadSink> sink =
+        server_ ? server_->openUploadDelta(sessionId, basisModified, basisSize, *digest, replace) : nullptr;
+    if (!sink) {
+        conn.keepAlive = false;
+        const std::string status = server_ ? server_->getUploadSessionJson(sessionId) : "";
+        if (status.empty()) (void)sendJson(conn, ctx.match.route->options, HttpStatus::NotFound, R"({"status":"error"})");
+        else (void)sendJson(conn, ctx.match.route->options, HttpStatus::Conflict, status);
+        return false;
+    }
+    return receiveUploadBody(conn, sessionId, std::move(sink), ctx.contentLength, ctx.raw, ctx.bodyStart);
+}
+
+// Login: POST /api/login with the password as the body. It is only ever checked here; clients
+// learn nothing about it beyond whether it matched.
+bool HTTPServer::handleLogin(HTTPConnection& conn, RequestContext& ctx) const {
+    const RouteOptions& options = ctx.match.route->options;
+    const std::string_view password(reinterpret_cast<const char*>(ctx.raw.data()) + ctx.bodyStart, ctx.contentLength);
+    if (!useAuth_ || credentialMatches(password, password_)) return sendJson(conn, options, HttpStatus::Ok, R"({"status":"ok"})");
+    Logger::getInstance().warning("Failed login attempt from " + conn.clientIP);
+    return sendJson(conn, options, HttpStatus::Unauthorized, R"({"status":"unauthorized"})");
+}
+
+bool HTTPServer::handleHeartbeat(HTTPConnection& conn, RequestContext& ctx) const {
+    if (!server_) return false;
+    return sendJson(conn, ctx.match.route->options, HttpStatus::Ok, server_->handleHeartbeat(conn.clientIP));
+}
+
+// File download: /api/download/{id} or /api/download/{id}/{name}, where id is the transfer ID
+bool HTTPServer::handleDownload(HTTPConnection& conn, RequestContext& ctx) const {
+    uint64_t transferId = 0;
+    const std::string_view id = ctx.match.param("id");
+    const auto [ptr, err] = std::from_chars(id.data(), id.data() + id.size(), transferId);
+    if (server_ && err == std::errc() && ptr == id.data() + id.size()) {
+        if (const auto pending = server_->getPendingFile(transferId)) {
+            if (pending->folder) return handleFolderDownload(conn, *pending, ctx.method == "HEAD");
+            // A compressed body is sent in chunked coding, which HTTP/1.0 clients don't understand
+            const std::string_view acceptEncoding = ctx.head.version() == "HTTP/1.1" ? ctx.head.header("Accept-Encoding")
+                                                                                      : std::string_view{};
+            return handleFileDownload(conn, transferId, pending->path, ctx.method == "HEAD",
+                                      ctx.head.header("Range"), ctx.head.header("If-Range"), acceptEncoding);
         }
+    }
 
-        // Extract size
-        if (size_t szPos = bodyStr.find("\"size\""); szPos != std::string::npos) {
-            size_t colonPos = bodyStr.find(':', szPos);
-            if (colonPos != std::string::npos) {
-                size_t numStart = colonPos + 1;
-                while (numStart < bodyStr.size() && (bodyStr[numStart] == ' ' || bodyStr[numStart] == '\t')) ++numStart;
-                size_t numEnd = numStart;
-                while (numEnd < bodyStr.size() && bodyStr[numEnd] >= '0' && bodyStr[numEnd] <= '9') ++numEnd;
-                if (numEnd > numStart) {
-                    try { fileSize = std::stoull(bodyStr.substr(numStart, numEnd - numStart)); }
-                    catch (...) { fileSize = 0; }
-                }
-            }
+    HTTPResponseWriter response(HttpStatus::NotFound);
+    response.add(HttpHeaders::PlainText).contentLength(FILE_NOT_FOUND.size()).add(connectionHeader(conn));
+    (void)response.send(conn.socket, FILE_NOT_FOUND);
+    return conn.keepAlive;
+}
+
+// "Download all": the pending files, or those listed in ?ids=, as one ZIP archive streamed
+// as the files are read. Stored entries make the archive's length known up front;
+// ?method=deflate compresses them, and the body then ends when the connection closes.
+bool HTTPServer::handleArchive(HTTPConnection& conn, RequestContext& ctx) const {
+    const SocketType clientSocket = conn.socket;
+    const bool headOnly = ctx.method == "HEAD";
+    std::vector<PendingFile> files;
+    if (server_) files = server_->getPendingFiles();
+    // Folders download as tar streams of their own
+    std::erase_if(files, [](const PendingFile& file) { return file.folder; });
+
+    if (const std::string ids = percentDecode(queryParam(ctx.query, "ids")); !ids.empty()) {
+        std::unordered_set<uint64_t> wanted;
+        for (size_t pos = 0; pos <= ids.size();) {
+            size_t end = ids.find(',', pos);
+            if (end == std::string::npos) end = ids.size();
+            uint64_t id = 0;
+            if (std::from_chars(ids.data() + pos, ids.data() + end, id).ec == std::errc()) wanted.insert(id);
+            pos = end + 1;
         }
+        std::erase_if(files, [&](const PendingFile& file) { return !wanted.contains(file.id); });
+    }
 
-        std::string resp;
-        if (!filename.empty() && server_) {
-            server_->announceIncomingFile(filename, fileSize);
-            resp = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nAccess-Control-Allow-Origin: *\r\nContent-Length: 15\r\nConnection: close\r\n\r\n{\"status\":\"ok\"}";
-        } else {
-            resp = "HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\nAccess-Control-Allow-Origin: *\r\nContent-Length: 18\r\nConnection: close\r\n\r\n{\"status\":\"error\"}";
+    // Measured anew, as for a single download, since the length is announced before any data is read
+    std::erase_if(files, [&](PendingFile& file) {
+        std::error_code ec;
+        const uint64_t size = std::filesystem::file_size(file.path, ec);
+        const auto modified = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(file.path, ec);
+        if (ec) {
+            server_->removePendingFile(file.id);
+            return true;
         }
-        (void)NetworkUtils::sendData(clientSocket, resp);
-        return;
+        server_->updatePendingFile(file.id, size, modified);
+        file.size = size;
+        file.modified = modified;
+        return !headOnly && !server_->beginPendingFileDownload(file.id);
+    });
+
+    if (files.empty()) {
+        HTTPResponseWriter response(HttpStatus::NotFound);
+        response.add(HttpHeaders::PlainText).contentLength(FILE_NOT_FOUND.size()).add(connectionHeader(conn));
+        (void)response.send(clientSocket, FILE_NOT_FOUND);
+        return conn.keepAlive;
+    }
+
+    const std::vector<std::string> names = archiveEntryNames(files);
+    const bool deflate = queryParam(ctx.query, "method") == "deflate";
+    uint64_t totalSize = 0;
+    for (const auto& file : files) totalSize += file.size;
+
+    HTTPResponseWriter headers(HttpStatus::Ok);
+    headers.add(ARCHIVE_HEADERS);
+    if (deflate) {
+        conn.keepAlive = false;
+    } else {
+        std::vector<ZipWriter::EntrySize> sizes;
+        sizes.reserve(files.size());
+        for (size_t i = 0; i < files.size(); ++i) sizes.push_back({names[i].size(), files[i].size});
+        headers.contentLength(ZipWriter::storedSize(sizes));
     }
-    // --- End upload announcement handling ---
-
-    // Handle heartbeat endpoint
-    if (path == "/api/heartbeat") {
-
-        if (server_) {
-            const std::string heartbeatResponse = server_->handleHeartbeat(clientIP);
-            std::string response = "HTTP/1.1 200 OK\r\n";
-            response += "Content-Type: application/json\r\n";
-            response += "Content-Length: " + std::to_string(heartbeatResponse.length()) + "\r\n";
-            response += "Access-Control-Allow-Origin: *\r\n";
-            response += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
-            response += "Access-Control-Allow-Headers: Content-Type, Cache-Control, Pragma, Expires\r\n";
-            response += "Cache-Control: no-cache, no-store, must-revalidate\r\n";
-            response += "Pragma: no-cache\r\n";
-            response += "Expires: 0\r\n";
-            response += "Connection: close\r\n";
-            response += "\r\n";
-            response += heartbeatResponse;
-            (void)NetworkUtils::sendData(clientSocket, response);
+    headers.add(connectionHeader(conn));
+
+    // The archive is only of use complete, so its files stay queued until every byte is out
+    const auto endDownloads = [&](const bool complete) {
+        for (const auto& file : files) {
+            int deliveredPct = 0;
+            (void)server_->endPendingFileDownload(file.id, 0, complete ? file.size : 0, !complete, deliveredPct);
+            if (!complete) server_->reportOutgoingProgress(file.path, deliveredPct);
         }
-        return;
+    };
+
+    if (!headers.send(clientSocket) || headOnly) {
+        if (!headOnly) endDownloads(false);
+        return headOnly && conn.keepAlive;
     }
 
-    // Handle auth config endpoint
-    if (path == "/api/auth-config") {
-        const std::string config = getAuthConfig();
-        std::string response = "HTTP/1.1 200 OK\r\n";
-        response += "Content-Type: application/json\r\n";
-        response += "Content-Length: " + std::to_string(config.length()) + "\r\n";
-        response += "Access-Control-Allow-Origin: *\r\n";
-        response += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
-        response += "Access-Control-Allow-Headers: Content-Type, Cache-Control, Pragma, Expires\r\n";
-        response += "Cache-Control: no-cache, no-store, must-revalidate\r\n";
-        response += "Pragma: no-cache\r\n";
-        response += "Expires: 0\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += config;
-        (void)NetworkUtils::sendData(clientSocket, response);
-        return;
+    Logger::getInstance().info("Starting archive download: " + std::to_string(files.size()) + " files (" +
+                               std::to_string(totalSize) + " bytes" + (deflate ? ", deflated)" : ")"));
+    setSocketTimeout(clientSocket, 300);
+
+    // Entries are gathered into one buffer, so a batch of small files goes out in a few large writes
+    constexpr size_t FLUSH_SIZE = 256 * 1024;
+    ZipWriter zip;
+    std::string out;
+    out.reserve(2 * FLUSH_SIZE);
+    std::vector<uint8_t> buffer(FLUSH_SIZE);
+    bool ok = true;
+    for (size_t i = 0; ok && i < files.size(); ++i) {
+        const PendingFile& file = files[i];
+        zip.beginEntry(names[i], file.modified, file.size, deflate ? ZipWriter::Method::Deflate : ZipWriter::Method::Store, out);
+        server_->reportOutgoingProgress(file.path, 0);
+
+        PositionalFile input;
+        ok = input.open(std::filesystem::path(file.path), PositionalFile::Mode::Read);
+        uint64_t done = 0;
+        int lastReportedPct = 0;
+        while (ok && done < file.size) {
+            const auto want = static_cast<size_t>(std::min<uint64_t>(buffer.size(), file.size - done));
+            const int64_t n = input.readAt(done, buffer.data(), want);
+            // A file that shrank since it was measured can't fill its announced share of the archive
+            if (n <= 0) {
+                Logger::getInstance().error("Failed to read " + file.path + " for archive download");
+                ok = false;
+                break;
+            }
+            zip.write(buffer.data(), static_cast<size_t>(n), out);
+            done += static_cast<uint64_t>(n);
+            if (out.size() >= FLUSH_SIZE) {
+                ok = NetworkUtils::sendAll(clientSocket, out.data(), out.size());
+                out.clear();
+            }
+            const int pct = static_cast<int>(done * 100 / file.size);
+            if (pct != lastReportedPct) {
+                server_->reportOutgoingProgress(file.path, pct);
+                lastReportedPct = pct;
+            }
+        }
+        if (ok) (void)zip.endEntry(out);
+    }
+    if (ok) {
+        zip.finish(out);
+        ok = NetworkUtils::sendAll(clientSocket, out.data(), out.size());
     }
 
-    // Handle connected devices endpoint
-    if (path == "/api/connected-devices") {
-        const std::string devices = getConnectedDevicesJson();
-        std::string response = "HTTP/1.1 200 OK\r\n";
-        response += "Content-Type: application/json\r\n";
-        response += "Content-Length: " + std::to_string(devices.length()) + "\r\n";
-        response += "Access-Control-Allow-Origin: *\r\n";
-        response += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
-        response += "Access-Control-Allow-Headers: Content-Type, Cache-Control, Pragma, Expires\r\n";
-        response += "Cache-Control: no-cache, no-store, must-revalidate\r\n";
-        response += "Pragma: no-cache\r\n";
-        response += "Expires: 0\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += devices;
-        (void)NetworkUtils::sendData(clientSocket, response);
-        return;
+    endDownloads(ok);
+    if (ok) {
+        Logger::getInstance().info("Archive downloaded successfully: " + std::to_string(files.size()) + " files, " +
+                                   std::to_string(zip.bytesOut()) + " bytes");
+    } else {
+        Logger::getInstance().warning("Archive download incomplete after " + std::to_string(zip.bytesOut()) +
+                                      " bytes; its files stay queued");
     }
 
-    // Handle pending files endpoint (returns list of files queued for download)
-    if (path == "/api/pending-files") {
-        const std::string pendingFiles = getPendingFilesJson();
-        std::string response = "HTTP/1.1 200 OK\r\n";
-        response += "Content-Type: application/json\r\n";
-        response += "Content-Length: " + std::to_string(pendingFiles.length()) + "\r\n";
-        response += "Access-Control-Allow-Origin: *\r\n";
-        response += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
-        response += "Access-Control-Allow-Headers: Content-Type, Cache-Control, Pragma, Expires\r\n";
-        response += "Cache-Control: no-cache, no-store, must-revalidate\r\n";
-        response += "Pragma: no-cache\r\n";
-        response += "Expires: 0\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += pendingFiles;
-        (void)NetworkUtils::sendData(clientSocket, response);
-        return;
+    setSocketTimeout(clientSocket);
+    return ok && conn.keepAlive;
+}
+
+// Folder download: the tree as a tar stream, sent while a DirectoryWalker is still listing it,
+// so the first bytes go out as soon as the top directory has been read. The length is only
+// known at the end, so the body ends when the connection closes.
+bool HTTPServer::handleFolderDownload(HTTPConnection& conn, const PendingFile& folder, const bool headOnly) const {
+    const SocketType clientSocket = conn.socket;
+    std::error_code ec;
+    const bool exists = std::filesystem::is_directory(folder.path, ec);
+    // Counted as in flight from here until the stream ends
+    if (!exists || (!headOnly && !server_->beginPendingFileDownload(folder.id))) {
+        if (!exists) {
+            Logger::getInstance().error("Folder to download is gone: " + folder.path);
+            server_->removePendingFile(folder.id);
+        }
+        HTTPResponseWriter response(HttpStatus::NotFound);
+        response.add(HttpHeaders::PlainText).contentLength(FILE_NOT_FOUND.size()).add(connectionHeader(conn));
+        (void)response.send(clientSocket, FILE_NOT_FOUND);
+        return conn.keepAlive;
+    }
+
+    conn.keepAlive = false;
+    HTTPResponseWriter headers(HttpStatus::Ok);
+    headers.header("Content-Disposition", attachmentDisposition(folder.name + ".tar")).add(FOLDER_HEADERS)
+           .add(connectionHeader(conn));
+
+    int deliveredPct = 0;
+    if (!headers.send(clientSocket) || headOnly) {
+        if (!headOnly) (void)server_->endPendingFileDownload(folder.id, 0, 0, true, deliveredPct);
+        return false;
     }
 
-    // Handle file download endpoint (streams file to client)
-    if (path.find("/api/download/") == 0) {
-        // Extract the file index from URL
-        // URL format can be /api/download/{index} or /api/download/{index}/{filename}
-        std::string remainder = path.substr(14); // "/api/download/" is 14 chars
-
-        // If there's a slash, extract just the index part
-        const size_t slashPos = remainder.find('/');
-        std::string indexStr = (slashPos != std::string::npos) ? remainder.substr(0, slashPos) : remainder;
-
-        try {
-            const size_t fileIndex = std::stoul(indexStr);
-            if (server_) {
-                const auto pendingFiles = server_->getPendingFiles();
-                if (fileIndex < pendingFiles.size()) {
-                    const std::string& filePath = pendingFiles[fileIndex];
-                    handleFileDownload(clientSocket, filePath);
-                    return;
+    Logger::getInstance().info("Starting folder download: " + folder.name + (folder.scanning ? " (still being scanned, " : " (") +
+                               std::to_string(folder.fileCount) + " files, " + std::to_string(folder.size) + " bytes)");
+    setSocketTimeout(clientSocket, 300);
+    server_->reportOutgoingProgress(folder.path, 0);
+
+    constexpr size_t FLUSH_SIZE = 256 * 1024;
+    DirectoryWalker walker(std::filesystem::path(folder.path), true);
+    TarWriter tar;
+    std::string out;
+    out.reserve(2 * FLUSH_SIZE);
+    std::vector<uint8_t> buffer(FLUSH_SIZE);
+    uint64_t filesSent = 0;
+    uint64_t bytesRead = 0;
+    int lastReportedPct = 0;
+    bool ok = true;
+
+    // Progress against the larger of the queue's scan and this walk's own count; both only grow
+    const auto reportProgress = [&] {
+        const uint64_t total = std::max(walker.bytesFound(), folder.size);
+        const int pct = total == 0 ? 0 : static_cast<int>(std::min<uint64_t>(bytesRead * 100 / total, 99));
+        if (pct != lastReportedPct) {
+            server_->reportOutgoingProgress(folder.path, pct);
+            lastReportedPct = pct;
+        }
+    };
+    const auto flush = [&] {
+        ok = NetworkUtils::sendAll(clientSocket, out.data(), out.size());
+        out.clear();
+    };
+
+    DirectoryWalker::Entry entry;
+    while (ok) {
+        // Whatever is gathered goes out before waiting on a slow listing
+        if (!out.empty() && !walker.available()) flush();
+        if (!ok || !walker.next(entry)) break;
+
+        PositionalFile input;
+        if (!entry.directory && !input.open(entry.path, PositionalFile::Mode::Read)) {
+            Logger::getInstance().warning("Leaving unreadable file out of folder download: " + entry.name);
+            continue;
+        }
+        tar.beginEntry(entry.name, entry.modified, entry.size, entry.directory, out);
+        if (entry.directory) continue;
+
+        uint64_t done = 0;
+        bool shrank = false;
+        while (ok && done < entry.size) {
+            const auto want = static_cast<size_t>(std::min<uint64_t>(buffer.size(), entry.size - done));
+            int64_t n = shrank ? 0 : input.readAt(done, buffer.data(), want);
+            if (n < 0) {
+                // Padding would hand the client a well-formed archive with a corrupt member; without
+                // the end-of-archive blocks it sees the download as truncated instead
+                Logger::getInstance().error("Failed to read " + entry.name + " during folder download; aborting it");
+                ok = false;
+                break;
+            }
+            if (n == 0) {
+                // End of a file that got shorter: the header has promised entry.size bytes, so
+                // make up the rest, as tar does
+                if (!shrank) {
+                    Logger::getInstance().warning("File shrank during folder download, padding with zeros: " + entry.name);
+                    std::fill(buffer.begin(), buffer.end(), 0);
+                    shrank = true;
                 }
+                n = static_cast<int64_t>(want);
             }
-        } catch (...) {
-            // Invalid index
-        }
-
-        // File not found
-        std::string response = "HTTP/1.1 404 Not Found\r\n";
-        response += "Content-Type: text/plain\r\n";
-        response += "Content-Length: 14\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += "File not found";
-        (void)NetworkUtils::sendData(clientSocket, response);
-        return;
+            tar.write(buffer.data(), static_cast<size_t>(n), out);
+            done += static_cast<uint64_t>(n);
+            bytesRead += static_cast<uint64_t>(n);
+            if (out.size() >= FLUSH_SIZE) flush();
+            reportProgress();
+        }
+        if (!ok) break;
+        tar.endEntry(out);
+        ++filesSent;
     }
-
-    // Default to index.html
-    if (path == "/") {
-        path = "/index.html";
+    if (ok) {
+        tar.finish(out);
+        flush();
     }
-    
-    // Load file
-    const std::string filePath = webRoot_ + path;
-    const std::string content = loadFile(filePath);
-    
-    std::string response;
-    if (!content.empty()) {
-        response = "HTTP/1.1 200 OK\r\n";
-        response += "Content-Type: " + getContentType(path) + "\r\n";
-        response += "Content-Length: " + std::to_string(content.length()) + "\r\n";
-        response += "Cache-Control: no-cache, no-store, must-revalidate\r\n";
-        response += "Pragma: no-cache\r\n";
-        response += "Expires: 0\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += content;
+    walker.cancel();
+
+    const TransferState state = server_->endPendingFileDownload(folder.id, 0, ok ? tar.bytesOut() : 0, !ok, deliveredPct);
+    server_->reportOutgoingProgress(folder.path, deliveredPct);
+    if (state == TransferState::Done) {
+        Logger::getInstance().info("Folder downloaded successfully: " + folder.name + " (" + std::to_string(filesSent) +
+                                   " files, " + std::to_string(tar.bytesOut()) + " bytes)");
     } else {
-        response = "HTTP/1.1 404 Not Found\r\n";
-        response += "Content-Type: text/html\r\n";
-        response += "Cache-Control: no-cache, no-store, must-revalidate\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += "<html><body><h1>404 Not Found</h1></body></html>";
+        Logger::getInstance().warning("Folder download incomplete after " + std::to_string(tar.bytesOut()) +
+                                      " bytes; the folder stays queued");
     }
-    
-    (void)NetworkUtils::sendData(clientSocket, response);
+
+    setSocketTimeout(clientSocket);
+    return false;
+}
+
+// Web UI: served from the in-memory copy of the web root
+bool HTTPServer::handleStaticFile(HTTPConnection& conn, RequestContext& ctx) const {
+    const SocketType clientSocket = conn.socket;
+    const auto asset = assets_->find(ctx.path == "/" ? std::string("/index.html") : ctx.path);
+
+    if (!asset) {
+        HTTPResponseWriter response(HttpStatus::NotFound);
+        response.add(HttpHeaders::Html).contentLength(HTML_NOT_FOUND.size())
+                .add(policyHeaders({.cors = false})).add(connectionHeader(conn));
+        (void)response.send(clientSocket, HTML_NOT_FOUND);
+        return conn.keepAlive;
+    }
+
+    const bool gzip = !asset->gzipBody.empty() && acceptsEncoding(ctx.head.header("Accept-Encoding"), "gzip");
+    const std::string& etag = gzip ? asset->gzipEtag : asset->etag;
+    const std::string_view policy = policyHeaders(ctx.match.route->options);
+
+    // Browsers revalidate on every load (no-cache); unchanged assets cost a bodiless 304
+    if (etagMatches(ctx.head.header("If-None-Match"), etag)) {
+        HTTPResponseWriter response(HttpStatus::NotModified);
+        response.header("ETag", etag);
+        if (!asset->gzipBody.empty()) response.add(HttpHeaders::VaryEncoding);
+        response.add(policy).add(connectionHeader(conn));
+        if (!response.send(clientSocket)) return false;
+        return conn.keepAlive;
+    }
+
+    // The representation headers were built with the asset; head and body leave in one
+    // gathered write and the body is never copied
+    const std::string_view body = gzip ? std::string_view(asset->gzipBody) : asset->body;
+    HTTPResponseWriter response(HttpStatus::Ok);
+    response.add(gzip ? asset->gzipHeaders : asset->headers).add(policy).add(connectionHeader(conn));
+    if (!response.send(clientSocket, ctx.method == "HEAD" ? std::string_view() : body)) return false;
+    return conn.keepAlive;
+}
+
+// Server-Sent Events: the connection leaves the request/response cycle and is handed to the event stream
+bool HTTPServer::handleEvents(HTTPConnection& conn, RequestContext& ctx) const {
+    HTTPResponseWriter response(HttpStatus::Ok);
+    response.add(EVENT_STREAM_HEADERS).add(policyHeaders(ctx.match.route->options)).add(HttpHeaders::Close);
+    if (!response.send(conn.socket)) return false;
+
+    if (!events_->subscribe(conn.socket, conn.clientIP)) return false;
+    conn.socket = INVALID_SOCKET; // Owned by the event stream now
+    return false;
+}
+
+// WebSocket upgrade (RFC 6455): after the 101 the connection belongs to the event stream
+bool HTTPServer::handleWebSocket(HTTPConnection& conn, RequestContext& ctx) const {
+    const RouteOptions& options = ctx.match.route->options;
+    const std::string_view key = ctx.head.header("Sec-WebSocket-Key");
+    if (!ctx.head.headerHasToken("Upgrade", "websocket") || !ctx.head.headerHasToken("Connection", "upgrade") ||
+        !WebSocket::isValidKey(key)) {
+        return sendJson(conn, options, HttpStatus::BadRequest, R"({"status":"error"})");
+    }
+    if (ctx.head.header("Sec-WebSocket-Version") != "13") {
+        HTTPResponseWriter response(HttpStatus::BadRequest);
+        response.header("Sec-WebSocket-Version", "13").contentLength(0).add(connectionHeader(conn));
+        return response.send(conn.socket) && conn.keepAlive;
+    }
+
+    HTTPResponseWriter response(HttpStatus::SwitchingProtocols);
+    response.add("Upgrade: websocket\r\nConnection: Upgrade\r\n")
+            .header("Sec-WebSocket-Accept", WebSocket::acceptKey(key));
+    if (!response.send(conn.socket)) return false;
+
+    if (!events_->subscribe(conn.socket, conn.clientIP, EventStream::Transport::WebSocket)) return false;
+    conn.socket = INVALID_SOCKET; // Owned by the event stream now
+    return false;
+}
+
+// Control messages from WebSocket clients: {"type":..,"id":..,...}; the reply echoes the id
+std::string HTTPServer::handleControlMessage(const std::string& clientIP, const std::string_view message) const {
+    const std::string type = jsonStringField(message, "type");
+    std::string data;
+    if (type == "announce") {
+        std::string_view status;
+        data = announceUpload(jsonStringField(message, "filename"), jsonNumberField(message, "size"), clientIP, status);
+    }
+    if (data.empty()) data = R"({"status":"error"})";
+    return "{\"event\":\"reply\",\"id\":" + std::to_string(jsonNumberField(message, "id")) + ",\"data\":" + data + "}";
+}
+
+void HTTPServer::notifyPendingFilesChanged() {
+    if (events_->hasSubscribers()) events_->publish("queue", pendingFilesSnapshot()->json);
+}
+
+void HTTPServer::notifyDevicesChanged() {
+    if (events_->hasSubscribers()) events_->publish("devices", devicesSnapshot()->json);
+}
+
+void HTTPServer::notifyProgress(const std::string_view direction, const std::string_view name, const int percent) {
+    if (!events_->hasSubscribers()) return;
+    std::string json = "{\"direction\":\"";
+    json += direction;
+    json += "\",\"name\":\"" + jsonEscape(name) + "\",\"percent\":" + std::to_string(percent) + "}";
+    // Only the latest percentage of each transfer matters
+    std::string key(direction);
+    key += '/';
+    key += name;
+    events_->publish("progress", json, key);
 }
 
 // Set socket timeout for read/write operations
@@ -509,97 +1605,11 @@ void HTTPServer::setSocketTimeout(const SocketType socket, const int seconds) {
 #endif
 }
 
-// Helper function - called from handleRequest()
-std::string HTTPServer::getContentType(const std::string& path) {
-    // Convert to lowercase for comparison
-    std::string lowerPath = path;
-    std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), ::tolower);
-
-    // Web files
-    if (lowerPath.find(".html") != std::string::npos) return "text/html";
-    if (lowerPath.find(".css") != std::string::npos) return "text/css";
-    if (lowerPath.find(".js") != std::string::npos) return "application/javascript";
-    if (lowerPath.find(".json") != std::string::npos) return "application/json";
-
-    // Images
-    if (lowerPath.find(".svg") != std::string::npos) return "image/svg+xml";
-    if (lowerPath.find(".png") != std::string::npos) return "image/png";
-    if (lowerPath.find(".jpg") != std::string::npos || lowerPath.find(".jpeg") != std::string::npos) return "image/jpeg";
-    if (lowerPath.find(".gif") != std::string::npos) return "image/gif";
-    if (lowerPath.find(".ico") != std::string::npos) return "image/x-icon";
-    if (lowerPath.find(".webp") != std::string::npos) return "image/webp";
-    if (lowerPath.find(".bmp") != std::string::npos) return "image/bmp";
-
-    // Video
-    if (lowerPath.find(".mp4") != std::string::npos) return "video/mp4";
-    if (lowerPath.find(".mov") != std::string::npos) return "video/quicktime";
-    if (lowerPath.find(".avi") != std::string::npos) return "video/x-msvideo";
-    if (lowerPath.find(".mkv") != std::string::npos) return "video/x-matroska";
-    if (lowerPath.find(".webm") != std::string::npos) return "video/webm";
-    if (lowerPath.find(".wmv") != std::string::npos) return "video/x-ms-wmv";
-    if (lowerPath.find(".flv") != std::string::npos) return "video/x-flv";
-    if (lowerPath.find(".m4v") != std::string::npos) return "video/x-m4v";
-
-    // Audio
-    if (lowerPath.find(".mp3") != std::string::npos) return "audio/mpeg";
-    if (lowerPath.find(".wav") != std::string::npos) return "audio/wav";
-    if (lowerPath.find(".ogg") != std::string::npos) return "audio/ogg";
-    if (lowerPath.find(".flac") != std::string::npos) return "audio/flac";
-    if (lowerPath.find(".m4a") != std::string::npos) return "audio/mp4";
-    if (lowerPath.find(".aac") != std::string::npos) return "audio/aac";
-    if (lowerPath.find(".wma") != std::string::npos) return "audio/x-ms-wma";
-
-    // Documents
-    if (lowerPath.find(".pdf") != std::string::npos) return "application/pdf";
-    if (lowerPath.find(".doc") != std::string::npos) return "application/msword";
-    if (lowerPath.find(".docx") != std::string::npos) return "application/vnd.openxmlformats-officedocument.wordprocessingml.document";
-    if (lowerPath.find(".xls") != std::string::npos) return "application/vnd.ms-excel";
-    if (lowerPath.find(".xlsx") != std::string::npos) return "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet";
-    if (lowerPath.find(".ppt") != std::string::npos) return "application/vnd.ms-powerpoint";
-    if (lowerPath.find(".pptx") != std::string::npos) return "application/vnd.openxmlformats-officedocument.presentationml.presentation";
-
-    // Archives
-    if (lowerPath.find(".zip") != std::string::npos) return "application/zip";
-    if (lowerPath.find(".rar") != std::string::npos) return "application/x-rar-compressed";
-    if (lowerPath.find(".7z") != std::string::npos) return "application/x-7z-compressed";
-    if (lowerPath.find(".tar") != std::string::npos) return "application/x-tar";
-    if (lowerPath.find(".gz") != std::string::npos) return "application/gzip";
-
-    // Default to octet-stream for unknown types (forces download)
-    return "application/octet-stream";
-}
-
 // Helper function - called from handleRequest() to load web files
-std::string HTTPServer::loadFile(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) {
-        Logger::getInstance().debug("Failed to open file: " + path);
-        return "";
-    }
-
-    // Check file size before reading
-    file.seekg(0, std::ios::end);
-    const std::streamsize fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    // Limit file size to 10MB to prevent memory issues
-    if (fileSize > 10 * 1024 * 1024) {
-        Logger::getInstance().error("File too large: " + path + " (" + std::to_string(fileSize) + " bytes)");
-        return "";
-    }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
-
-
 std::string HTTPServer::getAuthConfig() const {
+    // Only whether a login is needed; the password is checked by /api/login
     std::string json = "{";
     json += "\"authEnabled\":" + std::string(useAuth_ ? "true" : "false");
-    if (useAuth_) {
-        json += R"(,"password":")" + password_ + "\"";
-    }
     json += "}";
 
     Logger::getInstance().debug("Auth config: " + json);
@@ -607,13 +1617,67 @@ std::string HTTPServer::getAuthConfig() const {
     return json;
 }
 
+HTTPServer::SnapshotPtr HTTPServer::pendingFilesSnapshot() const {
+    return currentSnapshot(pendingFilesSnapshot_, server_ ? server_->pendingFilesGeneration() : 0, 'q',
+                           &HTTPServer::getPendingFilesJson);
+}
+
+HTTPServer::SnapshotPtr HTTPServer::devicesSnapshot() const {
+    return currentSnapshot(devicesSnapshot_, server_ ? server_->connectedDevicesGeneration() : 0, 'd',
+                           &HTTPServer::getConnectedDevicesJson);
+}
+
+// Returns the cached snapshot if it is of the current generation, otherwise builds and publishes a new one
+HTTPServer::SnapshotPtr HTTPServer::currentSnapshot(std::atomic<SnapshotPtr>& cache, const uint64_t generation,
+                                                   const char kind, std::string (HTTPServer::*build)() const) const {
+    if (SnapshotPtr snapshot = cache.load(std::memory_order_acquire); snapshot && snapshot->generation == generation) {
+        return snapshot;
+    }
+    // The generation was read before the data, so a change racing with the build leaves a snapshot
+    // that is newer than its tag: the next reader sees a mismatch and rebuilds, never serves stale data
+    std::string etag = "\"" + etagPrefix_ + kind;
+    etag += std::to_string(generation) + "\"";
+    JsonSnapshot built{generation, (this->*build)(), std::move(etag), {}, {}};
+    // Long listings shrink several times over; the compressed copy is shared by every poll of the generation
+    if (built.json.size() >= MIN_COMPRESS_SIZE) {
+        built.gzipJson = DeflateEncoder::compress(reinterpret_cast<const uint8_t*>(built.json.data()), built.json.size(),
+                                                  DeflateEncoder::Format::Gzip, SNAPSHOT_GZIP_LEVEL);
+        built.gzipEtag = built.etag;
+        built.gzipEtag.insert(built.gzipEtag.size() - 1, "-gz");
+    }
+    auto snapshot = std::make_shared<const JsonSnapshot>(std::move(built));
+    cache.store(snapshot, std::memory_order_release);
+    return snapshot;
+}
+
+// Polled JSON: an unchanged collection costs a 304 without serializing anything
+bool HTTPServer::sendSnapshot(HTTPConnection& conn, const RequestContext& ctx, const JsonSnapshot& snapshot) const {
+    const std::string_view policy = policyHeaders(ctx.match.route->options);
+    const bool negotiable = !snapshot.gzipJson.empty();
+    const bool gzip = negotiable && acceptsEncoding(ctx.head.header("Accept-Encoding"), "gzip");
+    const std::string& etag = gzip ? snapshot.gzipEtag : snapshot.etag;
+    const std::string_view vary = negotiable ? HttpHeaders::VaryEncoding : std::string_view{};
+    if (etagMatches(ctx.head.header("If-None-Match"), etag)) {
+        HTTPResponseWriter response(HttpStatus::NotModified);
+        response.header("ETag", etag).add(vary).add(policy).add(connectionHeader(conn));
+        (void)response.send(conn.socket);
+        return conn.keepAlive;
+    }
+    const std::string_view body = gzip ? std::string_view(snapshot.gzipJson) : std::string_view(snapshot.json);
+    HTTPResponseWriter response(HttpStatus::Ok);
+    response.add(HttpHeaders::Json).add(gzip ? HttpHeaders::GzipEncoding : std::string_view{}).add(vary)
+            .header("ETag", etag).contentLength(body.size()).add(policy).add(connectionHeader(conn));
+    (void)response.send(conn.socket, body);
+    return conn.keepAlive;
+}
+
 std::string HTTPServer::getConnectedDevicesJson() const {
     std::string json = "{\"devices\":[";
 
     if (server_) {
         const auto devices = server_->getConnectedDevices();
         for (size_t i = 0; i < devices.size(); ++i) {
-            json += "\"" + devices[i] + "\"";
+            json += "\"" + jsonEscape(devices[i]) + "\"";
             if (i < devices.size() - 1) {
                 json += ",";
             }
@@ -628,23 +1692,22 @@ std::string HTTPServer::getPendingFilesJson() const {
     std::string json = "{\"files\":[";
 
     if (server_) {
+        // Metadata was captured when each file was queued; nothing here touches the disk
         const auto files = server_->getPendingFiles();
         for (size_t i = 0; i < files.size(); ++i) {
-            // Get just the filename for display
-            std::filesystem::path p(files[i]);
-            std::string filename = p.filename().string();
-
-            // Get file size
-            uint64_t fileSize = 0;
-            try {
-                if (std::filesystem::exists(p)) {
-                    fileSize = std::filesystem::file_size(p);
-                }
-            } catch (...) {}
-
-            json += "{\"index\":" + std::to_string(i) + ",";
-            json += "\"name\":\"" + filename + "\",";
-            json += "\"size\":" + std::to_string(fileSize) + "}";
+            json += "{\"id\":" + std::to_string(files[i].id) + ",";
+            json += "\"name\":\"" + jsonEscape(files[i].name) + "\",";
+            json += "\"type\":\"";
+            json += files[i].contentType;
+            json += "\",\"size\":" + std::to_string(files[i].size) + ",";
+            json += "\"state\":\"";
+            json += toString(files[i].state);
+            json += "\"";
+            if (files[i].folder) {
+                json += ",\"folder\":true,\"fileCount\":" + std::to_string(files[i].fileCount);
+                json += files[i].scanning ? ",\"scanning\":true" : ",\"scanning\":false";
+            }
+            json += "}";
 
             if (i < files.size() - 1) {
                 json += ",";
@@ -656,128 +1719,220 @@ std::string HTTPServer::getPendingFilesJson() const {
     return json;
 }
 
-void HTTPServer::handleFileDownload(const SocketType clientSocket, const std::string& filePath) const {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file.is_open()) {
+bool HTTPServer::handleUploadChunk(HTTPConnection& conn, const std::string& sessionId, const uint64_t offset,
+                                   const uint64_t contentLength, std::vector<uint8_t>& raw, const size_t bodyStart) const {
+    auto reply = [&](const std::string_view status, const std::string_view json) {
+        (void)sendJson(conn, RouteOptions{}, status, json);
+    };
+
+    std::unique_ptr<UploadSink> sink = server_ ? server_->openUploadChunk(sessionId, offset, contentLength) : nullptr;
+    if (!sink) {
+        // The body is not read, so the connection can't carry another request
+        conn.keepAlive = false;
+        const std::string status = server_ ? server_->getUploadSessionJson(sessionId) : "";
+        if (status.empty()) reply(HttpStatus::NotFound, R"({"status":"error"})");
+        else reply(HttpStatus::RangeNotSatisfiable, status);
+        return false;
+    }
+    return receiveUploadBody(conn, sessionId, std::move(sink), contentLength, raw, bodyStart);
+}
+
+// Streams a request body into an upload session's sink and replies with the session status
+bool HTTPServer::receiveUploadBody(HTTPConnection& conn, const std::string& sessionId, std::unique_ptr<UploadSink> sink,
+                                   const uint64_t contentLength, std::vector<uint8_t>& raw, const size_t bodyStart) const {
+    const SocketType clientSocket = conn.socket;
+
+    auto reply = [&](const std::string_view status, const std::string_view json) {
+        (void)sendJson(conn, RouteOptions{}, status, json);
+    };
+
+    // Body bytes that arrived with the head, then the rest straight from the socket
+    const size_t early = std::min<size_t>(raw.size() - bodyStart, contentLength);
+    bool ok = sink->write(raw.data() + bodyStart, early);
+    uint64_t received = early;
+    if (raw.size() > bodyStart + contentLength) {
+        conn.buffer.assign(raw.begin() + static_cast<std::ptrdiff_t>(bodyStart + contentLength), raw.end());
+    }
+    raw.clear();
+    raw.shrink_to_fit();
+
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+    std::vector<uint8_t> chunk(CHUNK_SIZE);
+    while (ok && received < contentLength) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(chunk.size(), contentLength - received));
+        const int n = NetworkUtils::receiveData(clientSocket, reinterpret_cast<char*>(chunk.data()), want);
+        if (n <= 0) {
+            Logger::getInstance().warning("Upload chunk for session " + sessionId + " lost after " +
+                                          std::to_string(received) + "/" + std::to_string(contentLength) + " bytes from " + conn.clientIP);
+            return false;
+        }
+        received += static_cast<uint64_t>(n);
+        ok = sink->write(chunk.data(), static_cast<size_t>(n));
+    }
+    if (received < contentLength) conn.keepAlive = false;
+
+    ok = ok && sink->finish();
+    sink.reset();
+    const std::string status = server_->getUploadSessionJson(sessionId);
+    if (ok) reply(HttpStatus::Ok, status);
+    else reply(HttpStatus::InternalServerError, status.empty() ? R"({"status":"error"})" : std::string_view(status));
+    return conn.keepAlive;
+}
+
+bool HTTPServer::handleFileDownload(HTTPConnection& conn, const uint64_t transferId, const std::string& filePath, const bool headOnly,
+                                    const std::string_view range, const std::string_view ifRange,
+                                    const std::string_view acceptEncoding) const {
+    const SocketType clientSocket = conn.socket;
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(filePath, ec);
+    const auto modified = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(filePath, ec);
+    if (ec) {
         Logger::getInstance().error("Failed to open file for download: " + filePath);
-        std::string response = "HTTP/1.1 404 Not Found\r\n";
-        response += "Content-Type: text/plain\r\n";
-        response += "Content-Length: 14\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += "File not found";
-        (void)NetworkUtils::sendData(clientSocket, response);
+        HTTPResponseWriter response(HttpStatus::NotFound);
+        response.add(HttpHeaders::PlainText).contentLength(FILE_NOT_FOUND.size()).add(connectionHeader(conn));
+        (void)response.send(clientSocket, FILE_NOT_FOUND);
         // Remove from queue since file doesn't exist
-        if (server_) server_->removePendingFile(filePath);
-        return;
+        if (server_) server_->removePendingFile(transferId);
+        return conn.keepAlive;
     }
+    // The download had to stat the file anyway; keep the queue's record in step with it
+    if (server_) server_->updatePendingFile(transferId, fileSize, modified);
 
-    // Get file size
-    file.seekg(0, std::ios::end);
-    const auto fileSize = static_cast<uint64_t>(file.tellg());
-    file.seekg(0, std::ios::beg);
-
-    // Get filename and extension
     std::filesystem::path p(filePath);
     std::string filename = p.filename().string();
-    std::string extension = p.extension().string();
-
-    // URL-encode the filename for Content-Disposition header
-    auto urlEncode = [](const std::string& str) -> std::string {
-        std::ostringstream encoded;
-        for (unsigned char c : str) {
-            if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
-                encoded << c;
-            } else {
-                encoded << '%' << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
-            }
-        }
-        return encoded.str();
-    };
 
-    std::string encodedFilename = urlEncode(filename);
+    // Validators let a client resume with If-Range only if the file is unchanged
+    const auto modifiedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(modified.time_since_epoch()).count();
+    std::ostringstream etagStream;
+    etagStream << '"' << std::hex << fileSize << '-' << static_cast<uint64_t>(modifiedNs) << '"';
+    const std::string etag = etagStream.str();
+    std::string gzipEtag = etag;
+    gzipEtag.insert(gzipEtag.size() - 1, "-gz");
+    const std::string lastModified = NetworkUtils::formatHttpDate(modified);
+
+    // Ranges address the identity representation. A client holding part of the gzip one
+    // (If-Range with gzipEtag) counted compressed bytes, so it gets the whole file again
+    uint64_t first = 0;
+    uint64_t last = fileSize == 0 ? 0 : fileSize - 1;
+    RangeResult rangeResult = RangeResult::None;
+    if (!range.empty() && (ifRange.empty() || ifRange == etag || ifRange == lastModified)) {
+        rangeResult = parseByteRange(range, fileSize, first, last);
+    }
+
+    if (rangeResult == RangeResult::Unsatisfiable) {
+        HTTPResponseWriter response(HttpStatus::RangeNotSatisfiable);
+        response.header("Content-Range", "bytes */" + std::to_string(fileSize)).contentLength(0)
+                .add(HttpHeaders::AcceptRanges).header("ETag", etag).add(connectionHeader(conn));
+        (void)response.send(clientSocket);
+        return conn.keepAlive;
+    }
+
+    const bool partial = rangeResult == RangeResult::Satisfiable;
+    const uint64_t length = fileSize == 0 ? 0 : last - first + 1;
+
+    // Whole files that aren't compressed already go out gzip-compressed to clients that take it:
+    // the type rules out compressed media, a look at the first block catches the rest. HEAD
+    // negotiates the same way, so its headers are those GET would send.
+    const std::string_view contentType = MimeTypes::fromPath(filename);
+    const bool negotiable = fileSize >= MIN_COMPRESS_SIZE && !MimeTypes::isCompressed(contentType);
+    PositionalFile input;
+    std::vector<uint8_t> buffer;
+    size_t buffered = 0;
+    bool gzip = false;
+    if (negotiable && !partial && acceptsEncoding(acceptEncoding, "gzip") &&
+        input.open(std::filesystem::path(filePath), PositionalFile::Mode::Read)) {
+        buffer.resize(COMPRESS_BLOCK_SIZE);
+        const int64_t n = input.readAt(0, buffer.data(), static_cast<size_t>(std::min<uint64_t>(buffer.size(), fileSize)));
+        buffered = n > 0 ? static_cast<size_t>(n) : 0;
+        gzip = buffered > 0 && DeflateEncoder::looksCompressible(buffer.data(), buffered);
+    }
 
-    // Determine content type based on extension
-    std::string contentType = getContentType(extension);
-    if (contentType == "text/plain") {
-        // Default to octet-stream for unknown types to force download
-        contentType = "application/octet-stream";
+    if (!headOnly) {
+        Logger::getInstance().info("Starting download: " + filename + " (" +
+            (partial ? "bytes " + std::to_string(first) + "-" + std::to_string(last) + " of " : "") +
+            std::to_string(fileSize) + (gzip ? " bytes, gzip)" : " bytes)"));
     }
 
-    Logger::getInstance().info("Starting download: " + filename + " (" + std::to_string(fileSize) + " bytes)");
+    // Counted as in flight from here until its range is delivered or the client is gone
+    if (!headOnly && server_ && !server_->beginPendingFileDownload(transferId)) {
+        // Completed by a concurrent download since the lookup
+        HTTPResponseWriter response(HttpStatus::NotFound);
+        response.add(HttpHeaders::PlainText).contentLength(FILE_NOT_FOUND.size()).add(connectionHeader(conn));
+        (void)response.send(clientSocket, FILE_NOT_FOUND);
+        return conn.keepAlive;
+    }
 
     // Set longer timeout for file transfer (5 minutes for large files)
     setSocketTimeout(clientSocket, 300);
 
     // Send HTTP headers with Content-Disposition for download
-    // Use both filename and filename* for maximum browser compatibility
-    std::string headers = "HTTP/1.1 200 OK\r\n";
-    headers += "Content-Type: " + contentType + "\r\n";
-    headers += "Content-Length: " + std::to_string(fileSize) + "\r\n";
-    headers += "Content-Disposition: attachment; filename=\"" + filename + "\"; filename*=UTF-8''" + encodedFilename + "\r\n";
-    headers += "Access-Control-Allow-Origin: *\r\n";
-    headers += "Cache-Control: no-cache\r\n";
-    headers += "Connection: close\r\n";
-    headers += "\r\n";
-
-    if (NetworkUtils::sendData(clientSocket, headers) < 0) {
+    HTTPResponseWriter headers(partial ? HttpStatus::PartialContent : HttpStatus::Ok);
+    headers.header("Content-Type", contentType);
+    if (gzip) {
+        headers.add(HttpHeaders::GzipEncoding).add(HttpHeaders::Chunked);
+    } else {
+        headers.contentLength(length);
+    }
+    if (negotiable) headers.add(HttpHeaders::VaryEncoding);
+    if (partial) {
+        headers.header("Content-Range", "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(fileSize));
+    }
+    headers.header("Content-Disposition", attachmentDisposition(filename));
+    headers.header("ETag", gzip ? gzipEtag : etag).header("Last-Modified", lastModified).add(DOWNLOAD_HEADERS)
+           .add(connectionHeader(conn));
+
+    if (!headers.send(clientSocket)) {
         Logger::getInstance().error("Failed to send download headers for: " + filename);
-        if (server_) server_->removePendingFile(filePath);
-        return;
+        if (!headOnly && server_) {
+            int deliveredPct = 0;
+            (void)server_->endPendingFileDownload(transferId, first, first, true, deliveredPct);
+        }
+        return false;
+    }
+
+    if (headOnly) {
+        setSocketTimeout(clientSocket);
+        return conn.keepAlive;
     }
 
-    // Stream file content in chunks
-    constexpr size_t CHUNK_SIZE = 256 * 1024; // 256KB chunks for faster transfer
-    std::vector<char> buffer(CHUNK_SIZE);
-    uint64_t sent = 0;
-    bool transferFailed = false;
+    // Stream file content straight from the page cache to the socket
     int lastReportedPct = -1;
 
     // Report initial progress
-    if (server_) {
+    if (server_ && first == 0) {
         server_->reportOutgoingProgress(filePath, 0);
     }
 
-    while (sent < fileSize && file.good()) {
-        file.read(buffer.data(), CHUNK_SIZE);
-        const auto bytesRead = static_cast<size_t>(file.gcount());
-
-        if (bytesRead > 0) {
-            if (!NetworkUtils::sendAll(clientSocket, buffer.data(), bytesRead)) {
-                Logger::getInstance().error("Failed to send file chunk for: " + filename + " (sent " + std::to_string(sent) + "/" + std::to_string(fileSize) + " bytes)");
-                transferFailed = true;
-                break;
-            }
-            sent += bytesRead;
-
-            // Report progress every 1% or every chunk for small files
-            const int pct = (fileSize == 0) ? 100 : static_cast<int>((sent * 100) / fileSize);
-            if (pct != lastReportedPct && server_) {
-                server_->reportOutgoingProgress(filePath, pct);
-                lastReportedPct = pct;
-            }
-        }
-    }
-
-    file.close();
-
-    // Report final progress (100% if successful)
-    if (server_) {
-        if (!transferFailed && sent >= fileSize) {
-            server_->reportOutgoingProgress(filePath, 100);
+    const auto onProgress = [&](const uint64_t total) {
+        // Report progress every 1% or every chunk for small files
+        const int pct = (fileSize == 0) ? 100 : static_cast<int>(((first + total) * 100) / fileSize);
+        if (pct != lastReportedPct && server_) {
+            server_->reportOutgoingProgress(filePath, pct);
+            lastReportedPct = pct;
         }
+    };
+    const uint64_t sent = gzip ? sendGzipChunked(clientSocket, input, fileSize, buffer, buffered, onProgress)
+                               : NetworkUtils::sendFile(clientSocket, filePath, first, length, onProgress);
+    const bool transferFailed = sent < length;
+    if (transferFailed) {
+        Logger::getInstance().error("Failed to send file data for: " + filename + " (sent " + std::to_string(sent) + "/" + std::to_string(length) + " bytes)");
     }
 
-    // Always remove file from pending queue (whether success or failure)
-    // This prevents infinite retry loops
+    // The file stays queued (and resumable) until every byte has been delivered
     if (server_) {
-        server_->removePendingFile(filePath);
-        if (!transferFailed && sent >= fileSize) {
+        int deliveredPct = 0;
+        const TransferState state = server_->endPendingFileDownload(transferId, first, first + sent, transferFailed, deliveredPct);
+        server_->reportOutgoingProgress(filePath, deliveredPct);
+        if (state == TransferState::Done) {
             Logger::getInstance().info("File downloaded successfully: " + filename);
-        } else {
-            Logger::getInstance().warning("File download incomplete: " + filename + " (sent " + std::to_string(sent) + "/" + std::to_string(fileSize) + " bytes)");
+        } else if (transferFailed) {
+            Logger::getInstance().warning("File download incomplete: " + filename + " (" + std::to_string(deliveredPct) + "% delivered, client may resume)");
         }
     }
+
+    // Back to the short timeout used between requests on a persistent connection
+    setSocketTimeout(clientSocket);
+    return !transferFailed && conn.keepAlive;
 }
 
 
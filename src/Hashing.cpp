@@ -0,0 +1,207 @@
+#include "Hashing.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+namespace blade::Hashing {
+
+namespace {
+
+// Slicing-by-4 tables for the reflected IEEE polynomial
+constexpr std::array<std::array<uint32_t, 256>, 4> makeCrcTables() {
+    std::array<std::array<uint32_t, 256>, 4> tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        tables[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (size_t t = 1; t < 4; ++t) {
+            const uint32_t prev = tables[t - 1][i];
+            tables[t][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr auto CRC_TABLES = makeCrcTables();
+
+constexpr uint32_t SHA256_K[64] = {
+    0x428a2f98u, 0x71374491u, 0xb5c0fbcfu, 0xe9b5dba5u, 0x3956c25bu, 0x59f111f1u, 0x923f82a4u, 0xab1c5ed5u,
+    0xd807aa98u, 0x12835b01u, 0x243185beu, 0x550c7dc3u, 0x72be5d74u, 0x80deb1feu, 0x9bdc06a7u, 0xc19bf174u,
+    0xe49b69c1u, 0xefbe4786u, 0x0fc19dc6u, 0x240ca1ccu, 0x2de92c6fu, 0x4a7484aau, 0x5cb0a9dcu, 0x76f988dau,
+    0x983e5152u, 0xa831c66du, 0xb00327c8u, 0xbf597fc7u, 0xc6e00bf3u, 0xd5a79147u, 0x06ca6351u, 0x14292967u,
+    0x27b70a85u, 0x2e1b2138u, 0x4d2c6dfcu, 0x53380d13u, 0x650a7354u, 0x766a0abbu, 0x81c2c92eu, 0x92722c85u,
+    0xa2bfe8a1u, 0xa81a664bu, 0xc24b8b70u, 0xc76c51a3u, 0xd192e819u, 0xd6990624u, 0xf40e3585u, 0x106aa070u,
+    0x19a4c116u, 0x1e376c08u, 0x2748774cu, 0x34b0bcb5u, 0x391c0cb3u, 0x4ed8aa4au, 0x5b9cca4fu, 0x682e6ff3u,
+    0x748f82eeu, 0x78a5636fu, 0x84c87814u, 0x8cc70208u, 0x90befffau, 0xa4506cebu, 0xbef9a3f7u, 0xc67178f2u,
+};
+
+void sha256Compress(uint32_t (&h)[8], const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = static_cast<uint32_t>(block[4 * i]) << 24 | static_cast<uint32_t>(block[4 * i + 1]) << 16 |
+               static_cast<uint32_t>(block[4 * i + 2]) << 8 | block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; ++i) {
+        const uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; ++i) {
+        const uint32_t t1 = k + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) +
+                            ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        const uint32_t t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) +
+                            ((a & b) ^ (a & c) ^ (b & c));
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+} // namespace
+
+uint64_t fnv1a64(const void* data, const size_t len, uint64_t seed) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        seed ^= p[i];
+        seed *= 1099511628211ull;
+    }
+    return seed;
+}
+
+uint32_t crc32(const void* data, size_t len, uint32_t crc) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    while (len >= 4) {
+        crc ^= static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+        crc = CRC_TABLES[3][crc & 0xFF] ^ CRC_TABLES[2][(crc >> 8) & 0xFF] ^
+              CRC_TABLES[1][(crc >> 16) & 0xFF] ^ CRC_TABLES[0][crc >> 24];
+        p += 4;
+        len -= 4;
+    }
+    while (len-- > 0) crc = CRC_TABLES[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t adler32(const void* data, size_t len, const uint32_t adler) {
+    constexpr uint32_t MOD = 65521;
+    constexpr size_t NMAX = 5552; // Largest n with no 32-bit overflow before reducing
+    const auto* p = static_cast<const uint8_t*>(data);
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (len > 0) {
+        size_t n = len < NMAX ? len : NMAX;
+        len -= n;
+        while (n-- > 0) {
+            a += *p++;
+            b += a;
+        }
+        a %= MOD;
+        b %= MOD;
+    }
+    return (b << 16) | a;
+}
+
+std::array<uint8_t, 20> sha1(const void* data, const size_t len) {
+    uint32_t h[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u};
+    const auto compress = [&h](const uint8_t* block) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = static_cast<uint32_t>(block[4 * i]) << 24 | static_cast<uint32_t>(block[4 * i + 1]) << 16 |
+                   static_cast<uint32_t>(block[4 * i + 2]) << 8 | block[4 * i + 3];
+        }
+        for (int i = 16; i < 80; ++i) w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999u; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1u; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDCu; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6u; }
+            const uint32_t t = std::rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = std::rotl(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    };
+
+    const auto* p = static_cast<const uint8_t*>(data);
+    size_t remaining = len;
+    for (; remaining >= 64; remaining -= 64, p += 64) compress(p);
+
+    // Final block(s): 0x80, zero padding, then the message length in bits (big-endian)
+    uint8_t tail[128] = {};
+    std::memcpy(tail, p, remaining);
+    tail[remaining] = 0x80;
+    const size_t tailSize = remaining < 56 ? 64 : 128;
+    const uint64_t bits = static_cast<uint64_t>(len) * 8;
+    for (int i = 0; i < 8; ++i) tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    compress(tail);
+    if (tailSize == 128) compress(tail + 64);
+
+    std::array<uint8_t, 20> digest{};
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 4; ++j) digest[4 * i + j] = static_cast<uint8_t>(h[i] >> (24 - 8 * j));
+    }
+    return digest;
+}
+
+std::array<uint8_t, 32> sha256(const void* data, const size_t len) {
+    Sha256 hash;
+    hash.update(data, len);
+    return hash.finish();
+}
+
+void Sha256::update(const void* data, size_t len) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    length_ += len;
+    if (blockLength_ > 0) {
+        const size_t take = std::min(len, sizeof(block_) - blockLength_);
+        std::memcpy(block_ + blockLength_, p, take);
+        blockLength_ += take;
+        p += take;
+        len -= take;
+        if (blockLength_ < sizeof(block_)) return;
+        sha256Compress(h_, block_);
+        blockLength_ = 0;
+    }
+    for (; len >= 64; len -= 64, p += 64) sha256Compress(h_, p);
+    std::memcpy(block_, p, len);
+    blockLength_ = len;
+}
+
+std::array<uint8_t, 32> Sha256::finish() {
+    // Same padding as SHA-1: 0x80, zeros, then the message length in bits (big-endian)
+    uint8_t tail[128] = {};
+    std::memcpy(tail, block_, blockLength_);
+    tail[blockLength_] = 0x80;
+    const size_t tailSize = blockLength_ < 56 ? 64 : 128;
+    const uint64_t bits = length_ * 8;
+    for (int i = 0; i < 8; ++i) tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    sha256Compress(h_, tail);
+    if (tailSize == 128) sha256Compress(h_, tail + 64);
+
+    std::array<uint8_t, 32> digest{};
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 4; ++j) digest[4 * i + j] = static_cast<uint8_t>(h_[i] >> (24 - 8 * j));
+    }
+    return digest;
+}
+
+} // namespace blade::Hashing
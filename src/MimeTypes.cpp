@@ -0,0 +1,212 @@
+#include "MimeTypes.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+namespace blade {
+
+namespace {
+
+struct MimeEntry {
+    std::string_view extension;  // Lowercase, without the dot
+    std::string_view type;
+};
+
+// Sorted by extension for binary search
+constexpr MimeEntry BUILTIN_TYPES[] = {
+    {"3gp", "video/3gpp"},
+    {"7z", "application/x-7z-compressed"},
+    {"aac", "audio/aac"},
+    {"apk", "application/vnd.android.package-archive"},
+    {"avi", "video/x-msvideo"},
+    {"avif", "image/avif"},
+    {"bmp", "image/bmp"},
+    {"css", "text/css"},
+    {"csv", "text/csv"},
+    {"doc", "application/msword"},
+    {"docx", "application/vnd.openxmlformats-officedocument.wordprocessingml.document"},
+    {"epub", "application/epub+zip"},
+    {"flac", "audio/flac"},
+    {"flv", "video/x-flv"},
+    {"gif", "image/gif"},
+    {"gz", "application/gzip"},
+    {"heic", "image/heic"},
+    {"htm", "text/html"},
+    {"html", "text/html"},
+    {"ico", "image/x-icon"},
+    {"jpeg", "image/jpeg"},
+    {"jpg", "image/jpeg"},
+    {"js", "application/javascript"},
+    {"json", "application/json"},
+    {"m4a", "audio/mp4"},
+    {"m4v", "video/x-m4v"},
+    {"md", "text/markdown"},
+    {"mjs", "application/javascript"},
+    {"mkv", "video/x-matroska"},
+    {"mov", "video/quicktime"},
+    {"mp3", "audio/mpeg"},
+    {"mp4", "video/mp4"},
+    {"odp", "application/vnd.oasis.opendocument.presentation"},
+    {"ods", "application/vnd.oasis.opendocument.spreadsheet"},
+    {"odt", "application/vnd.oasis.opendocument.text"},
+    {"ogg", "audio/ogg"},
+    {"opus", "audio/opus"},
+    {"otf", "font/otf"},
+    {"pdf", "application/pdf"},
+    {"png", "image/png"},
+    {"ppt", "application/vnd.ms-powerpoint"},
+    {"pptx", "application/vnd.openxmlformats-officedocument.presentationml.presentation"},
+    {"rar", "application/x-rar-compressed"},
+    {"rtf", "application/rtf"},
+    {"svg", "image/svg+xml"},
+    {"tar", "application/x-tar"},
+    {"tif", "image/tiff"},
+    {"tiff", "image/tiff"},
+    {"ttf", "font/ttf"},
+    {"txt", "text/plain"},
+    {"wav", "audio/wav"},
+    {"webm", "video/webm"},
+    {"webp", "image/webp"},
+    {"wma", "audio/x-ms-wma"},
+    {"wmv", "video/x-ms-wmv"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"xls", "application/vnd.ms-excel"},
+    {"xlsx", "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet"},
+    {"xml", "application/xml"},
+    {"zip", "application/zip"},
+};
+
+constexpr char toLowerAscii(const char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool isLowercase(const std::string_view s) {
+    return std::ranges::all_of(s, [](const char c) { return toLowerAscii(c) == c; });
+}
+
+static_assert(std::ranges::is_sorted(BUILTIN_TYPES, [](const MimeEntry& a, const MimeEntry& b) {
+                  return a.extension < b.extension;
+              }) &&
+              std::ranges::adjacent_find(BUILTIN_TYPES, [](const MimeEntry& a, const MimeEntry& b) {
+                  return a.extension == b.extension;
+              }) == std::ranges::end(BUILTIN_TYPES),
+              "BUILTIN_TYPES must be sorted by extension without duplicates");
+static_assert(std::ranges::all_of(BUILTIN_TYPES, [](const MimeEntry& e) { return isLowercase(e.extension); }),
+              "BUILTIN_TYPES extensions must be lowercase");
+
+constexpr size_t MAX_EXTENSION = 16;  // Longer "extensions" are not file types
+
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(const std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+// Mappings read from mime.types files. Types are only ever appended, so views
+// handed out by lookups stay valid when a later file overrides an extension.
+struct Overrides {
+    std::shared_mutex mutex;
+    std::deque<std::string> types;
+    std::unordered_map<std::string, std::string_view, StringHash, std::equal_to<>> byExtension;
+};
+
+Overrides& overrides() {
+    static Overrides instance;
+    return instance;
+}
+
+std::atomic<bool> hasOverrides{false};  // Lets lookups skip the lock until a file has been loaded
+
+} // namespace
+
+namespace MimeTypes {
+
+std::string_view fromExtension(const std::string_view extension) {
+    if (extension.empty() || extension.size() > MAX_EXTENSION) return DEFAULT_TYPE;
+    char buffer[MAX_EXTENSION];
+    std::ranges::transform(extension, buffer, toLowerAscii);
+    const std::string_view key(buffer, extension.size());
+
+    if (hasOverrides.load(std::memory_order_acquire)) {
+        Overrides& o = overrides();
+        std::shared_lock lock(o.mutex);
+        if (const auto it = o.byExtension.find(key); it != o.byExtension.end()) return it->second;
+    }
+
+    const auto it = std::ranges::lower_bound(BUILTIN_TYPES, key, {}, &MimeEntry::extension);
+    return it != std::ranges::end(BUILTIN_TYPES) && it->extension == key ? it->type : DEFAULT_TYPE;
+}
+
+std::string_view fromPath(const std::string_view path) {
+    const size_t slash = path.find_last_of("/\\");
+    const std::string_view name = slash == std::string_view::npos ? path : path.substr(slash + 1);
+    const size_t dot = name.rfind('.');
+    // Like std::filesystem::path::extension(), a leading dot (".hidden") is not an extension
+    if (dot == std::string_view::npos || dot == 0) return DEFAULT_TYPE;
+    return fromExtension(name.substr(dot + 1));
+}
+
+bool isCompressed(const std::string_view type) {
+    static constexpr std::string_view COMPRESSED_TYPES[] = {
+        "application/epub+zip",
+        "application/gzip",
+        "application/pdf",
+        "application/vnd.android.package-archive",
+        "application/x-7z-compressed",
+        "application/x-rar-compressed",
+        "application/zip",
+    };
+    // Uncompressed exceptions among the media types
+    if (type.starts_with("image/")) {
+        return type != "image/bmp" && type != "image/svg+xml" && type != "image/tiff" && type != "image/x-icon";
+    }
+    if (type.starts_with("audio/")) return type != "audio/wav";
+    if (type.starts_with("video/") || type.starts_with("font/woff")) return true;
+    // Office documents of both families are ZIP archives
+    if (type.starts_with("application/vnd.openxmlformats-") || type.starts_with("application/vnd.oasis.opendocument.")) {
+        return true;
+    }
+    return std::ranges::find(COMPRESSED_TYPES, type) != std::ranges::end(COMPRESSED_TYPES);
+}
+
+bool loadFile(const std::filesystem::path& file) {
+    std::ifstream in(file);
+    if (!in.is_open()) return false;
+
+    Overrides& o = overrides();
+    std::unique_lock lock(o.mutex);
+    size_t added = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (const size_t hash = line.find('#'); hash != std::string::npos) line.resize(hash);
+        std::istringstream tokens(line);
+        std::string type;
+        if (!(tokens >> type) || type.find('/') == std::string::npos) continue;
+
+        const std::string_view stored = o.types.emplace_back(std::move(type));
+        std::string extension;
+        while (tokens >> extension) {
+            if (extension.ends_with(';')) extension.pop_back();  // nginx terminates each entry
+            if (extension.starts_with('.')) extension.erase(0, 1);
+            if (extension.empty() || extension.size() > MAX_EXTENSION) continue;
+            std::ranges::transform(extension, extension.begin(), toLowerAscii);
+            o.byExtension.insert_or_assign(std::move(extension), stored);
+            ++added;
+        }
+    }
+    hasOverrides.store(!o.byExtension.empty(), std::memory_order_release);
+    Logger::getInstance().info("Loaded " + std::to_string(added) + " MIME type mappings from " + file.string());
+    return true;
+}
+
+} // namespace MimeTypes
+
+} // namespace blade
@@ -0,0 +1,175 @@
+#include "MultipartParser.h"
+
+#include <string_view>
+#include <utility>
+
+namespace blade {
+
+namespace {
+
+constexpr size_t kMaxPartHeaderSize = 16 * 1024;   // Per-part header block limit
+constexpr size_t kMaxBoundaryPadding = 1024;       // Transport padding allowed after a boundary
+
+size_t findSequence(const std::vector<uint8_t>& hay, const std::string_view needle) {
+    return ByteSearcher::find(hay.data(), hay.size(), needle);
+}
+
+} // namespace
+
+MultipartParser::MultipartParser(const std::string& boundary, Callbacks callbacks)
+    : delimiter_("\r\n--" + boundary), delimiterSearch_(delimiter_),
+      firstBoundarySearch_(std::string_view(delimiter_).substr(2)), callbacks_(std::move(callbacks)),
+      state_(State::Preamble), consumed_(0)
+{
+    buffer_.reserve(64 * 1024 + delimiter_.size());
+}
+
+bool MultipartParser::feed(const uint8_t* data, const size_t len) {
+    if (state_ == State::Error) return false;
+    if (state_ == State::Done) {
+        consumed_ += len; // Epilogue is ignored
+        return true;
+    }
+    buffer_.insert(buffer_.end(), data, data + len);
+    return process();
+}
+
+bool MultipartParser::isDone() const {
+    return state_ == State::Done;
+}
+
+bool MultipartParser::hasError() const {
+    return state_ == State::Error;
+}
+
+uint64_t MultipartParser::bytesConsumed() const {
+    return consumed_;
+}
+
+std::string MultipartParser::boundaryFromContentType(const std::string& contentType) {
+    const size_t bpos = contentType.find("boundary=");
+    if (bpos == std::string::npos) return "";
+    std::string token = contentType.substr(bpos + 9);
+    // Trim optional quotes and spaces
+    while (!token.empty() && token.front() == ' ') token.erase(token.begin());
+    if (!token.empty() && token.front() == '"') {
+        token.erase(token.begin());
+        if (const size_t q = token.find('"'); q != std::string::npos)
+            token.resize(q);
+    } else {
+        if (const size_t sc = token.find(';'); sc != std::string::npos)
+            token.resize(sc);
+        while (!token.empty() && token.back() == ' ') token.pop_back();
+    }
+    return token;
+}
+
+bool MultipartParser::process() {
+    while (true) {
+        switch (state_) {
+        case State::Preamble: {
+            const size_t pos = firstBoundarySearch_.find(buffer_.data(), buffer_.size());
+            if (pos == std::string::npos) {
+                // Keep only the tail that could still be the start of a boundary
+                consume(buffer_.size() - firstBoundarySearch_.partialMatchLength(buffer_.data(), buffer_.size()));
+                return true;
+            }
+            consume(pos + firstBoundarySearch_.needle().size());
+            state_ = State::BoundaryTail;
+            break;
+        }
+
+        case State::BoundaryTail: {
+            if (buffer_.size() < 2) return true;
+            if (buffer_[0] == '-' && buffer_[1] == '-') {
+                consume(buffer_.size());
+                state_ = State::Done;
+                return true;
+            }
+            const size_t eol = findSequence(buffer_, "\r\n");
+            if (eol == std::string::npos) {
+                return buffer_.size() <= kMaxBoundaryPadding || fail();
+            }
+            consume(eol + 2);
+            state_ = State::Headers;
+            break;
+        }
+
+        case State::Headers: {
+            std::string headers;
+            if (buffer_.size() >= 2 && buffer_[0] == '\r' && buffer_[1] == '\n') {
+                consume(2); // Part without headers
+            } else {
+                const size_t end = findSequence(buffer_, "\r\n\r\n");
+                if (end == std::string::npos) {
+                    return buffer_.size() <= kMaxPartHeaderSize || fail();
+                }
+                headers.assign(reinterpret_cast<const char*>(buffer_.data()), end);
+                consume(end + 4);
+            }
+            if (callbacks_.onPartBegin && !callbacks_.onPartBegin(filenameFromHeaders(headers)))
+                return fail();
+            state_ = State::Body;
+            break;
+        }
+
+        case State::Body: {
+            const size_t pos = delimiterSearch_.find(buffer_.data(), buffer_.size());
+            if (pos == std::string::npos) {
+                // Everything except a possible partial delimiter at the end is part data
+                const size_t safe = buffer_.size() - delimiterSearch_.partialMatchLength(buffer_.data(), buffer_.size());
+                if (safe > 0) {
+                    if (callbacks_.onPartData && !callbacks_.onPartData(buffer_.data(), safe))
+                        return fail();
+                    consume(safe);
+                }
+                return true;
+            }
+            if (pos > 0 && callbacks_.onPartData && !callbacks_.onPartData(buffer_.data(), pos))
+                return fail();
+            consume(pos + delimiter_.size());
+            if (callbacks_.onPartEnd && !callbacks_.onPartEnd())
+                return fail();
+            state_ = State::BoundaryTail;
+            break;
+        }
+
+        case State::Done:
+            return true;
+
+        case State::Error:
+            return false;
+        }
+    }
+}
+
+void MultipartParser::consume(const size_t n) {
+    buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(n));
+    consumed_ += n;
+}
+
+bool MultipartParser::fail() {
+    state_ = State::Error;
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+    return false;
+}
+
+std::string MultipartParser::filenameFromHeaders(const std::string& headers) {
+    std::string filename;
+    if (size_t fn = headers.find("filename="); fn != std::string::npos) {
+        fn += 9;
+        if (fn < headers.size() && headers[fn] == '"') {
+            ++fn;
+            if (const size_t endq = headers.find('"', fn); endq != std::string::npos)
+                filename = headers.substr(fn, endq - fn);
+        } else {
+            size_t end = headers.find(';', fn);
+            if (end == std::string::npos) end = headers.find("\r\n", fn);
+            filename = headers.substr(fn, end == std::string::npos ? std::string::npos : end - fn);
+        }
+    }
+    return filename;
+}
+
+} // namespace blade
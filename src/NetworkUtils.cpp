@@ -2,11 +2,16 @@
 #include <cstring>
 #include <cstdint>
 #include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <iostream>
+#include <fstream>
+#include <filesystem>
 
 #ifdef _WIN32
   #include <winsock2.h>
   #include <ws2tcpip.h>
+  #include <mswsock.h>
   #include <iphlpapi.h>
   // MinGW/ld won't honor this pragma; linking must be done via build system.
   // #pragma comment(lib, "iphlpapi.lib")
@@ -14,20 +19,39 @@
   #include <unistd.h>
   #include <sys/types.h>
   #include <sys/socket.h>
+  #include <sys/uio.h>
   #include <netinet/in.h>
+  #include <netinet/tcp.h>
   #include <arpa/inet.h>
   #include <netdb.h>
   #include <cerrno>
+  #include <csignal>
+  #include <fcntl.h>
+  #if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/sendfile.h>
+  #endif
 #endif
 
 namespace blade::NetworkUtils {
 
+// Writes to a peer that has gone away fail with EPIPE instead of raising SIGPIPE
+#ifdef MSG_NOSIGNAL
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
 bool initialize() {
 #ifdef _WIN32
     WSADATA wsaData;
     return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
 #else
-    return true; // Not needed on Unix-like systems
+    // sendfile(2) takes no flags, and SIGPIPE would terminate the process when a client
+    // aborts a download; every write reports the broken connection as an error instead
+    std::signal(SIGPIPE, SIG_IGN);
+    return true;
 #endif
 }
 
@@ -120,6 +144,16 @@ void closeSocket(SocketType socket) {
     }
 }
 
+void shutdownSocket(const SocketType socket) {
+    if (socket != INVALID_SOCKET) {
+#ifdef _WIN32
+        shutdown(socket, SD_BOTH);
+#else
+        shutdown(socket, SHUT_RDWR);
+#endif
+    }
+}
+
 static bool isPrivateIPv4(const std::string& ip) {
     // Minimal checks for common private ranges
     return ip.rfind("10.", 0) == 0 ||
@@ -232,7 +266,7 @@ int sendData(const SocketType socket, const std::string& data) {
 #ifdef _WIN32
         int sent = send(socket, ptr + totalSent, static_cast<int>(remaining), 0);
 #else
-        ssize_t sent = send(socket, ptr + totalSent, remaining, 0);
+        ssize_t sent = send(socket, ptr + totalSent, remaining, SEND_FLAGS);
 #endif
         if (sent <= 0) {
             return static_cast<int>(totalSent > 0 ? totalSent : sent);
@@ -252,6 +286,11 @@ int receiveData(const SocketType socket, char* buffer, const size_t maxSize) {
 #endif
 }
 
+bool setNoDelay(const SocketType socket) {
+    const int enable = 1;
+    return setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable), sizeof(enable)) == 0;
+}
+
 bool sendAll(const SocketType socket, const void* data, const size_t len) {
     const auto p = static_cast<const char*>(data);
     size_t sent = 0;
@@ -259,7 +298,7 @@ bool sendAll(const SocketType socket, const void* data, const size_t len) {
 #ifdef _WIN32
         const int n = ::send(socket, p + sent, static_cast<int>(len - sent), 0);
 #else
-        ssize_t n = ::send(socket, p + sent, len - sent, 0);
+        ssize_t n = ::send(socket, p + sent, len - sent, SEND_FLAGS);
 #endif
         if (n <= 0) return false;
         sent += static_cast<size_t>(n);
@@ -267,6 +306,90 @@ bool sendAll(const SocketType socket, const void* data, const size_t len) {
     return true;
 }
 
+bool setNonBlocking(const SocketType socket) {
+#ifdef _WIN32
+    u_long enable = 1;
+    return ioctlsocket(socket, FIONBIO, &enable) == 0;
+#else
+    const int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+int sendSome(const SocketType socket, const void* data, const size_t len) {
+    const auto p = static_cast<const char*>(data);
+#ifdef _WIN32
+    const int n = ::send(socket, p, static_cast<int>(std::min<size_t>(len, 1u << 30)), 0);
+    if (n == SOCKET_ERROR) return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+    return n;
+#else
+    ssize_t n;
+    do {
+        n = ::send(socket, p, std::min<size_t>(len, 1u << 30), SEND_FLAGS);
+    } while (n == -1 && errno == EINTR);
+    if (n == -1) return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    return static_cast<int>(n);
+#endif
+}
+
+bool sendBuffers(const SocketType socket, const std::span<const std::string_view> buffers) {
+    constexpr size_t MAX_GATHER = 16;  // Well below IOV_MAX; responses have two or three parts
+#ifdef _WIN32
+    WSABUF parts[MAX_GATHER];
+#else
+    iovec parts[MAX_GATHER];
+#endif
+    size_t index = 0;   // First buffer not completely sent
+    size_t offset = 0;  // Bytes of buffers[index] already sent
+    while (index < buffers.size()) {
+        size_t count = 0;
+        for (size_t i = index; i < buffers.size() && count < MAX_GATHER; ++i) {
+            const size_t skip = i == index ? offset : 0;
+            if (buffers[i].size() == skip) continue;
+            const char* base = buffers[i].data() + skip;
+#ifdef _WIN32
+            parts[count].buf = const_cast<char*>(base);
+            parts[count].len = static_cast<ULONG>(std::min<size_t>(buffers[i].size() - skip, 1u << 30));
+#else
+            parts[count].iov_base = const_cast<char*>(base);
+            parts[count].iov_len = buffers[i].size() - skip;
+#endif
+            ++count;
+        }
+        if (count == 0) break;
+
+#ifdef _WIN32
+        DWORD n = 0;
+        if (WSASend(socket, parts, static_cast<DWORD>(count), &n, 0, nullptr, nullptr) != 0 || n == 0) return false;
+        size_t sent = n;
+#else
+        msghdr msg{};
+        msg.msg_iov = parts;
+        msg.msg_iovlen = count;
+        const ssize_t n = ::sendmsg(socket, &msg, SEND_FLAGS);
+        if (n <= 0) return false;
+        auto sent = static_cast<size_t>(n);
+#endif
+        // Advance past what the kernel took; a partial write resumes mid-buffer
+        while (sent > 0 && index < buffers.size()) {
+            const size_t left = buffers[index].size() - offset;
+            if (sent < left) {
+                offset += sent;
+                sent = 0;
+            } else {
+                sent -= left;
+                ++index;
+                offset = 0;
+            }
+        }
+        while (index < buffers.size() && buffers[index].size() == offset) {
+            ++index;
+            offset = 0;
+        }
+    }
+    return true;
+}
+
 bool recvAll(const SocketType socket, void* data, const size_t len) {
     const auto p = static_cast<char*>(data);
     size_t recvd = 0;
@@ -282,5 +405,256 @@ bool recvAll(const SocketType socket, void* data, const size_t len) {
     return true;
 }
 
+// Bytes handed to the kernel per zero-copy call; also the progress reporting granularity
+static constexpr uint64_t SEND_FILE_CHUNK = 4 * 1024 * 1024;
+
+// Portable fallback: read the range through a user-space buffer
+static uint64_t sendFileBuffered(const SocketType socket, const std::string& path, const uint64_t offset,
+                                 const uint64_t length, uint64_t sent,
+                                 const std::function<void(uint64_t)>& onProgress) {
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file.is_open()) return sent;
+    file.seekg(static_cast<std::streamoff>(offset + sent), std::ios::beg);
+
+    constexpr size_t CHUNK_SIZE = 256 * 1024;
+    std::vector<char> buffer(CHUNK_SIZE);
+    while (sent < length && file.good()) {
+        const auto want = static_cast<std::streamsize>(std::min<uint64_t>(CHUNK_SIZE, length - sent));
+        file.read(buffer.data(), want);
+        const auto bytesRead = static_cast<size_t>(file.gcount());
+        if (bytesRead == 0 || !sendAll(socket, buffer.data(), bytesRead)) break;
+        sent += bytesRead;
+        if (onProgress) onProgress(sent);
+    }
+    return sent;
+}
+
+std::string formatHttpDate(const std::filesystem::file_time_type modified) {
+    const std::time_t t = std::chrono::system_clock::to_time_t(
+        std::chrono::time_point_cast<std::chrono::system_clock::duration>(std::chrono::file_clock::to_sys(modified)));
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char buf[64];
+    const size_t len = std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return {buf, len};
+}
+
+uint64_t sendFile(const SocketType socket, const std::string& path, const uint64_t offset, const uint64_t length,
+                  const std::function<void(uint64_t)>& onProgress) {
+    uint64_t sent = 0;
+#if defined(__linux__)
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    // Only widens read-ahead; pages stay cached for concurrent downloads of the same file
+    posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_SEQUENTIAL);
+
+    bool fallback = false;
+    while (sent < length) {
+        auto pos = static_cast<off_t>(offset + sent);
+        const ssize_t n = ::sendfile(socket, fd, &pos, static_cast<size_t>(std::min(SEND_FILE_CHUNK, length - sent)));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EINVAL || errno == ENOSYS) && sent == 0) {
+            fallback = true; // Filesystem without sendfile support
+            break;
+        }
+        if (n <= 0) break;
+        sent += static_cast<uint64_t>(n);
+        if (onProgress) onProgress(sent);
+    }
+    ::close(fd);
+    if (fallback) return sendFileBuffered(socket, path, offset, length, sent, onProgress);
+    return sent;
+#elif defined(_WIN32)
+    // No FILE_FLAG_SEQUENTIAL_SCAN: the cache manager unmaps the views behind such a reader and
+    // repurposes its pages first, so concurrent downloads of the same file trailing it would
+    // read it from disk again. Its read-ahead detects the sequential pattern without the flag.
+    const HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+
+    bool fallback = false;
+    while (sent < length) {
+        LARGE_INTEGER pos;
+        pos.QuadPart = static_cast<LONGLONG>(offset + sent);
+        const auto chunk = static_cast<DWORD>(std::min(SEND_FILE_CHUNK, length - sent));
+        // Synchronous TransmitFile sends from the current file pointer
+        if (!SetFilePointerEx(file, pos, nullptr, FILE_BEGIN)) break;
+        if (!TransmitFile(socket, file, chunk, 0, nullptr, nullptr, TF_USE_KERNEL_APC)) {
+            fallback = sent == 0 && WSAGetLastError() == WSAEOPNOTSUPP;
+            break;
+        }
+        sent += chunk;
+        if (onProgress) onProgress(sent);
+    }
+    CloseHandle(file);
+    if (fallback) return sendFileBuffered(socket, path, offset, length, sent, onProgress);
+    return sent;
+#else
+    return sendFileBuffered(socket, path, offset, length, sent, onProgress);
+#endif
+}
+
+#if defined(__linux__)
+
+Poller::Poller()
+    : epollFd_(epoll_create1(EPOLL_CLOEXEC)), wakeFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    if (epollFd_ >= 0 && wakeFd_ >= 0) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+    }
+}
+
+Poller::~Poller() {
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+}
+
+bool Poller::isValid() const {
+    return epollFd_ >= 0 && wakeFd_ >= 0;
+}
+
+bool Poller::add(const SocketType socket) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.fd = socket;
+    return epoll_ctl(epollFd_, EPOLL_CTL_ADD, socket, &ev) == 0;
+}
+
+bool Poller::remove(const SocketType socket) {
+    return epoll_ctl(epollFd_, EPOLL_CTL_DEL, socket, nullptr) == 0;
+}
+
+bool Poller::watchWritable(const SocketType socket, const bool enable) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (enable ? EPOLLOUT : 0u);
+    ev.data.fd = socket;
+    return epoll_ctl(epollFd_, EPOLL_CTL_MOD, socket, &ev) == 0;
+}
+
+int Poller::wait(std::vector<Event>& events, const int timeoutMs) {
+    events.clear();
+    epoll_event ready[64];
+    const int n = epoll_wait(epollFd_, ready, 64, timeoutMs);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < n; ++i) {
+        if (ready[i].data.fd == wakeFd_) {
+            uint64_t value;
+            (void)::read(wakeFd_, &value, sizeof(value));
+            continue;
+        }
+        const bool error = (ready[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+        const bool readable = (ready[i].events & (EPOLLIN | EPOLLRDHUP)) != 0;
+        const bool writable = (ready[i].events & EPOLLOUT) != 0;
+        events.push_back({ready[i].data.fd, readable, error, writable});
+    }
+    return static_cast<int>(events.size());
+}
+
+void Poller::wakeup() {
+    const uint64_t one = 1;
+    (void)::write(wakeFd_, &one, sizeof(one));
+}
+
+#else
+
+// poll()/WSAPoll() fallback. A UDP socket connected to itself serves as the
+// wakeup channel because WSAPoll() cannot watch pipes or events.
+Poller::Poller() : wakeSocket_(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) {
+    if (wakeSocket_ == INVALID_SOCKET) return;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+#ifdef _WIN32
+    int len = sizeof(addr);
+#else
+    socklen_t len = sizeof(addr);
+#endif
+    if (::bind(wakeSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+        getsockname(wakeSocket_, reinterpret_cast<sockaddr*>(&addr), &len) == -1 ||
+        ::connect(wakeSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        closeSocket(wakeSocket_);
+        wakeSocket_ = INVALID_SOCKET;
+        return;
+    }
+    fds_.push_back(PollFd{wakeSocket_, POLLIN, 0});
+}
+
+Poller::~Poller() {
+    closeSocket(wakeSocket_);
+}
+
+bool Poller::isValid() const {
+    return wakeSocket_ != INVALID_SOCKET;
+}
+
+bool Poller::add(const SocketType socket) {
+    fds_.push_back(PollFd{socket, POLLIN, 0});
+    return true;
+}
+
+bool Poller::remove(const SocketType socket) {
+    const auto it = std::find_if(fds_.begin() + 1, fds_.end(),
+        [socket](const PollFd& p) { return p.fd == socket; });
+    if (it == fds_.end()) return false;
+    *it = fds_.back();
+    fds_.pop_back();
+    return true;
+}
+
+bool Poller::watchWritable(const SocketType socket, const bool enable) {
+    const auto it = std::find_if(fds_.begin() + 1, fds_.end(),
+        [socket](const PollFd& p) { return p.fd == socket; });
+    if (it == fds_.end()) return false;
+    it->events = enable ? (POLLIN | POLLOUT) : POLLIN;
+    return true;
+}
+
+int Poller::wait(std::vector<Event>& events, const int timeoutMs) {
+    events.clear();
+#ifdef _WIN32
+    const int n = WSAPoll(fds_.data(), static_cast<ULONG>(fds_.size()), timeoutMs);
+#else
+    const int n = ::poll(fds_.data(), static_cast<nfds_t>(fds_.size()), timeoutMs);
+#endif
+    if (n < 0) {
+#ifndef _WIN32
+        if (errno == EINTR) return 0;
+#endif
+        return -1;
+    }
+    if (n == 0) return 0;
+
+    if (fds_[0].revents & POLLIN) {
+        char drain[64];
+        while (::recv(wakeSocket_, drain, sizeof(drain), 0) == sizeof(drain)) {}
+    }
+    for (size_t i = 1; i < fds_.size(); ++i) {
+        const auto revents = fds_[i].revents;
+        if (revents == 0) continue;
+        const bool error = (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+        const bool readable = (revents & POLLIN) != 0;
+        const bool writable = (revents & POLLOUT) != 0;
+        events.push_back({fds_[i].fd, readable, error, writable});
+    }
+    return static_cast<int>(events.size());
+}
+
+void Poller::wakeup() {
+    const char one = 1;
+    (void)::send(wakeSocket_, &one, 1, 0);
+}
+
+#endif
 
 } // namespace blade::NetworkUtils
@@ -0,0 +1,162 @@
+#include "PositionalFile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <cerrno>
+  #include <fcntl.h>
+  #include <sys/types.h>
+  #include <unistd.h>
+#endif
+
+namespace blade {
+
+PositionalFile::~PositionalFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool PositionalFile::open(const std::filesystem::path& path, const Mode mode) {
+    close();
+    const DWORD access = mode == Mode::Read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+    const DWORD disposition = mode == Mode::Read ? OPEN_EXISTING : OPEN_ALWAYS;
+    // FILE_SHARE_DELETE lets a completed upload be renamed while late writers still hold it
+    const HANDLE handle = CreateFileW(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                      nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    handle_ = handle;
+    return true;
+}
+
+void PositionalFile::close() {
+    if (handle_) {
+        CloseHandle(static_cast<HANDLE>(handle_));
+        handle_ = nullptr;
+    }
+}
+
+bool PositionalFile::isOpen() const {
+    return handle_ != nullptr;
+}
+
+bool PositionalFile::writeAt(uint64_t offset, const uint8_t* data, size_t len) const {
+    while (len > 0) {
+        // On a synchronous handle the OVERLAPPED offset makes WriteFile positional
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        const auto chunk = static_cast<DWORD>(std::min<size_t>(len, 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle_), data, chunk, &written, &ov) || written == 0) return false;
+        offset += written;
+        data += written;
+        len -= written;
+    }
+    return true;
+}
+
+int64_t PositionalFile::readAt(uint64_t offset, uint8_t* data, size_t len) const {
+    int64_t total = 0;
+    while (len > 0) {
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        const auto chunk = static_cast<DWORD>(std::min<size_t>(len, 1u << 30));
+        DWORD read = 0;
+        if (!ReadFile(static_cast<HANDLE>(handle_), data, chunk, &read, &ov)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) break;
+            return -1;
+        }
+        if (read == 0) break;
+        offset += read;
+        data += read;
+        len -= read;
+        total += read;
+    }
+    return total;
+}
+
+bool PositionalFile::preallocate(const uint64_t size) const {
+    const HANDLE handle = static_cast<HANDLE>(handle_);
+    FILE_ALLOCATION_INFO allocation{};
+    allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+    // Allocation is only a hint; the length below is what matters
+    (void)SetFileInformationByHandle(handle, FileAllocationInfo, &allocation, sizeof(allocation));
+    FILE_END_OF_FILE_INFO eof{};
+    eof.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+    return SetFileInformationByHandle(handle, FileEndOfFileInfo, &eof, sizeof(eof)) != 0;
+}
+
+#else
+
+bool PositionalFile::open(const std::filesystem::path& path, const Mode mode) {
+    close();
+    const int flags = mode == Mode::Read ? O_RDONLY : O_RDWR | O_CREAT;
+    fd_ = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    return fd_ >= 0;
+}
+
+void PositionalFile::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool PositionalFile::isOpen() const {
+    return fd_ >= 0;
+}
+
+bool PositionalFile::writeAt(uint64_t offset, const uint8_t* data, size_t len) const {
+    while (len > 0) {
+        const ssize_t n = ::pwrite(fd_, data, len, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return false;
+        offset += static_cast<uint64_t>(n);
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+int64_t PositionalFile::readAt(uint64_t offset, uint8_t* data, size_t len) const {
+    int64_t total = 0;
+    while (len > 0) {
+        const ssize_t n = ::pread(fd_, data, len, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        offset += static_cast<uint64_t>(n);
+        data += n;
+        len -= static_cast<size_t>(n);
+        total += n;
+    }
+    return total;
+}
+
+bool PositionalFile::preallocate(const uint64_t size) const {
+#if defined(__linux__)
+    // The raw syscall, not posix_fallocate(): glibc emulates that one by writing every block on
+    // filesystems without fallocate support (exFAT, CIFS, NFSv3, FUSE), which takes as long as the upload
+    int result = 0;
+    do {
+        result = size > 0 ? ::fallocate(fd_, 0, 0, static_cast<off_t>(size)) : 0;
+    } while (result != 0 && errno == EINTR);
+    if (result == 0) return true;
+    // Unsupported there, so those filesystems only get the length; anything else (e.g. ENOSPC) is a real failure
+    if (errno != EOPNOTSUPP && errno != ENOSYS) return false;
+#endif
+    return ::ftruncate(fd_, static_cast<off_t>(size)) == 0;
+}
+
+#endif
+
+} // namespace blade
@@ -0,0 +1,134 @@
+#include "Router.h"
+
+namespace blade {
+
+namespace {
+
+// Next segment of a path starting at pos, and where the one after it starts (npos at the end)
+std::string_view nextSegment(const std::string_view path, const size_t pos, size_t& next) {
+    const size_t slash = path.find('/', pos);
+    next = slash == std::string_view::npos ? std::string_view::npos : slash + 1;
+    return path.substr(pos, slash == std::string_view::npos ? std::string_view::npos : slash - pos);
+}
+
+struct MethodName {
+    unsigned flag;
+    std::string_view name;
+};
+
+constexpr MethodName METHOD_NAMES[] = {
+    {HttpMethod::Get, "GET"},
+    {HttpMethod::Head, "HEAD"},
+    {HttpMethod::Post, "POST"},
+    {HttpMethod::Put, "PUT"},
+    {HttpMethod::Delete, "DELETE"},
+    {HttpMethod::Options, "OPTIONS"},
+};
+
+} // namespace
+
+std::string_view RouteMatch::param(const std::string_view name) const {
+    for (size_t i = 0; i < paramCount; ++i) {
+        if (names[i] == name) return values[i];
+    }
+    return {};
+}
+
+Router::Router(const std::span<const Route> routes) : nodes_(1) {
+    for (const Route& route : routes) {
+        size_t node = 0;
+        size_t pos = 1;
+        bool catchAll = false;
+        while (pos != std::string_view::npos) {
+            size_t next;
+            const std::string_view segment = nextSegment(route.pattern, pos, next);
+            pos = next;
+            if (segment.starts_with("{*")) {
+                nodes_[node].rest.push_back(&route);
+                nodes_[node].restName = segment.substr(2, segment.size() - 3);
+                catchAll = true;
+                break;
+            }
+            if (segment.starts_with('{')) {
+                if (nodes_[node].param == NONE) {
+                    nodes_[node].param = nodes_.size();
+                    nodes_[node].paramName = segment.substr(1, segment.size() - 2);
+                    nodes_.emplace_back();
+                }
+                node = nodes_[node].param;
+                continue;
+            }
+            const auto it = nodes_[node].literals.find(segment);
+            if (it != nodes_[node].literals.end()) {
+                node = it->second;
+            } else {
+                nodes_[node].literals.emplace(segment, nodes_.size());
+                node = nodes_.size();
+                nodes_.emplace_back();
+            }
+        }
+        if (!catchAll) nodes_[node].routes.push_back(&route);
+    }
+}
+
+RouteMatch Router::match(const std::string_view method, const std::string_view path) const {
+    RouteMatch match;
+    if (!path.starts_with('/')) return match;
+    const auto* candidates = find(0, path, 1, match);
+    if (!candidates) return match;
+
+    const unsigned flag = methodFlag(method);
+    for (const Route* route : *candidates) {
+        match.allowedMethods |= route->methods;
+        if (!match.route && (route->methods & flag) != 0) match.route = route;
+    }
+    return match;
+}
+
+const std::vector<const Route*>* Router::find(const size_t index, const std::string_view path, const size_t pos,
+                                              RouteMatch& match) const {
+    const Node& node = nodes_[index];
+    if (pos == std::string_view::npos) {
+        if (!node.routes.empty()) return &node.routes;
+    } else {
+        size_t next;
+        const std::string_view segment = nextSegment(path, pos, next);
+
+        if (const auto it = node.literals.find(segment); it != node.literals.end()) {
+            if (const auto* found = find(it->second, path, next, match)) return found;
+        }
+        if (node.param != NONE && !segment.empty() && match.paramCount < RouteMatch::MAX_PARAMS) {
+            const size_t slot = match.paramCount++;
+            match.names[slot] = node.paramName;
+            match.values[slot] = segment;
+            if (const auto* found = find(node.param, path, next, match)) return found;
+            match.paramCount = slot; // Backtrack
+        }
+    }
+    if (!node.rest.empty() && match.paramCount < RouteMatch::MAX_PARAMS) {
+        const size_t slot = match.paramCount++;
+        match.names[slot] = node.restName;
+        match.values[slot] = pos == std::string_view::npos ? std::string_view() : path.substr(pos);
+        return &node.rest;
+    }
+    return nullptr;
+}
+
+unsigned Router::methodFlag(const std::string_view method) {
+    for (const auto& [flag, name] : METHOD_NAMES) {
+        if (name == method) return flag;
+    }
+    return 0;
+}
+
+std::string Router::methodList(const unsigned methods) {
+    std::string list;
+    for (const auto& [flag, name] : METHOD_NAMES) {
+        if ((methods & flag) == 0) continue;
+        if (!list.empty()) list += ", ";
+        list += name;
+    }
+    return list;
+}
+
+} // namespace blade
@@ -2,9 +2,15 @@
 #include "NetworkUtils.h"
 #include "QRCodeGen.h"
 #include "Logger.h"
+#include "MimeTypes.h"
+#include "Hashing.h"
 #include <thread>
 #include <vector>
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <tuple>
 #include <windows.h>
 
 namespace blade {
@@ -95,9 +101,12 @@ void Server::setDownloadDirectory(const std::string& path) {
             p = std::filesystem::absolute(p);
         }
         std::filesystem::create_directories(p);
+        // The index of the previous directory is closed outside the lock
+        auto store = std::make_shared<ChunkStore>(p);
         {
             std::lock_guard lock(downloadDirMutex_);
             downloadDir_ = p.string();
+            chunkStore_.swap(store);
         }
         Logger::getInstance().info("Download directory set to: " + p.string());
     } catch (const std::exception& e) {
@@ -110,7 +119,237 @@ std::string Server::getDownloadDirectory() const {
     return downloadDir_;
 }
 
-bool Server::handleUpload(const std::string& filename, const std::vector<uint8_t>& data, const size_t fileSize) const {
+std::shared_ptr<ChunkStore> Server::chunkStore() const {
+    std::lock_guard lock(downloadDirMutex_);
+    return chunkStore_;
+}
+
+namespace {
+
+constexpr auto UPLOAD_SESSION_TIMEOUT = std::chrono::minutes(30);  // Idle time before a chunked upload is abandoned
+constexpr size_t MAX_UPLOAD_SESSIONS_PER_CLIENT = 16;  // Unfinished sessions one client address may hold
+constexpr uint64_t UPLOAD_SPACE_RESERVE = 256ull * 1024 * 1024;  // Free space an upload session must leave on the volume
+constexpr auto PENDING_REVALIDATE_INTERVAL = std::chrono::seconds(10);  // Background re-stat of queued files
+
+// Reads a queued file's metadata; false if it can't be stat'ed
+bool statPendingFile(const std::string& path, uint64_t& size, std::filesystem::file_time_type& modified) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    modified = std::filesystem::last_write_time(path, ec);
+    return !ec;
+}
+
+// First free name for `filename` in `dir`, appending (1), (2), ... if it already exists
+std::filesystem::path uniqueDestination(const std::filesystem::path& dir, const std::string& filename) {
+    const std::filesystem::path dest = dir / filename;
+    const std::string base = dest.stem().string();
+    const std::string ext = dest.extension().string();
+    std::filesystem::path candidate = dest;
+    int idx = 1;
+    while (std::filesystem::exists(candidate)) {
+        candidate = dir / (base + '(' + std::to_string(idx++) + ')' + ext);
+    }
+    return candidate;
+}
+
+std::string generateSessionId() {
+    static std::mutex mutex;
+    static std::mt19937_64 gen(std::random_device{}());
+    std::lock_guard lock(mutex);
+    char id[33];
+    std::snprintf(id, sizeof(id), "%016llx%016llx",
+                  static_cast<unsigned long long>(gen()), static_cast<unsigned long long>(gen()));
+    return id;
+}
+
+// Writes one chunk of a resumable upload at its offset in the session's partial file.
+// Several of these may write the same session concurrently from different connections.
+// Nothing is undone on failure: uncommitted bytes are simply overwritten by the retry.
+class ChunkUploadSink final : public UploadSink {
+public:
+    ChunkUploadSink(const Server* server, std::shared_ptr<UploadSession> session, const uint64_t offset, const uint64_t length,
+                    std::function<bool(UploadSession&, uint64_t, uint64_t)> onCommit)
+        : server_(server), session_(std::move(session)), file_(session_->file()),
+          offset_(offset), length_(length), onCommit_(std::move(onCommit)) {}
+
+    ~ChunkUploadSink() override {
+        // An abandoned chunk no longer counts towards progress
+        session_->addInFlight(-static_cast<int64_t>(written_));
+    }
+
+    [[nodiscard]] bool isOpen() const { return file_ && file_->isOpen(); }
+
+    bool write(const uint8_t* data, const size_t len) override {
+        if (written_ + len > length_) return false;
+        if (!file_->writeAt(offset_ + written_, data, len)) {
+            Logger::getInstance().error("Failed to write upload chunk to: " + session_->partPath().string());
+            return false;
+        }
+        written_ += len;
+        if (const int pct = session_->addInFlight(static_cast<int64_t>(len)); pct >= 0) {
+            server_->reportIncomingProgress(session_->name(), pct);
+        }
+        return true;
+    }
+
+    bool finish() override {
+        if (written_ != length_) return false;
+        session_->addInFlight(-static_cast<int64_t>(written_));
+        written_ = 0;
+        file_.reset(); // Don't hold the handle while the completed file is renamed
+        return onCommit_(*session_, offset_, offset_ + length_);
+    }
+
+private:
+    const Server* server_;
+    std::shared_ptr<UploadSession> session_;
+    std::shared_ptr<PositionalFile> file_;
+    uint64_t offset_;
+    uint64_t length_;
+    std::function<bool(UploadSession&, uint64_t, uint64_t)> onCommit_;
+    uint64_t written_ = 0;
+};
+
+// Rebuilds a whole upload from a delta against the saved file (see DeltaPatcher), writing the
+// session's partial file front to back. Progress counts bytes produced, not bytes received.
+// The result is committed, and marked to replace the basis if asked, only if it hashes to the
+// digest the client sent for its file.
+class DeltaUploadSink final : public UploadSink {
+public:
+    DeltaUploadSink(const Server* server, std::shared_ptr<UploadSession> session, std::unique_ptr<DeltaPatcher> patcher,
+                    const ChunkStore::Digest& expected, const bool replace,
+                    std::function<bool(UploadSession&, uint64_t, uint64_t)> onCommit)
+        : server_(server), session_(std::move(session)), patcher_(std::move(patcher)), expected_(expected),
+          replace_(replace), onCommit_(std::move(onCommit)) {}
+
+    ~DeltaUploadSink() override {
+        session_->addInFlight(-static_cast<int64_t>(reported_));
+    }
+
+    bool write(const uint8_t* data, const size_t len) override {
+        if (!patcher_->write(data, len)) {
+            Logger::getInstance().error("Failed to apply delta to: " + session_->partPath().string());
+            return false;
+        }
+        const uint64_t produced = patcher_->produced();
+        if (const int pct = session_->addInFlight(static_cast<int64_t>(produced - reported_)); pct >= 0) {
+            server_->reportIncomingProgress(session_->name(), pct);
+        }
+        reported_ = produced;
+        return true;
+    }
+
+    bool finish() override {
+        if (!patcher_->isComplete()) return false;
+        session_->addInFlight(-static_cast<int64_t>(reported_));
+        reported_ = 0;
+        // A weak and truncated strong checksum can both collide, and the basis may have been
+        // rewritten in place without its size or time changing; either leaves a wrong file
+        if (!matchesExpected()) {
+            Logger::getInstance().warning("Delta upload of " + session_->name() +
+                                          " does not match the client's file; discarded");
+            return false;
+        }
+        // Only a verified result may replace the basis; after a failed delta the client falls
+        // back to a plain upload in the same session, which is saved next to it
+        if (replace_) session_->setReplaceExisting();
+        patcher_->release(); // Don't hold either file while the result is moved over the basis
+        return onCommit_(*session_, 0, session_->size());
+    }
+
+private:
+    const Server* server_;
+    std::shared_ptr<UploadSession> session_;
+    std::unique_ptr<DeltaPatcher> patcher_;
+    ChunkStore::Digest expected_;
+    bool replace_;
+    std::function<bool(UploadSession&, uint64_t, uint64_t)> onCommit_;
+    uint64_t reported_ = 0;
+
+    // Reads the rebuilt file back and hashes it
+    bool matchesExpected() const {
+        const std::shared_ptr<PositionalFile> file = session_->file();
+        if (!file) return false;
+        Hashing::Sha256 hash;
+        std::vector<uint8_t> buffer(ChunkStore::MAX_CHUNK_SIZE);
+        for (uint64_t offset = 0; offset < session_->size();) {
+            const auto length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), session_->size() - offset));
+            const int64_t n = file->readAt(offset, buffer.data(), length);
+            if (n <= 0) return false;
+            hash.update(buffer.data(), static_cast<size_t>(n));
+            offset += static_cast<uint64_t>(n);
+        }
+        return hash.finish() == expected_;
+    }
+};
+
+// Streams an upload into its destination file and reports progress as it goes
+class FileUploadSink final : public UploadSink {
+public:
+    FileUploadSink(const Server* server, std::filesystem::path path, std::string displayName, const uint64_t expectedSize,
+                   std::shared_ptr<ChunkStore> chunkStore)
+        : server_(server), path_(std::move(path)), displayName_(std::move(displayName)),
+          expectedSize_(expectedSize), chunkStore_(std::move(chunkStore)), out_(path_, std::ios::binary) {}
+
+    ~FileUploadSink() override {
+        if (finished_) return;
+        // Incomplete upload: don't leave a truncated file behind
+        out_.close();
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+        Logger::getInstance().warning("Upload incomplete, removed partial file: " + path_.string());
+    }
+
+    [[nodiscard]] bool isOpen() const { return out_.is_open(); }
+
+    bool write(const uint8_t* data, const size_t len) override {
+        out_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(len));
+        if (!out_) {
+            Logger::getInstance().error("Failed to write data to file: " + path_.string());
+            return false;
+        }
+        written_ += len;
+
+        // Hold 100% back until the file is complete
+        if (expectedSize_ > 0) {
+            const int pct = static_cast<int>(std::min<uint64_t>(99, (written_ * 100) / expectedSize_));
+            if (pct != lastReportedPct_) {
+                server_->reportIncomingProgress(displayName_, pct);
+                lastReportedPct_ = pct;
+            }
+        }
+        return true;
+    }
+
+    bool finish() override {
+        out_.close();
+        if (!out_) {
+            Logger::getInstance().error("Failed to finalize file: " + path_.string());
+            return false;
+        }
+        finished_ = true;
+        server_->reportIncomingProgress(displayName_, 100);
+        Logger::getInstance().info("Saved uploaded file: " + path_.string() + " (" + std::to_string(written_) + " bytes)");
+        if (chunkStore_) chunkStore_->addFile(path_);
+        return true;
+    }
+
+private:
+    const Server* server_;
+    std::filesystem::path path_;
+    std::string displayName_;
+    uint64_t expectedSize_;
+    std::shared_ptr<ChunkStore> chunkStore_;
+    std::ofstream out_;
+    uint64_t written_ = 0;
+    int lastReportedPct_ = 0;
+    bool finished_ = false;
+};
+
+} // namespace
+
+std::unique_ptr<UploadSink> Server::handleUpload(const std::string& filename, const uint64_t fileSize) const {
     try {
         std::string downloadDir;
         {
@@ -119,68 +358,362 @@ bool Server::handleUpload(const std::string& filename, const std::vector<uint8_t
         }
         if (downloadDir.empty()) {
             Logger::getInstance().warning("No download directory set; rejecting upload for " + filename);
-            return false;
+            return nullptr;
         }
         const std::string safeName = sanitizeFilename(filename);
-        const std::filesystem::path dest = std::filesystem::path(downloadDir) / safeName;
 
         // If file exists, append a numeric suffix
-        std::filesystem::path base = dest.stem();
-        std::filesystem::path ext = dest.extension();
-        std::filesystem::path dir = dest.parent_path();
-        std::filesystem::path candidate = dest;
-        int idx = 1;
-        while (std::filesystem::exists(candidate)) {
-            candidate = dir / (base.string() + '(' + std::to_string(idx++) + ')' + ext.string());
-        }
+        const std::filesystem::path candidate = uniqueDestination(downloadDir, safeName);
 
         // Report file info BEFORE starting transfer (so UI can show it immediately)
-        const uint64_t actualSize = fileSize > 0 ? fileSize : data.size();
-        reportIncomingFile(safeName, actualSize);
+        reportIncomingFile(safeName, fileSize);
 
         // Report start of upload
         reportIncomingProgress(safeName, 0);
 
-        std::ofstream out(candidate, std::ios::binary);
-        if (!out) {
+        auto sink = std::make_unique<FileUploadSink>(this, candidate, safeName, fileSize, chunkStore());
+        if (!sink->isOpen()) {
             Logger::getInstance().error("Failed to open file for writing: " + candidate.string());
-            return false;
+            return nullptr;
         }
+        return sink;
+    } catch (const std::exception& e) {
+        Logger::getInstance().error(std::string("Exception opening upload: ") + e.what());
+        return nullptr;
+    }
+}
 
-        // Write in chunks and report progress
-        constexpr size_t CHUNK_SIZE = 64 * 1024; // 64KB chunks
-        size_t totalSize = data.size();
-        size_t written = 0;
-        int lastReportedPct = 0;
+std::string Server::beginUploadSession(const std::string& filename, const uint64_t fileSize, const std::string& clientIP,
+                                       UploadRefusal& refusal) {
+    refusal = UploadRefusal::Unavailable;
+    std::string downloadDir;
+    {
+        std::lock_guard lock(downloadDirMutex_);
+        downloadDir = downloadDir_;
+    }
+    if (downloadDir.empty()) {
+        Logger::getInstance().warning("No download directory set; rejecting upload session for " + filename);
+        return "";
+    }
+
+    // The partial file is preallocated at the announced size, so the announcement alone must not fill the volume
+    std::error_code ec;
+    const std::filesystem::space_info space = std::filesystem::space(downloadDir, ec);
+    if (ec || space.available < UPLOAD_SPACE_RESERVE || fileSize > space.available - UPLOAD_SPACE_RESERVE) {
+        Logger::getInstance().warning("Not enough free space for upload of " + filename + " (" + std::to_string(fileSize) +
+                                      " bytes) from " + clientIP);
+        refusal = UploadRefusal::InsufficientSpace;
+        return "";
+    }
+    auto atSessionLimit = [&] {
+        const auto open = std::ranges::count_if(uploadSessions_, [&](const auto& entry) {
+            return entry.second->clientIP() == clientIP && !entry.second->isFinalized();
+        });
+        if (static_cast<size_t>(open) < MAX_UPLOAD_SESSIONS_PER_CLIENT) return false;
+        Logger::getInstance().warning("Too many unfinished upload sessions from " + clientIP + "; rejecting " + filename);
+        refusal = UploadRefusal::TooManySessions;
+        return true;
+    };
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        if (atSessionLimit()) return "";
+    }
 
-        while (written < totalSize) {
-            size_t toWrite = std::min(CHUNK_SIZE, totalSize - written);
-            out.write(reinterpret_cast<const char*>(data.data() + written), static_cast<std::streamsize>(toWrite));
+    const std::string safeName = sanitizeFilename(filename);
+    const std::string id = generateSessionId();
+    // Hidden partial file next to the destination so the final rename stays on one volume
+    const std::filesystem::path partPath = std::filesystem::path(downloadDir) / ("." + safeName + "." + id.substr(0, 8) + ".part");
+    auto file = std::make_shared<PositionalFile>();
+    if (!file->open(partPath, PositionalFile::Mode::ReadWrite)) {
+        Logger::getInstance().error("Failed to create partial file: " + partPath.string());
+        return "";
+    }
+    // Parallel chunk streams fill regions of a file that already has its final size
+    if (!file->preallocate(fileSize)) {
+        Logger::getInstance().error("Failed to reserve " + std::to_string(fileSize) + " bytes for: " + partPath.string());
+        file.reset();
+        std::filesystem::remove(partPath, ec);
+        return "";
+    }
 
-            if (!out) {
-                Logger::getInstance().error("Failed to write data to file: " + candidate.string());
-                out.close();
-                return false;
-            }
+    std::shared_ptr<UploadSession> session;
+    {
+        // Checked again: concurrent announcements from the same client may have filled the limit meanwhile
+        std::unique_lock lock(uploadSessionsMutex_);
+        if (atSessionLimit()) {
+            lock.unlock();
+            file.reset();
+            std::filesystem::remove(partPath, ec);
+            return "";
+        }
+        session = std::make_shared<UploadSession>(id, safeName, partPath, fileSize, std::move(file), clientIP);
+        uploadSessions_[id] = session;
+    }
+    refusal = UploadRefusal::None;
+    Logger::getInstance().info("Upload session " + id + " started for " + safeName + " (" + std::to_string(fileSize) + " bytes)");
 
-            written += toWrite;
+    // Nothing to wait for with an empty file
+    if (fileSize == 0) {
+        (void)commitUploadChunk(*session, 0, 0);
+    }
+    return id;
+}
 
-            // Report progress
-            int pct = totalSize == 0 ? 100 : static_cast<int>((written * 100) / totalSize);
-            if (pct != lastReportedPct) {
-                reportIncomingProgress(safeName, pct);
-                lastReportedPct = pct;
+std::unique_ptr<UploadSink> Server::openUploadChunk(const std::string& sessionId, const uint64_t offset, const uint64_t length) {
+    std::shared_ptr<UploadSession> session;
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        const auto it = uploadSessions_.find(sessionId);
+        if (it == uploadSessions_.end()) return nullptr;
+        session = it->second;
+    }
+    if (session->isFinalized() || offset > session->size() || length > session->size() - offset) {
+        return nullptr;
+    }
+    session->touch();
+
+    auto sink = std::make_unique<ChunkUploadSink>(this, session, offset, length,
+        [this](UploadSession& s, const uint64_t begin, const uint64_t end) {
+            return commitUploadChunk(s, begin, end);
+        });
+    if (!sink->isOpen()) {
+        Logger::getInstance().error("Failed to open partial file: " + session->partPath().string());
+        return nullptr;
+    }
+    return sink;
+}
+
+std::string Server::fillUploadFromChunkStore(const std::string& sessionId, const uint64_t offset,
+                                             const std::vector<ChunkStore::Chunk>& chunks) {
+    std::shared_ptr<UploadSession> session;
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        const auto it = uploadSessions_.find(sessionId);
+        if (it == uploadSessions_.end()) return "";
+        session = it->second;
+    }
+    if (offset > session->size()) return "";
+    // Each length is bounded before it is added, so the sum can't wrap past the check
+    uint64_t listed = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk.length == 0 || chunk.length > ChunkStore::MAX_CHUNK_SIZE) return "";
+        listed += chunk.length;
+        if (listed > session->size() - offset) return "";
+    }
+    session->touch();
+
+    const auto store = chunkStore();
+    std::shared_ptr<PositionalFile> file = session->file();
+    if (!store || !file) return session->toJson();
+    const auto start = std::chrono::steady_clock::now();
+
+    // Same content as the file already saved under this name: keep that instead of adding "name(1)"
+    const std::filesystem::path existing = session->partPath().parent_path() / session->name();
+    if (offset == 0 && listed == session->size() && store->isCopyOf(existing, chunks)) {
+        file.reset();
+        std::lock_guard lock(uploadSessionsMutex_);
+        if (!session->isFinalized()) {
+            (void)session->commit(0, session->size());
+            session->markFinalized(existing);
+            std::error_code ec;
+            std::filesystem::remove(session->partPath(), ec);
+            reportIncomingProgress(session->name(), 100);
+            Logger::getInstance().info("Upload of " + session->name() + " is identical to the saved file; kept " + existing.string());
+        }
+        return session->toJson();
+    }
+
+    // Copy every known chunk into place; adjacent chunks are committed as one range
+    std::vector<uint8_t> buffer(ChunkStore::MAX_CHUNK_SIZE);
+    std::vector<std::pair<uint64_t, uint64_t>> copied;
+    std::filesystem::path sourcePath;
+    PositionalFile source;
+    uint64_t position = offset;
+    uint64_t reused = 0;
+    for (const auto& chunk : chunks) {
+        const uint64_t begin = position;
+        position += chunk.length;
+        const auto location = store->find(chunk);
+        if (!location) continue;
+        if (location->path != sourcePath) {
+            source.close();
+            sourcePath = location->path;
+            if (!source.open(sourcePath, PositionalFile::Mode::Read)) {
+                sourcePath.clear();
+                continue;
             }
         }
+        // Indexed chunks are never longer than the buffer, and find() matched the length
+        const auto length = static_cast<size_t>(chunk.length);
+        if (source.readAt(location->offset, buffer.data(), length) != static_cast<int64_t>(length)) continue;
+        if (!file->writeAt(begin, buffer.data(), length)) {
+            Logger::getInstance().error("Failed to write reused chunks to: " + session->partPath().string());
+            break;
+        }
+        reused += length;
+        if (const int pct = session->addInFlight(static_cast<int64_t>(length)); pct >= 0) {
+            reportIncomingProgress(session->name(), pct);
+        }
+        if (!copied.empty() && copied.back().second == begin) {
+            copied.back().second = position;
+        } else {
+            copied.emplace_back(begin, position);
+        }
+    }
+    source.close();
+    session->addInFlight(-static_cast<int64_t>(reused));
+    file.reset();  // Don't hold the handle if the last range completes the file and it is renamed
+
+    for (const auto& [begin, end] : copied) (void)commitUploadChunk(*session, begin, end);
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    Logger::getInstance().info("Upload session " + sessionId + ": reused " + std::to_string(reused) + " of " +
+                               std::to_string(listed) + " bytes from earlier uploads in " + std::to_string(ms) + " ms");
+    return session->toJson();
+}
+
+std::string Server::getUploadBasisSignature(const std::string& sessionId) const {
+    std::shared_ptr<UploadSession> session;
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        const auto it = uploadSessions_.find(sessionId);
+        if (it == uploadSessions_.end()) return "";
+        session = it->second;
+    }
+    session->touch();
+
+    const std::filesystem::path basisPath = session->partPath().parent_path() / session->name();
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(basisPath, ec);
+    const auto modified = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(basisPath, ec);
+    PositionalFile basis;
+    if (ec || !basis.open(basisPath, PositionalFile::Mode::Read)) return "";
+
+    const auto start = std::chrono::steady_clock::now();
+    std::string signature;
+    if (!DeltaPatcher::signature(basis, size, modified.time_since_epoch().count(), signature)) {
+        Logger::getInstance().error("Failed to read " + basisPath.string() + " for its delta signature");
+        return "";
+    }
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    Logger::getInstance().info("Delta signature of " + basisPath.string() + ": " + std::to_string(signature.size()) +
+                               " bytes in " + std::to_string(ms) + " ms");
+    return signature;
+}
 
-        out.close();
+std::unique_ptr<UploadSink> Server::openUploadDelta(const std::string& sessionId, const int64_t basisModified,
+                                                    const uint64_t basisSize, const ChunkStore::Digest& digest,
+                                                    const bool replace) {
+    std::shared_ptr<UploadSession> session;
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        const auto it = uploadSessions_.find(sessionId);
+        if (it == uploadSessions_.end()) return nullptr;
+        session = it->second;
+    }
+    if (session->isFinalized()) return nullptr;
+    session->touch();
+
+    // The client matched its blocks against this exact version of the basis
+    const std::filesystem::path basisPath = session->partPath().parent_path() / session->name();
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(basisPath, ec);
+    const auto modified = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(basisPath, ec);
+    if (ec || size != basisSize || modified.time_since_epoch().count() != basisModified) {
+        Logger::getInstance().warning("Delta upload for " + session->name() + " refused: saved file changed or missing");
+        return nullptr;
+    }
 
-        Logger::getInstance().info("Saved uploaded file: " + candidate.string());
-        return true;
-    } catch (const std::exception& e) {
-        Logger::getInstance().error(std::string("Exception saving upload: ") + e.what());
+    auto basis = std::make_shared<PositionalFile>();
+    std::shared_ptr<PositionalFile> file = session->file();
+    if (!basis->open(basisPath, PositionalFile::Mode::Read) || !file) {
+        Logger::getInstance().error("Failed to open files for delta upload of " + session->name());
+        return nullptr;
+    }
+    return std::make_unique<DeltaUploadSink>(this, session,
+        std::make_unique<DeltaPatcher>(std::move(basis), basisSize, std::move(file), session->size()),
+        digest, replace,
+        [this](UploadSession& s, const uint64_t begin, const uint64_t end) {
+            return commitUploadChunk(s, begin, end);
+        });
+}
+
+std::string Server::getUploadSessionJson(const std::string& sessionId) const {
+    std::shared_ptr<UploadSession> session;
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        const auto it = uploadSessions_.find(sessionId);
+        if (it == uploadSessions_.end()) return "";
+        session = it->second;
+    }
+    session->touch();
+    return session->toJson();
+}
+
+bool Server::cancelUploadSession(const std::string& sessionId) {
+    std::shared_ptr<UploadSession> session;
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        const auto it = uploadSessions_.find(sessionId);
+        if (it == uploadSessions_.end()) return false;
+        session = it->second;
+        uploadSessions_.erase(it);
+    }
+    if (!session->isFinalized()) {
+        std::error_code ec;
+        std::filesystem::remove(session->partPath(), ec);
+        Logger::getInstance().info("Upload session " + sessionId + " cancelled for " + session->name());
+    }
+    return true;
+}
+
+bool Server::commitUploadChunk(UploadSession& session, const uint64_t begin, const uint64_t end) {
+    // Progress was already reported as the chunk's bytes were written
+    (void)session.commit(begin, end);
+    if (!session.isFilled()) return true;
+
+    // Several chunks can complete at once; only one of them moves the file
+    std::lock_guard lock(uploadSessionsMutex_);
+    return session.isFinalized() || finalizeUploadSession(session);
+}
+
+bool Server::finalizeUploadSession(UploadSession& session) const {
+    std::error_code ec;
+    const std::filesystem::path dir = session.partPath().parent_path();
+    const bool replace = session.replacesExisting();
+    const std::filesystem::path dest = replace ? dir / session.name() : uniqueDestination(dir, session.name());
+    std::filesystem::rename(session.partPath(), dest, ec);
+    if (ec) {
+        Logger::getInstance().error("Failed to move completed upload into place: " + dest.string() + " (" + ec.message() + ")");
         return false;
     }
+    session.markFinalized(dest);
+    reportIncomingProgress(session.name(), 100);
+    Logger::getInstance().info(std::string(replace ? "Updated" : "Saved") + " uploaded file: " + dest.string() +
+                               " (" + std::to_string(session.size()) + " bytes)");
+    if (const auto store = chunkStore()) store->addFile(dest);
+    return true;
+}
+
+void Server::expireUploadSessions() {
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<UploadSession>> expired;
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        for (auto it = uploadSessions_.begin(); it != uploadSessions_.end();) {
+            if (now - it->second->lastActivity() > UPLOAD_SESSION_TIMEOUT) {
+                expired.push_back(it->second);
+                it = uploadSessions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const auto& session : expired) {
+        if (session->isFinalized()) continue;
+        std::error_code ec;
+        std::filesystem::remove(session->partPath(), ec);
+        Logger::getInstance().warning("Upload session " + session->id() + " expired, removed partial file for " + session->name());
+    }
 }
 
 void Server::sendFilesToClient(const std::vector<std::string>& filePaths) {
@@ -190,18 +723,56 @@ void Server::sendFilesToClient(const std::vector<std::string>& filePaths) {
         return;
     }
 
+    // Capture each file's metadata once, outside the lock; listing the queue never stats again
+    std::vector<PendingFile> records;
+    records.reserve(filePaths.size());
+    for (const auto& path : filePaths) {
+        PendingFile record;
+        if (std::error_code ec; std::filesystem::is_directory(path, ec)) {
+            // Queued right away; its contents are totalled in the background
+            record.path = path;
+            std::filesystem::path folderPath = std::filesystem::path(path).lexically_normal();
+            if (!folderPath.has_filename()) folderPath = folderPath.parent_path();  // "dir/"
+            record.name = folderPath.filename().string();
+            record.contentType = "application/x-tar";
+            record.modified = std::filesystem::last_write_time(path, ec);
+            record.folder = true;
+            record.scanning = true;
+            records.push_back(std::move(record));
+            continue;
+        }
+        if (!statPendingFile(path, record.size, record.modified)) {
+            Logger::getInstance().warning("Not queueing unreadable file: " + path);
+            continue;
+        }
+        record.path = path;
+        record.name = std::filesystem::path(path).filename().string();
+        record.contentType = MimeTypes::fromPath(record.name);
+        records.push_back(std::move(record));
+    }
+
     // Queue files for HTTP-based download
+    bool queued = false;
+    std::vector<std::pair<uint64_t, std::string>> folders;
     {
         std::lock_guard lock(pendingFilesMutex_);
-        for (const auto& path : filePaths) {
-            // Only add if not already in queue
-            if (std::find(pendingFiles_.begin(), pendingFiles_.end(), path) == pendingFiles_.end()) {
-                pendingFiles_.push_back(path);
-                Logger::getInstance().info("Queued file for download: " + path);
+        for (auto& record : records) {
+            // Files already in the queue keep their transfer ID
+            const std::string path = record.path;
+            const bool folder = record.folder;
+            if (const uint64_t id = pendingFiles_.push(std::move(record))) {
+                Logger::getInstance().info(std::string(folder ? "Queued folder" : "Queued file") + " for download: " + path +
+                                           " (transfer " + std::to_string(id) + ")");
+                if (folder) folders.emplace_back(id, path);
+                queued = true;
             }
         }
+        if (queued) pendingFilesGeneration_.fetch_add(1, std::memory_order_release);
     }
 
+    if (queued && httpServer_) httpServer_->notifyPendingFilesChanged();
+    for (const auto& [id, path] : folders) startFolderScan(id, path);
+
     // Report initial progress for UI
     for (const auto& path : filePaths) {
         reportProgress(path, 0);
@@ -215,6 +786,7 @@ void Server::reportProgress(const std::string& path, const int pct) const {
         cb = outgoingProgressCb_;
     }
     if (cb) cb(path, pct);
+    if (httpServer_) httpServer_->notifyProgress("outgoing", std::filesystem::path(path).filename().string(), pct);
 }
 
 void Server::reportOutgoingProgress(const std::string& path, const int pct) const {
@@ -233,6 +805,7 @@ void Server::reportIncomingProgress(const std::string& filename, const int pct)
         cb = incomingProgressCb_;
     }
     if (cb) cb(filename, pct);
+    if (httpServer_) httpServer_->notifyProgress("incoming", filename, pct);
 }
 
 void Server::setIncomingFileCallback(std::function<void(const std::string&, uint64_t)> cb) {
@@ -258,18 +831,168 @@ void Server::announceIncomingFile(const std::string& filename, const uint64_t fi
     reportIncomingProgress(safeName, 0);  // Set initial progress to 0%
 }
 
-std::vector<std::string> Server::getPendingFiles() const {
+std::vector<PendingFile> Server::getPendingFiles() const {
     std::lock_guard lock(pendingFilesMutex_);
-    return pendingFiles_;
+    std::vector<PendingFile> files;
+    files.reserve(pendingFiles_.size());
+    for (const auto& entry : pendingFiles_) files.push_back(entry.file);
+    return files;
 }
 
-void Server::removePendingFile(const std::string& filePath) {
+std::optional<PendingFile> Server::getPendingFile(const uint64_t id) const {
     std::lock_guard lock(pendingFilesMutex_);
-    pendingFiles_.erase(
-        std::remove(pendingFiles_.begin(), pendingFiles_.end(), filePath),
-        pendingFiles_.end()
-    );
-    Logger::getInstance().debug("Removed pending file: " + filePath);
+    const auto* entry = pendingFiles_.find(id);
+    if (!entry) return std::nullopt;
+    return entry->file;
+}
+
+void Server::updatePendingFile(const uint64_t id, const uint64_t size, const std::filesystem::file_time_type modified) {
+    std::string path;
+    {
+        std::lock_guard lock(pendingFilesMutex_);
+        auto* entry = pendingFiles_.find(id);
+        if (!entry || (entry->file.size == size && entry->file.modified == modified)) return;
+        entry->file.size = size;
+        entry->file.modified = modified;
+        // Bytes delivered before the change belong to another version of the file
+        entry->delivered = {};
+        path = entry->file.path;
+        pendingFilesGeneration_.fetch_add(1, std::memory_order_release);
+    }
+    Logger::getInstance().debug("Pending file changed on disk: " + path);
+    if (httpServer_) httpServer_->notifyPendingFilesChanged();
+}
+
+void Server::updatePendingFolder(const uint64_t id, const uint64_t files, const uint64_t bytes, const bool finished) {
+    {
+        std::lock_guard lock(pendingFilesMutex_);
+        auto* entry = pendingFiles_.find(id);
+        if (!entry) return;
+        entry->file.size = bytes;
+        entry->file.fileCount = files;
+        entry->file.scanning = !finished;
+        pendingFilesGeneration_.fetch_add(1, std::memory_order_release);
+    }
+    if (finished) {
+        Logger::getInstance().debug("Folder scan of transfer " + std::to_string(id) + " complete: " + std::to_string(files) +
+                                    " files, " + std::to_string(bytes) + " bytes");
+    }
+    if (httpServer_) httpServer_->notifyPendingFilesChanged();
+}
+
+void Server::startFolderScan(const uint64_t id, const std::string& path) {
+    auto scan = std::make_unique<DirectoryWalker>(std::filesystem::path(path), false,
+        [this, id](const uint64_t files, const uint64_t bytes, const bool finished) {
+            updatePendingFolder(id, files, bytes, finished);
+        });
+    std::lock_guard lock(folderScansMutex_);
+    folderScans_[id] = std::move(scan);
+}
+
+// Drops finished scans and those of folders no longer queued (or all of them)
+void Server::reapFolderScans(const bool all) {
+    std::vector<std::unique_ptr<DirectoryWalker>> done;
+    {
+        std::lock_guard lock(folderScansMutex_);
+        for (auto it = folderScans_.begin(); it != folderScans_.end();) {
+            bool queued;
+            {
+                std::lock_guard pendingLock(pendingFilesMutex_);
+                queued = pendingFiles_.find(it->first) != nullptr;
+            }
+            if (all || !queued || it->second->finished()) {
+                done.push_back(std::move(it->second));
+                it = folderScans_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // Joining a walker waits for its progress callback, which takes pendingFilesMutex_: no locks held here
+    done.clear();
+}
+
+void Server::revalidatePendingFiles() {
+    std::vector<std::tuple<uint64_t, std::string, bool>> files;
+    {
+        std::lock_guard lock(pendingFilesMutex_);
+        files.reserve(pendingFiles_.size());
+        for (const auto& entry : pendingFiles_) files.emplace_back(entry.file.id, entry.file.path, entry.file.folder);
+    }
+    // Stat without holding the lock; downloads and listings go on meanwhile
+    for (const auto& [id, path, folder] : files) {
+        uint64_t size;
+        std::filesystem::file_time_type modified;
+        if (folder) {
+            std::error_code ec;
+            if (!std::filesystem::is_directory(path, ec)) {
+                Logger::getInstance().warning("Queued folder is gone, removing it: " + path);
+                removePendingFile(id);
+            }
+        } else if (statPendingFile(path, size, modified)) {
+            updatePendingFile(id, size, modified);
+        } else {
+            Logger::getInstance().warning("Queued file is gone, removing it: " + path);
+            removePendingFile(id);
+        }
+    }
+}
+
+void Server::removePendingFile(const uint64_t id) {
+    {
+        std::lock_guard lock(pendingFilesMutex_);
+        if (!pendingFiles_.erase(id)) return;
+        pendingFilesGeneration_.fetch_add(1, std::memory_order_release);
+    }
+    Logger::getInstance().debug("Removed pending file: transfer " + std::to_string(id));
+    if (httpServer_) httpServer_->notifyPendingFilesChanged();
+}
+
+bool Server::beginPendingFileDownload(const uint64_t id) {
+    {
+        std::lock_guard lock(pendingFilesMutex_);
+        auto* entry = pendingFiles_.find(id);
+        if (!entry) return false;
+        const bool changed = entry->activeDownloads++ == 0 && entry->file.state != TransferState::InFlight;
+        entry->file.state = TransferState::InFlight;
+        if (!changed) return true;
+        pendingFilesGeneration_.fetch_add(1, std::memory_order_release);
+    }
+    if (httpServer_) httpServer_->notifyPendingFilesChanged();
+    return true;
+}
+
+TransferState Server::endPendingFileDownload(const uint64_t id, const uint64_t begin, const uint64_t end,
+                                             const bool interrupted, int& deliveredPct) {
+    TransferState state;
+    {
+        std::lock_guard lock(pendingFilesMutex_);
+        auto* entry = pendingFiles_.find(id);
+        if (!entry) {
+            deliveredPct = 100;
+            return TransferState::Done;  // Already completed by another request
+        }
+        if (entry->activeDownloads > 0) --entry->activeDownloads;
+        const uint64_t fileSize = entry->file.size;
+        entry->delivered.add(begin, end);
+        // A folder is streamed whole, without ranges: only a complete download delivers it
+        if (entry->file.folder ? !interrupted : entry->delivered.covers(0, fileSize)) {
+            state = TransferState::Done;
+            deliveredPct = 100;
+            pendingFiles_.erase(id);
+        } else {
+            // Other downloads of the file may still fill in the rest
+            state = entry->activeDownloads > 0 ? TransferState::InFlight
+                  : interrupted ? TransferState::Failed : TransferState::Queued;
+            deliveredPct = entry->file.folder ? 0 : static_cast<int>(entry->delivered.total() * 100 / fileSize);
+            if (state == entry->file.state) return state;
+            entry->file.state = state;
+        }
+        pendingFilesGeneration_.fetch_add(1, std::memory_order_release);
+    }
+    if (state == TransferState::Done) Logger::getInstance().debug("Removed pending file: transfer " + std::to_string(id));
+    if (httpServer_) httpServer_->notifyPendingFilesChanged();
+    return state;
 }
 
 bool Server::hasConnectedClients() const {
@@ -289,6 +1012,7 @@ void Server::stop() {
     stopCv_.notify_all();
 
     Logger::getInstance().info("Server stop() reached");
+    reapFolderScans(true);
     httpServer_->stop();
     NetworkUtils::cleanup();
 
@@ -296,6 +1020,17 @@ void Server::stop() {
     if (acceptThread_.joinable()) acceptThread_.join();
     if (cleanupThread_.joinable()) cleanupThread_.join();
 
+    // Unfinished chunked uploads can't be resumed after a restart
+    {
+        std::lock_guard lock(uploadSessionsMutex_);
+        for (const auto& [id, session] : uploadSessions_) {
+            if (session->isFinalized()) continue;
+            std::error_code ec;
+            std::filesystem::remove(session->partPath(), ec);
+        }
+        uploadSessions_.clear();
+    }
+
     Logger::getInstance().info("Server stopped");
 }
 
@@ -323,38 +1058,60 @@ std::vector<std::string> Server::getConnectedDevices() const {
 }
 
 void Server::trackHTTPConnection(const std::string& clientIP) {
-    std::lock_guard lock(ipMutex_);
+    bool isNewIP;
+    bool listChanged;
+    {
+        std::lock_guard lock(ipMutex_);
 
-    // Update the last activity timestamp for this client
-    const auto now = std::chrono::steady_clock::now();
-    const bool isNewIP = !httpClientActivity_.contains(clientIP);
-    httpClientActivity_[clientIP] = now;
+        // Update the last activity timestamp for this client
+        const auto now = std::chrono::steady_clock::now();
+        isNewIP = !httpClientActivity_.contains(clientIP);
+        httpClientActivity_[clientIP] = now;
 
-    // Add to connected IPs set
-    connectedIPs_.insert(clientIP);
+        // Add to connected IPs set
+        listChanged = connectedIPs_.insert(clientIP).second;
+        if (listChanged) connectedDevicesGeneration_.fetch_add(1, std::memory_order_release);
+    }
 
     if (isNewIP) {
         Logger::getInstance().info("[HTTP CLIENT] " + clientIP + " connected");
     }
+    // Outside the lock: building the device list locks ipMutex_ again
+    if (listChanged && httpServer_) httpServer_->notifyDevicesChanged();
 }
 
 void Server::cleanupInactiveHTTPClients() {
+    auto nextRevalidation = std::chrono::steady_clock::now() + PENDING_REVALIDATE_INTERVAL;
     while (running_) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
 
-        std::lock_guard lock(ipMutex_);
-        auto now = std::chrono::steady_clock::now();
-
-        // Remove clients that haven't had activity in the last 30 seconds
-        for (auto it = httpClientActivity_.begin(); it != httpClientActivity_.end();) {
-            if (const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count(); elapsed > 30) {
-                Logger::getInstance().info("[HTTP CLIENT] " + it->first + " disconnected (timeout)");
-                connectedIPs_.erase(it->first);
-                it = httpClientActivity_.erase(it);
-            } else {
-                ++it;
+        expireUploadSessions();
+        reapFolderScans(false);
+
+        if (std::chrono::steady_clock::now() >= nextRevalidation) {
+            revalidatePendingFiles();
+            nextRevalidation = std::chrono::steady_clock::now() + PENDING_REVALIDATE_INTERVAL;
+        }
+
+        bool removed = false;
+        {
+            std::lock_guard lock(ipMutex_);
+            auto now = std::chrono::steady_clock::now();
+
+            // Remove clients that haven't had activity in the last 30 seconds
+            for (auto it = httpClientActivity_.begin(); it != httpClientActivity_.end();) {
+                if (const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count(); elapsed > 30) {
+                    Logger::getInstance().info("[HTTP CLIENT] " + it->first + " disconnected (timeout)");
+                    connectedIPs_.erase(it->first);
+                    it = httpClientActivity_.erase(it);
+                    removed = true;
+                } else {
+                    ++it;
+                }
             }
+            if (removed) connectedDevicesGeneration_.fetch_add(1, std::memory_order_release);
         }
+        if (removed && httpServer_) httpServer_->notifyDevicesChanged();
     }
 }
 
@@ -406,10 +1163,12 @@ void Server::acceptConnections() {
                 {
                     std::lock_guard<std::mutex> lock(ipMutex_);
                     isNewIP = connectedIPs_.insert(clientAddr).second;
+                    if (isNewIP) connectedDevicesGeneration_.fetch_add(1, std::memory_order_release);
                 }
 
                 // Only log when a NEW external device connects
                 if (isNewIP) {
+                    if (httpServer_) httpServer_->notifyDevicesChanged();
                     if (useAuth_) {
                         Logger::getInstance().info("[CONNECTED] " + clientAddr + " (authentication required)");
                     } else {
@@ -48,6 +48,7 @@ static QWidget* makeSectionTitle(const QString& title, QWidget* parent) {
 
     static QString iconForPath(const QString& filePath) {
     QFileInfo fi(filePath);
+    if (fi.isDir()) return ":/icons/folder.svg";
     const QString ext = fi.suffix().toLower();
 
     // Quick common extensions first (fast + predictable)
@@ -137,8 +138,11 @@ public:
         size_->setObjectName("fileSize");
 
         // Use known size if provided, otherwise try to get from file info
+        // Folders are sized by the server's background scan; walking them here would block the UI
         if (knownSize >= 0) {
             size_->setText(humanSize(knownSize));
+        } else if (fi.isDir()) {
+            size_->setText("Folder");
         } else if (fi.exists() && fi.isFile()) {
             size_->setText(humanSize(fi.size()));
         } else {
@@ -357,7 +361,7 @@ ServerWidget::ServerWidget(QWidget* parent) : QWidget(parent) {
     auto* dzL = new QVBoxLayout(dropZone);
     dzL->setAlignment(Qt::AlignCenter);
 
-    dropHintLabel_ = new QLabel("Drag and Drop Files", dropZone);
+    dropHintLabel_ = new QLabel("Drag and Drop Files or Folders", dropZone);
     dropHintLabel_->setObjectName("dropText");
     dropHintLabel_->setAlignment(Qt::AlignCenter);
     dzL->addWidget(dropHintLabel_);
@@ -610,8 +614,9 @@ void ServerWidget::setReceivedProgress(const QString& fileIdOrName, const int pe
     for (const QUrl& url : urls) {
         if (url.isLocalFile()) {
             const QString path = url.toLocalFile();
+            // Folders are sent whole, as one tar stream
             QFileInfo fi(path);
-            if (fi.exists() && fi.isFile())
+            if (fi.exists() && (fi.isFile() || fi.isDir()))
                 files << path;
         }
     }
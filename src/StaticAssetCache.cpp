@@ -0,0 +1,189 @@
+#include "StaticAssetCache.h"
+#include "DeflateEncoder.h"
+#include "EmbeddedAssets.h"
+#include "Hashing.h"
+#include "Logger.h"
+#include "MimeTypes.h"
+#include "NetworkUtils.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace blade {
+
+namespace {
+
+constexpr auto RESCAN_INTERVAL = std::chrono::seconds(2);  // How stale the snapshot may get
+constexpr uint64_t MAX_ASSET_SIZE = 16 * 1024 * 1024;       // Larger files are not web UI assets
+
+bool isCompressible(const std::string& contentType) {
+    return contentType.starts_with("text/") ||
+           contentType == "application/javascript" ||
+           contentType == "application/json" ||
+           contentType == "image/svg+xml";
+}
+
+std::string quotedHash(const std::string_view data) {
+    std::ostringstream out;
+    out << '"' << std::hex << std::setw(16) << std::setfill('0') << Hashing::fnv1a64(data.data(), data.size()) << '"';
+    return out.str();
+}
+
+// Attach a gzip variant when compression saves a meaningful amount
+void addGzipVariant(StaticAsset& asset) {
+    if (!isCompressible(asset.contentType) || asset.body.empty()) return;
+    std::string gz = DeflateEncoder::compress(reinterpret_cast<const uint8_t*>(asset.body.data()),
+                                              asset.body.size(), DeflateEncoder::Format::Gzip, 9);
+    if (gz.size() < asset.body.size() - asset.body.size() / 10) {
+        asset.gzipBody = std::move(gz);
+        asset.gzipEtag = asset.etag;
+        asset.gzipEtag.insert(asset.gzipEtag.size() - 1, "-gz");
+    }
+}
+
+// Response headers that depend only on the asset, built once instead of on every request
+void buildHeaders(StaticAsset& asset) {
+    const bool vary = !asset.gzipBody.empty();
+    const auto block = [&](const std::string_view body, const std::string& etag, const bool gzip) {
+        std::string headers = "Content-Type: " + asset.contentType + "\r\n";
+        headers += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        headers += "Last-Modified: " + asset.lastModified + "\r\n";
+        headers += "ETag: " + etag + "\r\n";
+        if (gzip) headers += "Content-Encoding: gzip\r\n";
+        if (vary) headers += "Vary: Accept-Encoding\r\n";
+        return headers;
+    };
+    asset.headers = block(asset.body, asset.etag, false);
+    if (vary) asset.gzipHeaders = block(asset.gzipBody, asset.gzipEtag, true);
+}
+
+} // namespace
+
+StaticAssetCache::StaticAssetCache(std::filesystem::path root)
+    : root_(std::move(root)), assets_(std::make_shared<const AssetMap>())
+{
+    rescan(true);
+}
+
+StaticAssetCache::StaticAssetCache(const std::span<const EmbeddedAsset> bundle) {
+    auto assets = std::make_shared<AssetMap>();
+    for (const auto& embedded : bundle) {
+        auto asset = std::make_shared<StaticAsset>();
+        asset->contentType = embedded.contentType;
+        asset->body = std::string_view(reinterpret_cast<const char*>(embedded.data), embedded.size);
+        asset->etag = embedded.etag;
+        asset->lastModified = embedded.lastModified;
+        asset->size = embedded.size;
+        addGzipVariant(*asset);
+        buildHeaders(*asset);
+        assets->emplace(std::string(embedded.path), std::move(asset));
+    }
+    assets_ = std::move(assets);
+    Logger::getInstance().debug("Static asset cache serving " + std::to_string(assets_->size()) + " embedded files");
+}
+
+std::shared_ptr<const StaticAsset> StaticAssetCache::find(const std::string& urlPath) {
+    std::shared_ptr<const AssetMap> assets;
+    bool stale;
+    {
+        std::lock_guard lock(snapshotMutex_);
+        assets = assets_;
+        stale = !root_.empty() && std::chrono::steady_clock::now() - lastScan_ >= RESCAN_INTERVAL;
+    }
+    if (stale) {
+        rescan(false);
+        std::lock_guard lock(snapshotMutex_);
+        assets = assets_;
+    }
+    const auto it = assets->find(urlPath);
+    return it == assets->end() ? nullptr : it->second;
+}
+
+void StaticAssetCache::reload() {
+    if (root_.empty()) return;
+    rescan(true);
+}
+
+void StaticAssetCache::rescan(const bool force) {
+    std::unique_lock scanLock(scanMutex_, std::defer_lock);
+    if (force) {
+        scanLock.lock();
+    } else if (!scanLock.try_lock()) {
+        return; // Another thread is already rescanning
+    }
+
+    std::shared_ptr<const AssetMap> current;
+    {
+        std::lock_guard lock(snapshotMutex_);
+        if (!force && std::chrono::steady_clock::now() - lastScan_ < RESCAN_INTERVAL) return;
+        current = assets_;
+    }
+
+    // Only files whose size or modification time changed are read again
+    auto next = std::make_shared<AssetMap>();
+    bool changed = false;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(root_, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        const auto modified = it->last_write_time(ec);
+        const uint64_t size = it->file_size(ec);
+        if (ec) continue;
+
+        const std::string key = "/" + std::filesystem::relative(it->path(), root_, ec).generic_string();
+        if (ec) continue;
+        if (const auto old = current->find(key); !force && old != current->end() &&
+            old->second->modified == modified && old->second->size == size) {
+            next->emplace(key, old->second);
+            continue;
+        }
+        if (auto asset = loadAsset(it->path(), modified, size)) {
+            next->emplace(key, std::move(asset));
+            changed = true;
+        }
+    }
+    if (ec) {
+        Logger::getInstance().warning("Failed to scan web root " + root_.string() + ": " + ec.message());
+    }
+    changed = changed || next->size() != current->size();
+
+    std::lock_guard lock(snapshotMutex_);
+    if (changed || force) {
+        assets_ = std::move(next);
+        Logger::getInstance().debug("Static asset cache loaded " + std::to_string(assets_->size()) + " files from " + root_.string());
+    }
+    lastScan_ = std::chrono::steady_clock::now();
+}
+
+std::shared_ptr<const StaticAsset> StaticAssetCache::loadAsset(const std::filesystem::path& path,
+                                                                const std::filesystem::file_time_type modified,
+                                                                const uint64_t size) const {
+    if (size > MAX_ASSET_SIZE) {
+        Logger::getInstance().warning("Not caching oversized web asset: " + path.string());
+        return nullptr;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        Logger::getInstance().debug("Failed to open file: " + path.string());
+        return nullptr;
+    }
+
+    auto asset = std::make_shared<StaticAsset>();
+    asset->storage.resize(size);
+    file.read(asset->storage.data(), static_cast<std::streamsize>(size));
+    asset->storage.resize(static_cast<size_t>(file.gcount()));
+    asset->body = asset->storage;
+
+    asset->contentType = MimeTypes::fromPath(path.string());
+    asset->etag = quotedHash(asset->body);
+    asset->lastModified = NetworkUtils::formatHttpDate(modified);
+    asset->modified = modified;
+    asset->size = size;
+    addGzipVariant(*asset);
+    buildHeaders(*asset);
+    return asset;
+}
+
+} // namespace blade
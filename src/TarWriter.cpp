@@ -0,0 +1,116 @@
+#include "TarWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+
+namespace blade {
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 512;
+constexpr size_t NAME_FIELD_SIZE = 100;
+constexpr uint64_t MAX_OCTAL_SIZE = 077777777777;  // Largest size the 12-byte ustar field holds
+constexpr char TYPE_FILE = '0';
+constexpr char TYPE_DIRECTORY = '5';
+constexpr char TYPE_PAX = 'x';
+constexpr std::string_view PAX_HEADER_NAME = "././@PaxHeader";
+
+// Writes value as zero-padded octal digits filling all but the last byte of the field, which stays NUL
+void putOctal(char* field, const size_t width, uint64_t value) {
+    for (size_t i = width - 1; i-- > 0;) {
+        field[i] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+    }
+    field[width - 1] = '\0';
+}
+
+void appendHeader(std::string& out, const std::string_view name, const uint64_t size, const int64_t mtime,
+                  const char type) {
+    std::array<char, BLOCK_SIZE> header{};
+    std::memcpy(header.data(), name.data(), std::min(name.size(), NAME_FIELD_SIZE));
+    putOctal(&header[100], 8, type == TYPE_DIRECTORY ? 0755 : 0644);
+    putOctal(&header[108], 8, 0);  // uid
+    putOctal(&header[116], 8, 0);  // gid
+    putOctal(&header[124], 12, std::min(size, MAX_OCTAL_SIZE));
+    putOctal(&header[136], 12, static_cast<uint64_t>(std::max<int64_t>(mtime, 0)));
+    header[156] = type;
+    std::memcpy(&header[257], "ustar", 6);
+    std::memcpy(&header[263], "00", 2);
+
+    // Checksum over the header with its own field read as spaces
+    std::memset(&header[148], ' ', 8);
+    unsigned checksum = 0;
+    for (const char c : header) checksum += static_cast<unsigned char>(c);
+    putOctal(&header[148], 7, checksum);
+    header[155] = ' ';
+
+    out.append(header.data(), header.size());
+}
+
+// A pax record is "<length> <key>=<value>\n", where length counts the whole record including itself
+void appendPaxRecord(std::string& records, const std::string_view key, const std::string_view value) {
+    const size_t base = key.size() + value.size() + 3;
+    size_t length = base;
+    while (base + std::to_string(length).size() != length) length = base + std::to_string(length).size();
+    records += std::to_string(length);
+    records += ' ';
+    records += key;
+    records += '=';
+    records += value;
+    records += '\n';
+}
+
+size_t paddingFor(const uint64_t size) {
+    return static_cast<size_t>((BLOCK_SIZE - size % BLOCK_SIZE) % BLOCK_SIZE);
+}
+
+} // namespace
+
+void TarWriter::beginEntry(const std::string_view name, const std::filesystem::file_time_type modified,
+                           const uint64_t size, const bool directory, std::string& out) {
+    const size_t start = out.size();
+    std::string path(name);
+    if (directory && (path.empty() || path.back() != '/')) path += '/';
+    size_ = directory ? 0 : size;
+    written_ = 0;
+
+    const int64_t mtime = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::file_clock::to_sys(modified).time_since_epoch()).count();
+
+    const bool longName = path.size() > NAME_FIELD_SIZE;
+    const bool plainAscii = std::none_of(path.begin(), path.end(), [](const char c) { return c & 0x80; });
+    const bool largeSize = size_ > MAX_OCTAL_SIZE;
+    if (longName || !plainAscii || largeSize) {
+        std::string records;
+        if (longName || !plainAscii) appendPaxRecord(records, "path", path);
+        if (largeSize) appendPaxRecord(records, "size", std::to_string(size_));
+        appendHeader(out, PAX_HEADER_NAME, records.size(), mtime, TYPE_PAX);
+        out += records;
+        out.append(paddingFor(records.size()), '\0');
+    }
+
+    appendHeader(out, path, size_, mtime, directory ? TYPE_DIRECTORY : TYPE_FILE);
+    offset_ += out.size() - start;
+}
+
+void TarWriter::write(const uint8_t* data, const size_t len, std::string& out) {
+    const auto n = static_cast<size_t>(std::min<uint64_t>(len, size_ - written_));
+    out.append(reinterpret_cast<const char*>(data), n);
+    written_ += n;
+    offset_ += n;
+}
+
+void TarWriter::endEntry(std::string& out) {
+    const size_t padding = paddingFor(size_);
+    out.append(padding, '\0');
+    offset_ += padding;
+}
+
+void TarWriter::finish(std::string& out) {
+    out.append(2 * BLOCK_SIZE, '\0');
+    offset_ += 2 * BLOCK_SIZE;
+}
+
+} // namespace blade
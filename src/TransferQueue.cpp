@@ -0,0 +1,54 @@
+#include "TransferQueue.h"
+
+#include <chrono>
+
+namespace blade {
+
+std::string_view toString(const TransferState state) {
+    switch (state) {
+    case TransferState::Queued:   return "queued";
+    case TransferState::InFlight: return "in-flight";
+    case TransferState::Done:     return "done";
+    case TransferState::Failed:   return "failed";
+    }
+    return "queued";
+}
+
+TransferQueue::TransferQueue() {
+    // Seconds since the epoch in the high bits: 2^31 seconds << 20 stays below 2^53
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    nextId_ = (static_cast<uint64_t>(seconds) & 0x7FFFFFFF) << 20 | 1;
+}
+
+uint64_t TransferQueue::push(PendingFile file) {
+    if (byPath_.contains(file.path)) return 0;
+    file.id = nextId_++;
+    file.state = TransferState::Queued;
+    const uint64_t id = file.id;
+    byPath_.emplace(file.path, id);
+    entries_.push_back({std::move(file), {}, 0});
+    byId_.emplace(id, std::prev(entries_.end()));
+    return id;
+}
+
+TransferQueue::Entry* TransferQueue::find(const uint64_t id) {
+    const auto it = byId_.find(id);
+    return it == byId_.end() ? nullptr : &*it->second;
+}
+
+const TransferQueue::Entry* TransferQueue::find(const uint64_t id) const {
+    const auto it = byId_.find(id);
+    return it == byId_.end() ? nullptr : &*it->second;
+}
+
+bool TransferQueue::erase(const uint64_t id) {
+    const auto it = byId_.find(id);
+    if (it == byId_.end()) return false;
+    byPath_.erase(it->second->file.path);
+    entries_.erase(it->second);
+    byId_.erase(it);
+    return true;
+}
+
+} // namespace blade
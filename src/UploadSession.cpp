@@ -0,0 +1,99 @@
+#include "UploadSession.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace blade {
+
+UploadSession::UploadSession(std::string id, std::string name, std::filesystem::path partPath, const uint64_t size,
+                             std::shared_ptr<PositionalFile> file, std::string clientIP)
+    : id_(std::move(id)), name_(std::move(name)), partPath_(std::move(partPath)), size_(size),
+      clientIP_(std::move(clientIP)), file_(std::move(file)), lastActivity_(std::chrono::steady_clock::now())
+{
+}
+
+std::shared_ptr<PositionalFile> UploadSession::file() const {
+    std::lock_guard lock(mutex_);
+    return file_;
+}
+
+int UploadSession::addInFlight(const int64_t delta) {
+    std::lock_guard lock(mutex_);
+    if (delta < 0) {
+        inFlight_ -= std::min<uint64_t>(inFlight_, static_cast<uint64_t>(-delta));
+        return -1;
+    }
+    inFlight_ += static_cast<uint64_t>(delta);
+    lastActivity_ = std::chrono::steady_clock::now();
+    if (size_ == 0) return -1;
+    // Retransmitted ranges can push the sum past the size, and only 100% means saved
+    const uint64_t done = std::min(size_, committed_.total() + inFlight_);
+    const int pct = static_cast<int>(std::min<uint64_t>(99, done * 100 / size_));
+    if (pct <= lastReportedPct_) return -1;
+    lastReportedPct_ = pct;
+    return pct;
+}
+
+uint64_t UploadSession::commit(const uint64_t begin, const uint64_t end) {
+    std::lock_guard lock(mutex_);
+    committed_.add(begin, end);
+    lastActivity_ = std::chrono::steady_clock::now();
+    return committed_.total();
+}
+
+bool UploadSession::isFilled() const {
+    std::lock_guard lock(mutex_);
+    return committed_.covers(0, size_);
+}
+
+void UploadSession::setReplaceExisting() {
+    std::lock_guard lock(mutex_);
+    replaceExisting_ = true;
+}
+
+bool UploadSession::replacesExisting() const {
+    std::lock_guard lock(mutex_);
+    return replaceExisting_;
+}
+
+void UploadSession::markFinalized(const std::filesystem::path& finalPath) {
+    std::lock_guard lock(mutex_);
+    finalPath_ = finalPath;
+    finalized_ = true;
+    file_.reset();
+}
+
+bool UploadSession::isFinalized() const {
+    std::lock_guard lock(mutex_);
+    return finalized_;
+}
+
+std::chrono::steady_clock::time_point UploadSession::lastActivity() const {
+    std::lock_guard lock(mutex_);
+    return lastActivity_;
+}
+
+void UploadSession::touch() {
+    std::lock_guard lock(mutex_);
+    lastActivity_ = std::chrono::steady_clock::now();
+}
+
+std::string UploadSession::toJson() const {
+    std::lock_guard lock(mutex_);
+    std::string json = "{\"uploadId\":\"" + id_ + "\",";
+    json += "\"size\":" + std::to_string(size_) + ",";
+    json += "\"received\":" + std::to_string(committed_.total()) + ",";
+    json += "\"ranges\":[";
+    bool first = true;
+    for (const auto& [begin, end] : committed_.ranges()) {
+        if (!first) json += ",";
+        json += "[" + std::to_string(begin) + "," + std::to_string(end) + "]";
+        first = false;
+    }
+    json += "],\"complete\":";
+    json += finalized_ ? "true" : "false";
+    json += "}";
+    return json;
+}
+
+} // namespace blade
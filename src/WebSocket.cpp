@@ -0,0 +1,188 @@
+#include "WebSocket.h"
+#include "Hashing.h"
+
+#include <algorithm>
+
+namespace blade::WebSocket {
+
+namespace {
+
+constexpr std::string_view GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+constexpr char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string base64(const uint8_t* data, const size_t len) {
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3) {
+        const uint32_t n = static_cast<uint32_t>(data[i]) << 16 |
+                           (i + 1 < len ? static_cast<uint32_t>(data[i + 1]) << 8 : 0) |
+                           (i + 2 < len ? data[i + 2] : 0);
+        out += BASE64[n >> 18 & 63];
+        out += BASE64[n >> 12 & 63];
+        out += i + 1 < len ? BASE64[n >> 6 & 63] : '=';
+        out += i + 2 < len ? BASE64[n & 63] : '=';
+    }
+    return out;
+}
+
+bool isBase64Char(const char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '+' || c == '/';
+}
+
+// Well-formed UTF-8 as required for text messages and close reasons (no overlongs or surrogates)
+bool isValidUtf8(const std::string_view text) {
+    const auto* p = reinterpret_cast<const uint8_t*>(text.data());
+    const auto* end = p + text.size();
+    while (p < end) {
+        const uint8_t c = *p++;
+        if (c < 0x80) continue;
+        size_t extra;
+        uint32_t cp;
+        if (c >= 0xC2 && c <= 0xDF)      { extra = 1; cp = c & 0x1F; }
+        else if (c >= 0xE0 && c <= 0xEF) { extra = 2; cp = c & 0x0F; }
+        else if (c >= 0xF0 && c <= 0xF4) { extra = 3; cp = c & 0x07; }
+        else return false;
+        if (static_cast<size_t>(end - p) < extra) return false;
+        for (size_t i = 0; i < extra; ++i) {
+            if ((p[i] & 0xC0) != 0x80) return false;
+            cp = cp << 6 | (p[i] & 0x3F);
+        }
+        p += extra;
+        if ((extra == 2 && cp < 0x800) || (extra == 3 && cp < 0x10000) || cp > 0x10FFFF ||
+            (cp >= 0xD800 && cp <= 0xDFFF)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isControl(const Opcode opcode) {
+    return static_cast<uint8_t>(opcode) >= 0x8;
+}
+
+} // namespace
+
+std::string acceptKey(const std::string_view clientKey) {
+    std::string input(clientKey);
+    input += GUID;
+    const auto digest = Hashing::sha1(input.data(), input.size());
+    return base64(digest.data(), digest.size());
+}
+
+bool isValidKey(const std::string_view clientKey) {
+    // 16 bytes encode to 22 characters and two padding characters
+    return clientKey.size() == 24 && clientKey.ends_with("==") &&
+           std::all_of(clientKey.begin(), clientKey.end() - 2, isBase64Char);
+}
+
+std::string frame(const Opcode opcode, const std::string_view payload) {
+    std::string out;
+    out.reserve(payload.size() + 10);
+    out += static_cast<char>(0x80 | static_cast<uint8_t>(opcode));
+    if (payload.size() < 126) {
+        out += static_cast<char>(payload.size());
+    } else if (payload.size() <= 0xFFFF) {
+        out += static_cast<char>(126);
+        out += static_cast<char>(payload.size() >> 8);
+        out += static_cast<char>(payload.size() & 0xFF);
+    } else {
+        out += static_cast<char>(127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out += static_cast<char>(static_cast<uint64_t>(payload.size()) >> shift & 0xFF);
+        }
+    }
+    out += payload;
+    return out;
+}
+
+std::string closeFrame(const uint16_t code) {
+    const char payload[2] = {static_cast<char>(code >> 8), static_cast<char>(code & 0xFF)};
+    return frame(Opcode::Close, std::string_view(payload, sizeof(payload)));
+}
+
+void FrameParser::feed(const char* data, const size_t len) {
+    // Drop consumed bytes once they make up most of the buffer
+    if (consumed_ > 0 && consumed_ * 2 >= buffer_.size()) {
+        buffer_.erase(0, consumed_);
+        consumed_ = 0;
+    }
+    buffer_.append(data, len);
+}
+
+FrameParser::Status FrameParser::fail(const uint16_t code) {
+    closeCode_ = code;
+    return Status::Error;
+}
+
+FrameParser::Status FrameParser::next(Opcode& opcode, std::string& payload) {
+    while (true) {
+        const auto* p = reinterpret_cast<const uint8_t*>(buffer_.data()) + consumed_;
+        const size_t available = buffer_.size() - consumed_;
+        if (available < 2) return Status::Incomplete;
+
+        const bool fin = (p[0] & 0x80) != 0;
+        const auto frameOpcode = static_cast<Opcode>(p[0] & 0x0F);
+        if ((p[0] & 0x70) != 0) return fail(CloseCode::ProtocolError);  // No extensions were negotiated
+        if ((p[1] & 0x80) == 0) return fail(CloseCode::ProtocolError);  // Client frames must be masked
+        switch (frameOpcode) {
+        case Opcode::Continuation: case Opcode::Text: case Opcode::Binary:
+        case Opcode::Close: case Opcode::Ping: case Opcode::Pong:
+            break;
+        default:
+            return fail(CloseCode::ProtocolError);
+        }
+
+        uint64_t length = p[1] & 0x7F;
+        size_t header = 2;
+        if (length == 126) {
+            if (available < 4) return Status::Incomplete;
+            length = static_cast<uint64_t>(p[2]) << 8 | p[3];
+            header = 4;
+        } else if (length == 127) {
+            if (available < 10) return Status::Incomplete;
+            length = 0;
+            for (int i = 0; i < 8; ++i) length = length << 8 | p[2 + i];
+            header = 10;
+        }
+        if (isControl(frameOpcode) && (!fin || length > 125)) return fail(CloseCode::ProtocolError);
+        if (length > MAX_MESSAGE || message_.size() + length > MAX_MESSAGE) return fail(CloseCode::TooBig);
+        if (available < header + 4 + length) return Status::Incomplete;
+
+        const uint8_t* mask = p + header;
+        const uint8_t* data = mask + 4;
+        std::string unmasked(static_cast<size_t>(length), '\0');
+        for (size_t i = 0; i < unmasked.size(); ++i) unmasked[i] = static_cast<char>(data[i] ^ mask[i & 3]);
+        consumed_ += header + 4 + static_cast<size_t>(length);
+
+        if (isControl(frameOpcode)) {
+            // Control frames may arrive between the fragments of a message
+            if (frameOpcode == Opcode::Close &&
+                (unmasked.size() == 1 || (unmasked.size() > 2 && !isValidUtf8(std::string_view(unmasked).substr(2))))) {
+                return fail(CloseCode::ProtocolError);
+            }
+            opcode = frameOpcode;
+            payload = std::move(unmasked);
+            return Status::Message;
+        }
+
+        if (frameOpcode == Opcode::Continuation) {
+            if (!inMessage_) return fail(CloseCode::ProtocolError);
+        } else {
+            if (inMessage_) return fail(CloseCode::ProtocolError);
+            inMessage_ = true;
+            messageOpcode_ = frameOpcode;
+            message_.clear();
+        }
+        message_ += unmasked;
+        if (!fin) continue;
+
+        inMessage_ = false;
+        if (messageOpcode_ == Opcode::Text && !isValidUtf8(message_)) return fail(CloseCode::InvalidData);
+        opcode = messageOpcode_;
+        payload = std::move(message_);
+        message_.clear();
+        return Status::Message;
+    }
+}
+
+} // namespace blade::WebSocket
@@ -0,0 +1,244 @@
+#include "ZipWriter.h"
+#include "DeflateEncoder.h"
+#include "Hashing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+namespace blade {
+
+namespace {
+
+constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr uint32_t DESCRIPTOR_SIGNATURE = 0x08074b50;
+constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+constexpr uint32_t END_SIGNATURE = 0x06054b50;
+
+constexpr uint16_t ZIP64_EXTRA_ID = 0x0001;
+constexpr uint16_t VERSION_DEFAULT = 20;  // 2.0: deflate, data descriptors
+constexpr uint16_t VERSION_ZIP64 = 45;    // 4.5: ZIP64 records
+constexpr uint16_t FLAG_DESCRIPTOR = 0x0008;
+constexpr uint16_t FLAG_UTF8 = 0x0800;
+
+constexpr uint64_t MAX16 = 0xFFFF;
+constexpr uint64_t MAX32 = 0xFFFFFFFF;
+// Entries from this size on get ZIP64 records; the margin covers deflate expanding incompressible data
+constexpr uint64_t ZIP64_THRESHOLD = 0xFFF00000;
+
+constexpr size_t LOCAL_HEADER_SIZE = 30;
+constexpr size_t ZIP64_LOCAL_EXTRA_SIZE = 20;  // Tag, length, both sizes (zero; the descriptor has them)
+constexpr size_t DESCRIPTOR_SIZE = 16;
+constexpr size_t ZIP64_DESCRIPTOR_SIZE = 24;
+constexpr size_t CENTRAL_HEADER_SIZE = 46;
+constexpr size_t ZIP64_END_SIZE = 56;
+constexpr size_t ZIP64_LOCATOR_SIZE = 20;
+constexpr size_t END_SIZE = 22;
+
+void put16(std::string& out, const uint16_t value) {
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>(value >> 8);
+}
+
+void put32(std::string& out, const uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) out += static_cast<char>(value >> shift & 0xFF);
+}
+
+void put64(std::string& out, const uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) out += static_cast<char>(value >> shift & 0xFF);
+}
+
+// Size of the ZIP64 extra field of a central directory header: only the fields
+// whose 32-bit slot overflowed, in the order uncompressed size, compressed size, offset
+size_t centralExtraSize(const bool zip64, const uint64_t headerOffset) {
+    const size_t fields = (zip64 ? 2 : 0) + (headerOffset >= MAX32 ? 1 : 0);
+    return fields == 0 ? 0 : 4 + 8 * fields;
+}
+
+bool needsZip64End(const uint64_t entries, const uint64_t directoryOffset, const uint64_t directorySize) {
+    return entries >= MAX16 || directoryOffset >= MAX32 || directorySize >= MAX32;
+}
+
+// MS-DOS date and time in local time, as ZIP headers store them (two-second resolution, 1980-2107)
+void toDosTime(const std::filesystem::file_time_type modified, uint16_t& dosTime, uint16_t& dosDate) {
+    const std::time_t t = std::chrono::system_clock::to_time_t(
+        std::chrono::time_point_cast<std::chrono::system_clock::duration>(std::chrono::file_clock::to_sys(modified)));
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    if (tm.tm_year < 80) {
+        dosTime = 0;
+        dosDate = 1 << 5 | 1;  // 1980-01-01
+        return;
+    }
+    dosTime = static_cast<uint16_t>(tm.tm_hour << 11 | tm.tm_min << 5 | tm.tm_sec / 2);
+    dosDate = static_cast<uint16_t>(std::min(tm.tm_year - 80, 127) << 9 | (tm.tm_mon + 1) << 5 | tm.tm_mday);
+}
+
+} // namespace
+
+ZipWriter::ZipWriter() = default;
+
+ZipWriter::~ZipWriter() = default;
+
+void ZipWriter::beginEntry(const std::string_view name, const std::filesystem::file_time_type modified,
+                           const uint64_t size, const Method method, std::string& out) {
+    name_.assign(name);
+    zip64_ = size >= ZIP64_THRESHOLD;
+    headerOffset_ = offset_;
+    bytesIn_ = 0;
+    bytesCompressed_ = 0;
+    crc_ = 0;
+    flags_ = FLAG_DESCRIPTOR | FLAG_UTF8;
+    method_ = static_cast<uint16_t>(method);
+    toDosTime(modified, dosTime_, dosDate_);
+    deflate_ = method == Method::Deflate ? std::make_unique<DeflateEncoder>(DeflateEncoder::Format::Raw) : nullptr;
+
+    const size_t start = out.size();
+    put32(out, LOCAL_HEADER_SIGNATURE);
+    put16(out, zip64_ ? VERSION_ZIP64 : VERSION_DEFAULT);
+    put16(out, flags_);
+    put16(out, method_);
+    put16(out, dosTime_);
+    put16(out, dosDate_);
+    put32(out, 0);  // CRC-32 and sizes follow the data
+    put32(out, zip64_ ? static_cast<uint32_t>(MAX32) : 0);
+    put32(out, zip64_ ? static_cast<uint32_t>(MAX32) : 0);
+    put16(out, static_cast<uint16_t>(name_.size()));
+    put16(out, zip64_ ? static_cast<uint16_t>(ZIP64_LOCAL_EXTRA_SIZE) : 0);
+    out += name_;
+    if (zip64_) {
+        // Present so readers expect 8-byte sizes in the data descriptor
+        put16(out, ZIP64_EXTRA_ID);
+        put16(out, 16);
+        put64(out, 0);
+        put64(out, 0);
+    }
+    offset_ += out.size() - start;
+}
+
+void ZipWriter::write(const uint8_t* data, const size_t len, std::string& out) {
+    bytesIn_ += len;
+    crc_ = Hashing::crc32(data, len, crc_);
+    if (deflate_) {
+        const size_t start = out.size();
+        deflate_->write(data, len, out);
+        bytesCompressed_ += out.size() - start;
+        offset_ += out.size() - start;
+        return;
+    }
+    out.append(reinterpret_cast<const char*>(data), len);
+    bytesCompressed_ += len;
+    offset_ += len;
+}
+
+uint64_t ZipWriter::endEntry(std::string& out) {
+    const size_t start = out.size();
+    if (deflate_) {
+        deflate_->finish(out);
+        bytesCompressed_ += out.size() - start;
+        deflate_.reset();
+    }
+
+    put32(out, DESCRIPTOR_SIGNATURE);
+    put32(out, crc_);
+    if (zip64_) {
+        put64(out, bytesCompressed_);
+        put64(out, bytesIn_);
+    } else {
+        put32(out, static_cast<uint32_t>(bytesCompressed_));
+        put32(out, static_cast<uint32_t>(bytesIn_));
+    }
+    offset_ += out.size() - start;
+
+    const size_t extra = centralExtraSize(zip64_, headerOffset_);
+    std::string& cd = centralDirectory_;
+    put32(cd, CENTRAL_HEADER_SIGNATURE);
+    put16(cd, zip64_ || extra > 0 ? VERSION_ZIP64 : VERSION_DEFAULT);  // Made by (MS-DOS attributes)
+    put16(cd, zip64_ || extra > 0 ? VERSION_ZIP64 : VERSION_DEFAULT);  // Needed to extract
+    put16(cd, flags_);
+    put16(cd, method_);
+    put16(cd, dosTime_);
+    put16(cd, dosDate_);
+    put32(cd, crc_);
+    put32(cd, zip64_ ? static_cast<uint32_t>(MAX32) : static_cast<uint32_t>(bytesCompressed_));
+    put32(cd, zip64_ ? static_cast<uint32_t>(MAX32) : static_cast<uint32_t>(bytesIn_));
+    put16(cd, static_cast<uint16_t>(name_.size()));
+    put16(cd, static_cast<uint16_t>(extra));
+    put16(cd, 0);  // Comment length
+    put16(cd, 0);  // Disk number
+    put16(cd, 0);  // Internal attributes
+    put32(cd, 0);  // External attributes
+    put32(cd, static_cast<uint32_t>(std::min(headerOffset_, MAX32)));
+    cd += name_;
+    if (extra > 0) {
+        put16(cd, ZIP64_EXTRA_ID);
+        put16(cd, static_cast<uint16_t>(extra - 4));
+        if (zip64_) {
+            put64(cd, bytesIn_);
+            put64(cd, bytesCompressed_);
+        }
+        if (headerOffset_ >= MAX32) put64(cd, headerOffset_);
+    }
+    ++entryCount_;
+    return bytesIn_;
+}
+
+void ZipWriter::finish(std::string& out) {
+    const size_t start = out.size();
+    const uint64_t directoryOffset = offset_;
+    const uint64_t directorySize = centralDirectory_.size();
+    out += centralDirectory_;
+    centralDirectory_.clear();
+    centralDirectory_.shrink_to_fit();
+
+    if (needsZip64End(entryCount_, directoryOffset, directorySize)) {
+        const uint64_t zip64EndOffset = directoryOffset + directorySize;
+        put32(out, ZIP64_END_SIGNATURE);
+        put64(out, ZIP64_END_SIZE - 12);  // Size of the rest of the record
+        put16(out, VERSION_ZIP64);
+        put16(out, VERSION_ZIP64);
+        put32(out, 0);  // This disk
+        put32(out, 0);  // Disk with the central directory
+        put64(out, entryCount_);
+        put64(out, entryCount_);
+        put64(out, directorySize);
+        put64(out, directoryOffset);
+
+        put32(out, ZIP64_LOCATOR_SIGNATURE);
+        put32(out, 0);
+        put64(out, zip64EndOffset);
+        put32(out, 1);  // Total disks
+    }
+
+    put32(out, END_SIGNATURE);
+    put16(out, 0);
+    put16(out, 0);
+    put16(out, static_cast<uint16_t>(std::min(entryCount_, MAX16)));
+    put16(out, static_cast<uint16_t>(std::min(entryCount_, MAX16)));
+    put32(out, static_cast<uint32_t>(std::min(directorySize, MAX32)));
+    put32(out, static_cast<uint32_t>(std::min(directoryOffset, MAX32)));
+    put16(out, 0);  // Comment length
+    offset_ += out.size() - start;
+}
+
+uint64_t ZipWriter::storedSize(const std::span<const EntrySize> entries) {
+    uint64_t offset = 0;
+    uint64_t directorySize = 0;
+    for (const auto& entry : entries) {
+        const bool zip64 = entry.size >= ZIP64_THRESHOLD;
+        directorySize += CENTRAL_HEADER_SIZE + entry.nameLength + centralExtraSize(zip64, offset);
+        offset += LOCAL_HEADER_SIZE + entry.nameLength + (zip64 ? ZIP64_LOCAL_EXTRA_SIZE : 0) + entry.size +
+                  (zip64 ? ZIP64_DESCRIPTOR_SIZE : DESCRIPTOR_SIZE);
+    }
+    uint64_t size = offset + directorySize + END_SIZE;
+    if (needsZip64End(entries.size(), offset, directorySize)) size += ZIP64_END_SIZE + ZIP64_LOCATOR_SIZE;
+    return size;
+}
+
+} // namespace blade